@@ -1,5 +1,7 @@
 #include "cli.h"
 
+#include <algorithm>
+
 namespace ServerControlPanel
 {
 
@@ -49,9 +51,21 @@ namespace ServerControlPanel
         parser.addOption(stopOption);
 
         // --restart
-        QCommandLineOption restartOption("stop", "Restarts a server.", "[server/s]");
+        QCommandLineOption restartOption("restart", "Restarts a server.", "[server/s]");
         parser.addOption(restartOption);
 
+        // --status
+        QCommandLineOption statusOption("status", "Shows the resource usage of the servers.");
+        parser.addOption(statusOption);
+
+        // --accesslog
+        QCommandLineOption accessLogOption("accesslog", "Shows the request statistics of the nginx access logs.");
+        parser.addOption(accessLogOption);
+
+        // --errorlogs
+        QCommandLineOption errorLogsOption("errorlogs", "Shows the entries of the server error logs, grouped.");
+        parser.addOption(errorLogsOption);
+
         /**
    * Handling of Command Line Arguments
    */
@@ -110,17 +124,7 @@ namespace ServerControlPanel
                                   .arg(command.toLocal8Bit().constData()));
             }
 
-            QString methodName = command + servers->getCamelCasedServerName(server);
-
-            if (QMetaObject::invokeMethod(servers,
-                                          methodName.toLocal8Bit().constData())) {
-                exit(0);
-            }
-
-            printHelpText(
-                QString("Command not handled, yet! (server = %1) (command = %2) \n")
-                    .arg(server.toLocal8Bit().constData(),
-                         command.toLocal8Bit().constData()));
+            execServerCommand(servers, command, server);
             exit(0);
         }
 
@@ -136,7 +140,22 @@ namespace ServerControlPanel
 
         // --restart <servers>
         if (parser.isSet(restartOption)) {
-            execServers("stop", restartOption, args, parser);
+            execServers("restart", restartOption, args, parser);
+        }
+
+        // --status
+        if (parser.isSet(statusOption)) {
+            printServerStatus();
+        }
+
+        // --accesslog
+        if (parser.isSet(accessLogOption)) {
+            printAccessLogStats();
+        }
+
+        // --errorlogs
+        if (parser.isSet(errorLogsOption)) {
+            printErrorLogSummary();
         }
 
         // if(parser.unknownOptionNames().count() > 1) {
@@ -179,14 +198,175 @@ namespace ServerControlPanel
                                   .arg(server.toLocal8Bit().constData()));
             }
 
-            QString methodName = command + servers->getCamelCasedServerName(server);
+            execServerCommand(servers, command, server);
+        }
+
+        exit(0);
+    }
+
+    /**
+ * @brief execServerCommand - executes "command" on a single Server
+ * @param servers
+ * @param command "start", "stop", "restart"
+ * @param server the lowercase server name
+ */
+    void CLI::execServerCommand(Servers::Servers *servers, const QString &command, const QString &server)
+    {
+        Servers::ServerId id = Servers::findDescriptor(server)->id;
+
+        // the stop commands return immediately, the exit is waited for here
+        QList<qint64> pids;
+        foreach (const QString &processName, servers->getProcessNames(server)) {
+            foreach (const Process &p, Processes::snapshot().findAllByName(processName)) {
+                pids << p.pid;
+            }
+        }
+
+        if (command == "stop" || command == "restart") {
+            servers->runStopCommand(id);
+
+            // there is no event loop: processes still running are killed here
+            QList<qint64> stillRunning;
+            if (!Processes::waitForExit(pids, 15000, &stillRunning)) {
+                foreach (qint64 pid, stillRunning) {
+                    Processes::signalProcess(pid, true);
+                }
+                Processes::waitForExit(stillRunning, 2000);
+            }
+        }
+        if (id == Servers::ServerId::PostgreSQL && (command == "stop" || command == "restart")) {
+            servers->cleanupPostgreSQL();
+        }
+        if (command == "start" || command == "restart") {
+            servers->runStartCommand(id);
+        }
+    }
+
+    /**
+ * @brief printServerStatus - prints the resource usage of all installed servers
+ */
+    void CLI::printServerStatus()
+    {
+        Servers::Servers *servers = new Servers::Servers();
+
+        // the CPU usage is the difference of two samples
+        QEventLoop loop;
+        int samples = 0;
+        QObject::connect(servers->resourceSampler, &ResourceSampler::sampled, &loop, [&]() {
+            if (++samples == 2) {
+                loop.quit();
+            }
+        });
+        QTimer::singleShot(3000, &loop, SLOT(quit()));
+
+        servers->resourceSampler->setIntervals(500, 500);
+        servers->resourceSampler->start();
+        loop.exec();
+        servers->resourceSampler->stop();
 
-            QMetaObject::invokeMethod(servers, methodName.toLocal8Bit().constData());
+        QMap<QString, Servers::ServerUsage> usages = servers->getServersUsage();
+
+        for (QMap<QString, Servers::ServerUsage>::const_iterator it = usages.constBegin();
+             it != usages.constEnd(); ++it) {
+            colorPrint(QString("%1").arg(it.key(), -12), "brightwhite");
+            colorPrint(it.value().toString() + "\n", it.value().processCount ? "lightgreen" : "gray");
         }
 
         exit(0);
     }
 
+    /**
+ * @brief printAccessLogStats - parses the nginx access logs and prints the request statistics and the top URLs and clients
+ */
+    void CLI::printAccessLogStats()
+    {
+        Servers::Servers *servers = new Servers::Servers();
+
+        // parsed right here, there is nothing else to do
+        AccessLogScanner scanner(servers->accessLog->fileNames(), servers->accessLog->format());
+        scanner.scan();
+
+        const AccessLogStats &stats = scanner.stats();
+
+        colorPrint(QString("%1").arg("Log", -14), "brightwhite");
+        colorPrint(servers->accessLog->fileNames().join(", ") + "\n");
+        colorPrint(QString("%1").arg("Requests", -14), "brightwhite");
+        colorPrint(QString::number(stats.requests) + "\n");
+        colorPrint(QString("%1").arg("Bytes", -14), "brightwhite");
+        colorPrint(QString::number(stats.bytes) + "\n");
+        colorPrint(QString("%1").arg("Unparsed", -14), "brightwhite");
+        colorPrint(QString::number(stats.malformed) + "\n");
+
+        if (stats.timedRequests > 0) {
+            colorPrint(QString("%1").arg("Request time", -14), "brightwhite");
+            colorPrint(QString("p50 %1 ms, p95 %2 ms, p99 %3 ms\n")
+                           .arg(stats.percentile(50))
+                           .arg(stats.percentile(95))
+                           .arg(stats.percentile(99)));
+        }
+
+        foreach (int status, stats.statusCodes()) {
+            colorPrint(QString("%1").arg(status, -14), "brightwhite");
+            QString color = status >= 500 ? "red" : (status >= 400 ? "yellow" : "lightgreen");
+            colorPrint(QString::number(stats.statusCount(status)) + "\n", color);
+        }
+
+        HeavyHittersReport report = scanner.heavyHitters();
+
+        colorPrint(QString("%1").arg("Visitors", -14), "brightwhite");
+        colorPrint(QString("~%1\n").arg(report.uniqueVisitors));
+
+        printHeavyHitters("Top URLs", report.urlsByCount, "requests");
+        printHeavyHitters("Slowest URLs", report.urlsByTime, "ms total");
+        printHeavyHitters("Top clients", report.clientIps, "requests");
+        printHeavyHitters("Top user agents", report.userAgents, "requests");
+
+        exit(0);
+    }
+
+    void CLI::printHeavyHitters(const QString &title, const QList<HeavyHitter> &hitters, const QString &unit)
+    {
+        colorPrint("\n" + title + "\n", "green");
+
+        foreach (const HeavyHitter &hitter, hitters.mid(0, 10)) {
+            colorPrint(QString("%1 %2\n").arg(QString::number(hitter.count) + " " + unit, -24).arg(QString(hitter.key)));
+        }
+    }
+
+    /**
+ * @brief printErrorLogSummary - reads the server error logs and prints the groups of entries, the most frequent first
+ */
+    void CLI::printErrorLogSummary()
+    {
+        Servers::Servers *servers = new Servers::Servers();
+
+        // the whole logs, read right here
+        ErrorLogScanner scanner(-1, 10000);
+        QStringList fileNames = servers->errorLogs->fileNames();
+        QStringList serverNames = servers->errorLogs->serverNames();
+        for (int i = 0; i < fileNames.size(); ++i) {
+            scanner.addLog(serverNames.at(i), fileNames.at(i));
+        }
+        scanner.scan();
+
+        QList<ErrorLogGroup> groups = scanner.groups().values();
+        std::sort(groups.begin(), groups.end(),
+                  [](const ErrorLogGroup &a, const ErrorLogGroup &b) { return a.count > b.count; });
+
+        foreach (const ErrorLogGroup &group, groups.mid(0, 50)) {
+            colorPrint(QString("%1").arg(group.serverName, -10), "brightwhite");
+            colorPrint(QString("%1").arg(group.count, -10), group.count > 1 ? "yellow" : "gray");
+            colorPrint(QString("%1 - %2\n")
+                           .arg(group.firstSeen.toString("yyyy-MM-dd hh:mm:ss"))
+                           .arg(group.lastSeen.toString("yyyy-MM-dd hh:mm:ss")));
+            colorPrint("          " + QString::fromUtf8(group.pattern) + "\n");
+        }
+
+        colorPrint(QString("\n%1 groups\n").arg(groups.size()), "green");
+
+        exit(0);
+    }
+
     void CLI::printHelpText(QString errorMessage)
     {
         colorPrint("WPN-XM Server Stack " APP_VERSION "\n", "brightwhite");
@@ -212,7 +392,10 @@ namespace ServerControlPanel
             "      --start <servers>                Starts one or more <servers>. \n"
             "      --stop <servers>                 Stops one or more <servers>. \n"
             "      --restart <servers>              Restarts one or more <servers>. "
-            "\n\n";
+            "\n"
+            "      --status                         Shows the resource usage of the servers. \n"
+            "      --accesslog                      Shows the request statistics of the nginx access logs. \n"
+            "      --errorlogs                      Shows the entries of the server error logs, grouped. \n\n";
         colorPrint(options);
 
         colorPrint("Arguments: \n", "green");
@@ -8,6 +8,7 @@
 #include <QCommandLineOption>
 #include <QCommandLineParser>
 #include <QDate>
+#include <QEventLoop>
 
 namespace ServerControlPanel
 {
@@ -17,6 +18,11 @@ namespace ServerControlPanel
         void handleCommandLineArguments();
         void printHelpText(QString errorMessage = QString());
         void execServers(const QString &command, QCommandLineOption &clioption, QStringList args, QCommandLineParser &parser);
+        void execServerCommand(Servers::Servers *servers, const QString &command, const QString &server);
+        void printServerStatus();
+        void printAccessLogStats();
+        void printHeavyHitters(const QString &title, const QList<HeavyHitter> &hitters, const QString &unit);
+        void printErrorLogSummary();
         void colorTest();
         void colorPrint(QString msg, QString colorName = "gray");
     };
@@ -8,8 +8,17 @@
 
 namespace Configuration
 {
+    namespace
+    {
+        QByteArray readFile(const QString &fileName)
+        {
+            QFile file(fileName);
+            return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+        }
+    }
+
     ConfigurationDialog::ConfigurationDialog(QWidget *parent)
-        : QDialog(parent), ui(new Ui::ConfigurationDialog)
+        : QDialog(parent), ui(new Ui::ConfigurationDialog), servers(0)
     {
         ui->setupUi(this);
 
@@ -398,6 +407,11 @@ namespace Configuration
    */
         saveSettings_Redis_Configuration();
 
+        /**
+   * Tab "Configuration" > Page "Xdebug"
+   */
+        saveSettings_Xdebug_Configuration();
+
         /**
    *Tab "Configuration" > Page "MongoDB"
    */
@@ -483,8 +497,11 @@ namespace Configuration
         QString file = settings->get("php/config").toString();
         if (!QFile(file).exists()) {
             qDebug() << "[Error]" << file << "not found";
+            return;
         }
 
+        QByteArray before = readFile(file);
+
         File::INI *ini = new File::INI(file.toLatin1());
 
         // remote
@@ -510,6 +527,12 @@ namespace Configuration
                             ui->lineEdit_xdebug_idekey->text().toLatin1());
 
         ini->writeConfigFile();
+
+        // PHP reads php.ini at startup only: a running PHP is restarted,
+        // with a rolling restart, while nginx uses the pools
+        if (servers && servers->isServerRunning("PHP") && readFile(file) != before) {
+            servers->restartServer("PHP");
+        }
     }
 
     void ConfigurationDialog::saveSettings_MariaDB_Configuration()
@@ -573,91 +596,7 @@ namespace Configuration
         File::JSON::save(jsonDoc, "./bin/wpnxm-scp/nginx-upstreams.json");
 
         // update Nginx upstream config files
-        writeNginxUpstreamConfigs(jsonDoc);
-    }
-
-    void ConfigurationDialog::writeNginxUpstreamConfigs(QJsonDocument jsonDoc)
-    {
-        createNginxConfUpstreamFolderIfNotExists_And_clearOldConfigs();
-
-        // build servers string by iterating over all pools
-
-        QJsonObject json = jsonDoc.object();
-        QJsonObject jsonPools = json["pools"].toObject();
-
-        // iterate over 1..n pools (key)
-        for (QJsonObject::Iterator iter = jsonPools.begin(); iter != jsonPools.end();
-             ++iter) {
-            // the "value" object has the key/value pairs of a pool
-            QJsonObject jsonPool = iter.value().toObject();
-
-            QString poolName = jsonPool["name"].toString();
-            QString method = jsonPool["method"].toString();
-            QJsonObject jsonServers = jsonPool["servers"].toObject();
-
-            // build "servers" block for later insertion into the upstream template
-            // string
-            QString servers;
-
-            // iterate over all servers
-            for (int i = 0; i < jsonServers.count(); ++i) {
-                // get values for this server
-                QJsonObject s = jsonServers.value(QString::number(i)).toObject();
-
-                // use values to build server string
-                QString server =
-                    QString("    server %1:%2 weight=%3 max_fails=%4 fail_timeout=%5;\n")
-                        .arg(s["address"].toString(), s["port"].toString(),
-                             s["weight"].toString(), s["maxfails"].toString(),
-                             s["failtimeout"].toString());
-
-                servers.append(server);
-            }
-
-            // upstream template string
-            QString upstream(
-                "#\n"
-                "# Automatically generated Nginx Upstream definition.\n"
-                "# Do not edit manually!\n"
-                "\n"
-                "upstream " +
-                poolName +
-                " {\n"
-                "    " +
-                method +
-                ";\n"
-                "\n" +
-                servers + "}\n");
-
-            QString filename("./bin/nginx/conf/upstreams/" + poolName + ".conf");
-
-            QFile file(filename);
-            if (file.open(QIODevice::ReadWrite | QFile::Truncate)) {
-                QTextStream stream(&file);
-                stream << upstream << endl;
-            }
-            file.close();
-
-            qDebug() << "[Nginx Upstream Config] Saved: " << filename;
-        }
-    }
-
-    void ConfigurationDialog::
-        createNginxConfUpstreamFolderIfNotExists_And_clearOldConfigs()
-    {
-        QDir dir("./bin/nginx/conf/upstreams");
-
-        // create Nginx Conf Upstream Folder If Not Exists
-        if (!dir.exists()) {
-            dir.mkpath(".");
-        }
-
-        // delete old upstream configs
-        dir.setNameFilters(QStringList() << "*.conf");
-        dir.setFilter(QDir::Files);
-        foreach (QString dirFile, dir.entryList()) {
-            dir.remove(dirFile);
-        }
+        Servers::Servers::writeNginxUpstreamConfigs(jsonDoc);
     }
 
     QJsonValue ConfigurationDialog::serialize_toJSON_Nginx_Upstream_PoolsTable(
@@ -62,12 +62,9 @@ namespace Configuration
         QJsonValue serialize_toJSON_Nginx_Upstream_ServerTable(QTableWidget *servers);
         QJsonValue serialize_toJSON_Nginx_Upstream_PoolsTable(QTableWidget *pools);
 
-        void writeNginxUpstreamConfigs(QJsonDocument jsonDoc);
         QJsonObject getNginxUpstreamPoolByName(QString requestedUpstreamPoolName);
         void updateServersTable(QJsonObject jsonPool);
 
-        void createNginxConfUpstreamFolderIfNotExists_And_clearOldConfigs();
-
     private slots:
         void toggleAutostartServerCheckboxes(bool run = true);
         void onClickedButtonBoxOk();
@@ -0,0 +1,385 @@
+#include "fastcgipool.h"
+#include "src/processviewer/processes.h"
+#include "src/processviewer/processmonitor.h"
+#include "src/processviewer/processwaiter.h"
+
+#include <QDebug>
+#include <QProcessEnvironment>
+
+namespace Servers
+{
+    namespace
+    {
+        // a worker exiting sooner is considered a crash at startup
+        const int rapidExitMs = 1000;
+        const int maximumRespawnDelay = 5000;
+    }
+
+    QString FastCgiPoolConfig::toString() const { return address + ":" + QString::number(port); }
+
+    FastCgiPool::FastCgiPool(const FastCgiPoolConfig &config, ProcessMonitor *processMonitor, QObject *parent)
+        : QObject(parent), cfg(config), processMonitor(processMonitor), listenSocket(-1), stopping(false),
+          respawnDelay(0), lowLoadSince(-1), peakBusy(0)
+    {
+        uptime.start();
+
+        respawnTimer.setSingleShot(true);
+        connect(&respawnTimer, SIGNAL(timeout()), this, SLOT(respawn()));
+        connect(&memoryTimer, SIGNAL(timeout()), this, SLOT(checkMemory()));
+        connect(&scaleTimer, SIGNAL(timeout()), this, SLOT(checkLoad()));
+
+        connect(processMonitor, SIGNAL(processExited(qint64, int)), this, SLOT(processExited(qint64, int)));
+    }
+
+    /**
+     * The workers outlive the control panel, like all servers do. They keep
+     * serving on their copies of the listen socket, but are not respawned.
+     */
+    FastCgiPool::~FastCgiPool()
+    {
+        foreach (qint64 pid, workerPids() + retiring.toList()) {
+            releaseWorker(pid);
+        }
+
+        closeListenSocket(listenSocket);
+    }
+
+    /**
+     * Binds the listen socket and starts the workers.
+     */
+    bool FastCgiPool::start(QString *error)
+    {
+        if (isRunning()) {
+            return true;
+        }
+
+        QString reason;
+        listenSocket = openListenSocket(cfg.address, &cfg.port, cfg.backlog, &reason);
+
+        if (listenSocket == -1) {
+            qDebug() << "[PHP] Pool" << cfg.toString() << "failed to listen:" << reason;
+            if (error) {
+                *error = reason;
+            }
+            return false;
+        }
+
+        if (isAdaptive()) {
+            cfg.workers = qBound(cfg.minWorkers, cfg.workers, cfg.maxWorkers);
+        }
+
+        qDebug() << "[PHP] Pool" << cfg.toString() << "listening, starting" << cfg.workers << "workers";
+
+        stopping = false;
+        respawnDelay = 0;
+        respawn();
+
+        if (cfg.maxMemoryBytes > 0) {
+            memoryTimer.start(cfg.memoryCheckInterval);
+        }
+
+        if (isAdaptive()) {
+            lowLoadSince = -1;
+            scaleTimer.start(cfg.scaleInterval);
+        }
+
+        return true;
+    }
+
+    /**
+     * Asks all workers to finish their current request and exit, without
+     * waiting. Workers still running after "stopTimeout" ms are killed.
+     * The pool is stopped, when stop() returns, and might be deleted.
+     */
+    void FastCgiPool::stop()
+    {
+        if (!isRunning()) {
+            return;
+        }
+
+        QList<qint64> pids = shutdown();
+        release();
+
+        killLater(pids, cfg.stopTimeout);
+    }
+
+    /**
+     * Asks all workers to finish their current request and exit, without
+     * waiting. Returns their pids. No worker is respawned from now on.
+     */
+    QList<qint64> FastCgiPool::shutdown()
+    {
+        stopping = true;
+        respawnTimer.stop();
+        memoryTimer.stop();
+        scaleTimer.stop();
+
+        QList<qint64> pids = workerPids() + retiring.toList();
+
+        foreach (qint64 pid, pids) {
+            shutdownWorker(pid);
+        }
+
+        return pids;
+    }
+
+    /**
+     * Releases the workers and closes the listen socket. The workers keep
+     * their copies of the socket until they exit.
+     */
+    void FastCgiPool::release()
+    {
+        if (!isRunning()) {
+            return;
+        }
+
+        foreach (qint64 pid, workerPids() + retiring.toList()) {
+            releaseWorker(pid);
+        }
+
+        workers.clear();
+        retiring.clear();
+        startedAt.clear();
+
+        closeListenSocket(listenSocket);
+        listenSocket = -1;
+
+        qDebug() << "[PHP] Pool" << cfg.toString() << "stopped";
+    }
+
+    bool FastCgiPool::isRunning() const { return listenSocket != -1; }
+
+    FastCgiPoolConfig FastCgiPool::config() const { return cfg; }
+
+    QList<qint64> FastCgiPool::workerPids() const { return workers.toList(); }
+
+    int FastCgiPool::workerCount() const { return workers.size(); }
+
+    /**
+     * Grows or shrinks the pool. Surplus workers finish their current
+     * request before they exit.
+     */
+    void FastCgiPool::setWorkerCount(int count)
+    {
+        cfg.workers = isAdaptive() ? qBound(cfg.minWorkers, count, cfg.maxWorkers) : qMax(count, 1);
+
+        if (!isRunning() || stopping) {
+            return;
+        }
+
+        QList<qint64> pids = workerPids();
+        for (int i = pids.size() - 1; i >= cfg.workers; --i) {
+            retire(pids.at(i));
+        }
+
+        respawn();
+    }
+
+    bool FastCgiPool::isAdaptive() const { return cfg.maxWorkers > cfg.minWorkers; }
+
+    void FastCgiPool::processExited(qint64 pid, int exitCode)
+    {
+        if (retiring.remove(pid)) {
+            startedAt.remove(pid);
+            releaseWorker(pid);
+            emit workerExited(pid, exitCode);
+            return;
+        }
+
+        if (!workers.remove(pid)) {
+            return;
+        }
+
+        qint64 lifetime = uptime.elapsed() - startedAt.take(pid);
+        releaseWorker(pid);
+
+        emit workerExited(pid, exitCode);
+
+        if (!isRunning() || stopping) {
+            return;
+        }
+
+        // a request budget exit is regular, a crash right after the start
+        // (e.g. a broken php.ini) backs off
+        if (lifetime < rapidExitMs) {
+            respawnDelay = qBound(100, respawnDelay * 2, maximumRespawnDelay);
+            qDebug() << "[PHP] Worker" << pid << "exited after" << lifetime << "ms with code" << exitCode
+                     << "- respawning in" << respawnDelay << "ms";
+        } else {
+            respawnDelay = 0;
+        }
+
+        if (!respawnTimer.isActive()) {
+            respawnTimer.start(respawnDelay);
+        }
+    }
+
+    /**
+     * Starts workers until the pool is complete.
+     */
+    void FastCgiPool::respawn()
+    {
+        QList<qint64> spawned;
+
+        while (isRunning() && !stopping && workers.size() < cfg.workers) {
+            qint64 pid = spawn();
+            if (pid <= 0) {
+                respawnDelay = qBound(100, respawnDelay * 2, maximumRespawnDelay);
+                respawnTimer.start(respawnDelay);
+                break;
+            }
+            spawned << pid;
+        }
+
+        if (spawned.isEmpty()) {
+            return;
+        }
+
+        // the monitor watches the new workers, their exits are reported immediately
+        processMonitor->poll();
+
+        // a worker, which is already gone, is never reported
+        foreach (qint64 pid, spawned) {
+            if (processMonitor->exeOf(pid).isEmpty()) {
+                processExited(pid, -1);
+            }
+        }
+    }
+
+    /**
+     * Recycles workers, which exceed the memory budget.
+     */
+    void FastCgiPool::checkMemory()
+    {
+        foreach (qint64 pid, workerPids()) {
+            ResourceCounters counters;
+            if (!Processes::getResourceCounters(pid, counters) || counters.rssBytes <= cfg.maxMemoryBytes) {
+                continue;
+            }
+
+            qDebug() << "[PHP] Recycling worker" << pid << "using" << counters.rssBytes / (1024 * 1024) << "MB";
+
+            // the replacement accepts connections, before the worker leaves
+            retire(pid);
+            respawn();
+        }
+    }
+
+    /**
+     * Scales the pool by the load of the listener.
+     *
+     * Each connection occupies one worker, connections beyond the workers
+     * wait in the accept queue. Growing is immediate, shrinking needs a low
+     * load for "scaleDownDelay" ms (hysteresis) and keeps room for the peak
+     * of that period.
+     */
+    void FastCgiPool::checkLoad()
+    {
+        ListenerLoad load;
+        if (!Processes::getListenerLoad(cfg.port, load)) {
+            return;
+        }
+
+        int current = cfg.workers;
+        int busy = qMin(int(load.connections), current);
+        int queued = qMax(int(load.queued), int(load.connections) - current);
+
+        if (queued > 0 || busy >= current) {
+            lowLoadSince = -1;
+
+            int target = qMin(cfg.maxWorkers, qMax(current + 1, busy + queued));
+            if (target > current) {
+                qDebug() << "[PHP] Pool" << cfg.toString() << "busy" << busy << "queued" << queued << "- growing to"
+                         << target << "workers";
+                setWorkerCount(target);
+            }
+            return;
+        }
+
+        if (busy * 2 >= current || current <= cfg.minWorkers) {
+            lowLoadSince = -1;
+            return;
+        }
+
+        if (lowLoadSince == -1) {
+            lowLoadSince = uptime.elapsed();
+            peakBusy = busy;
+            return;
+        }
+
+        peakBusy = qMax(peakBusy, busy);
+
+        if (uptime.elapsed() - lowLoadSince < cfg.scaleDownDelay) {
+            return;
+        }
+
+        lowLoadSince = -1;
+
+        int target = qMax(cfg.minWorkers, qMax(peakBusy + 1, current / 2));
+        if (target < current) {
+            qDebug() << "[PHP] Pool" << cfg.toString() << "peak" << peakBusy << "busy - shrinking to" << target
+                     << "workers";
+            setWorkerCount(target);
+        }
+    }
+
+    qint64 FastCgiPool::spawn()
+    {
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        // a single process per worker, the pool does the forking
+        env.insert("PHP_FCGI_CHILDREN", "0");
+        env.insert("PHP_FCGI_MAX_REQUESTS", QString::number(cfg.maxRequests));
+
+        qint64 pid = spawnWorker(cfg.program, cfg.arguments, env.toStringList(), listenSocket);
+
+        if (pid <= 0) {
+            qDebug() << "[PHP] Pool" << cfg.toString() << "failed to start" << cfg.program;
+            return 0;
+        }
+
+        workers.insert(pid);
+        startedAt.insert(pid, uptime.elapsed());
+
+        // the monitor reaps the worker, also after the pool is gone
+        processMonitor->adopt(pid);
+
+        emit workerStarted(pid);
+
+        return pid;
+    }
+
+    /**
+     * Asks a worker to exit after its current request.
+     * It is killed, if it is still running after "stopTimeout" ms.
+     */
+    void FastCgiPool::retire(qint64 pid)
+    {
+        if (!workers.remove(pid)) {
+            return;
+        }
+
+        retiring.insert(pid);
+        shutdownWorker(pid);
+
+        killLater(QList<qint64>() << pid, cfg.stopTimeout);
+    }
+
+    /**
+     * Kills the workers, which are still running after "timeoutMs" ms.
+     * The wait doesn't belong to the pool, a stopped pool might be deleted.
+     */
+    void FastCgiPool::killLater(const QList<qint64> &pids, int timeoutMs)
+    {
+        ProcessWaiter *waiter = new ProcessWaiter;
+
+        connect(waiter, &ProcessWaiter::finished, [waiter](const QList<qint64> &stillRunning) {
+            foreach (qint64 pid, stillRunning) {
+                qDebug() << "[PHP] Worker" << pid << "did not exit in time, killing it";
+                Processes::signalProcess(pid, true);
+            }
+            waiter->deleteLater();
+        });
+
+        waiter->start(pids, timeoutMs);
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef FASTCGIPOOL_H
+#define FASTCGIPOOL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+class ProcessMonitor;
+
+namespace Servers
+{
+    /// Settings of one PHP pool, see FastCgiPool.
+    struct FastCgiPoolConfig
+    {
+        FastCgiPoolConfig()
+            : port(0), workers(1), minWorkers(1), maxWorkers(0), scaleInterval(1000), scaleDownDelay(10000),
+              backlog(128), maxRequests(0), maxMemoryBytes(0), memoryCheckInterval(5000), stopTimeout(3000)
+        {
+        }
+
+        QString address; // the listen address, "127.0.0.1"
+        quint16 port; // 0 binds a free port, see FastCgiPool::config()
+        QString program; // php-cgi
+        QStringList arguments;
+        int workers;
+        int minWorkers; // adaptive mode, if maxWorkers > minWorkers
+        int maxWorkers;
+        int scaleInterval;
+        int scaleDownDelay; // of a low load, before the pool shrinks
+        int backlog; // of the listen socket
+        int maxRequests; // PHP_FCGI_MAX_REQUESTS of a worker, 0 = unlimited
+        quint64 maxMemoryBytes; // a worker above is recycled, 0 = unlimited
+        int memoryCheckInterval;
+        int stopTimeout; // grace period of a worker to finish its request
+
+        QString toString() const;
+    };
+
+    /// A pool of php-cgi workers sharing one listen socket.
+    /*!
+        The pool binds the listen socket of an upstream server once and
+        preforks the workers with that socket as their stdin
+        (FCGI_LISTENSOCK_FILENO). The kernel hands each connection to one
+        idle worker, no worker binds a port itself.
+
+        A worker, which exits, is respawned (rapid exits are delayed, so a
+        broken php.ini doesn't end in a fork loop). Workers are recycled after
+        "maxRequests" requests (php-cgi exits on its own) or when their memory
+        exceeds "maxMemoryBytes" (the replacement is started first, then the
+        worker is asked to finish its request and exit).
+
+        In adaptive mode the pool scales between "minWorkers" and
+        "maxWorkers" by the load of its listener: requests waiting in the
+        accept queue and busy workers (connections). It grows at once, when
+        requests queue or all workers are busy, and shrinks, when less than
+        half of the workers were busy for "scaleDownDelay" ms.
+
+        The pool replaces the external "spawn.exe" (php-cgi-spawner).
+    */
+    class FastCgiPool : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        FastCgiPool(const FastCgiPoolConfig &config, ProcessMonitor *processMonitor, QObject *parent = 0);
+        ~FastCgiPool();
+
+        bool start(QString *error = 0);
+        void stop();
+
+        // stop() in two steps, so several pools share one grace period
+        QList<qint64> shutdown();
+        void release();
+
+        bool isRunning() const;
+        FastCgiPoolConfig config() const;
+        QList<qint64> workerPids() const;
+        int workerCount() const;
+        void setWorkerCount(int workers);
+        bool isAdaptive() const;
+
+    signals:
+        void workerStarted(qint64 pid);
+        void workerExited(qint64 pid, int exitCode);
+
+    private slots:
+        void processExited(qint64 pid, int exitCode);
+        void respawn();
+        void checkMemory();
+        void checkLoad();
+
+    private:
+        FastCgiPoolConfig cfg;
+        ProcessMonitor *processMonitor;
+
+        qintptr listenSocket; // -1 when stopped
+        bool stopping; // the workers are asked to exit, none is respawned
+        QSet<qint64> workers;
+        QSet<qint64> retiring; // asked to exit, not respawned
+        QHash<qint64, qint64> startedAt; // pid => ms of uptime
+        QElapsedTimer uptime;
+
+        QTimer respawnTimer;
+        QTimer memoryTimer;
+        QTimer scaleTimer;
+        int respawnDelay; // grows on rapid exits
+        qint64 lowLoadSince; // ms of uptime, -1 while the load is high
+        int peakBusy; // since lowLoadSince
+
+        qint64 spawn();
+        void retire(qint64 pid);
+        static void killLater(const QList<qint64> &pids, int timeoutMs);
+
+        // platform backends, fastcgipool_win.cpp and fastcgipool_linux.cpp
+        static qintptr openListenSocket(const QString &address, quint16 *port, int backlog, QString *error);
+        static void closeListenSocket(qintptr socket);
+        static qint64 spawnWorker(const QString &program, const QStringList &arguments,
+                                  const QStringList &environment, qintptr socket);
+        static void shutdownWorker(qint64 pid);
+        static void releaseWorker(qint64 pid);
+    };
+}
+
+#endif // FASTCGIPOOL_H
@@ -0,0 +1,151 @@
+#include "fastcgipool.h"
+
+#include <QHostAddress>
+#include <QVector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Linux backend of the FastCGI pool.
+ *
+ * The listen socket is created close-on-exec, dup2() onto stdin of a worker
+ * clears the flag for that copy only. php-cgi detects the FastCGI mode by
+ * getpeername(0) failing with ENOTCONN and accepts on fd 0.
+ *
+ * The worker is forked and exec'd directly: everything it needs (argv, envp)
+ * is prepared before the fork, the child only calls async-signal-safe
+ * functions. A close-on-exec pipe reports a failed exec to the parent, so
+ * spawnWorker() returns after the worker runs php-cgi (and the process
+ * monitor never sees the forked copy of the control panel).
+ */
+
+namespace Servers
+{
+    qintptr FastCgiPool::openListenSocket(const QString &address, quint16 *port, int backlog, QString *error)
+    {
+        QHostAddress host(address == "localhost" ? QString("127.0.0.1") : address);
+
+        if (host.protocol() != QAbstractSocket::IPv4Protocol) {
+            *error = QString("unsupported address %1").arg(address);
+            return -1;
+        }
+
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            *error = QString::fromLocal8Bit(strerror(errno));
+            return -1;
+        }
+
+        // a pool restarted right after a stop must not wait for TIME_WAIT
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(*port);
+        sa.sin_addr.s_addr = htonl(host.toIPv4Address());
+
+        if (bind(fd, reinterpret_cast<struct sockaddr *>(&sa), sizeof(sa)) < 0 || listen(fd, backlog) < 0) {
+            *error = QString::fromLocal8Bit(strerror(errno));
+            close(fd);
+            return -1;
+        }
+
+        // the port, which was bound for port 0
+        socklen_t length = sizeof(sa);
+        if (getsockname(fd, reinterpret_cast<struct sockaddr *>(&sa), &length) == 0) {
+            *port = ntohs(sa.sin_port);
+        }
+
+        return fd;
+    }
+
+    void FastCgiPool::closeListenSocket(qintptr socket)
+    {
+        if (socket >= 0) {
+            close(int(socket));
+        }
+    }
+
+    qint64 FastCgiPool::spawnWorker(const QString &program, const QStringList &arguments,
+                                    const QStringList &environment, qintptr socket)
+    {
+        QByteArray path = program.toLocal8Bit();
+
+        QList<QByteArray> strings;
+        strings << path;
+        foreach (const QString &argument, arguments) {
+            strings << argument.toLocal8Bit();
+        }
+        int argc = strings.size();
+        foreach (const QString &variable, environment) {
+            strings << variable.toLocal8Bit();
+        }
+
+        QVector<char *> argv, envp;
+        for (int i = 0; i < strings.size(); ++i) {
+            (i < argc ? argv : envp).append(strings[i].data());
+        }
+        argv.append(0);
+        envp.append(0);
+
+        int pipeFds[2];
+        if (pipe2(pipeFds, O_CLOEXEC) < 0) {
+            return -1;
+        }
+
+        pid_t pid = fork();
+
+        if (pid == 0) {
+            // the worker outlives the control panel and its terminal
+            setsid();
+
+            if (dup2(int(socket), STDIN_FILENO) >= 0) {
+                execve(argv[0], argv.data(), envp.data());
+            }
+
+            int err = errno;
+            ssize_t written = write(pipeFds[1], &err, sizeof(err));
+            Q_UNUSED(written);
+            _exit(127);
+        }
+
+        close(pipeFds[1]);
+
+        if (pid < 0) {
+            close(pipeFds[0]);
+            return -1;
+        }
+
+        // EOF: exec succeeded, data: exec failed
+        int err = 0;
+        ssize_t n;
+        do {
+            n = read(pipeFds[0], &err, sizeof(err));
+        } while (n < 0 && errno == EINTR);
+        close(pipeFds[0]);
+
+        if (n > 0) {
+            waitpid(pid, 0, 0);
+            return -1;
+        }
+
+        return pid;
+    }
+
+    /**
+     * php-cgi finishes the current request on SIGTERM in FastCGI mode.
+     */
+    void FastCgiPool::shutdownWorker(qint64 pid) { kill(pid_t(pid), SIGTERM); }
+
+    void FastCgiPool::releaseWorker(qint64 pid) { Q_UNUSED(pid); }
+}
@@ -0,0 +1,191 @@
+#include "fastcgipool.h"
+
+#include <QDir>
+#include <QHash>
+#include <QHostAddress>
+#include <QRegExp>
+
+#include <winsock2.h>
+#include <windows.h>
+
+/*
+ * Windows backend of the FastCGI pool.
+ *
+ * php-cgi runs in FastCGI mode, if its stdin is a socket (GetFileType()
+ * reports FILE_TYPE_PIPE for it) and stdout/stderr are invalid handles. Then
+ * it accepts on the inherited socket. This is what "spawn.exe" does, too.
+ *
+ * A worker is stopped gracefully by signalling the event, whose handle is
+ * passed in the environment variable "_FCGI_SHUTDOWN_EVENT_": php-cgi stops
+ * accepting and exits after the current request.
+ */
+
+namespace
+{
+    // pid => shutdown event of a worker
+    QHash<qint64, HANDLE> shutdownEvents;
+
+    bool initWinsock()
+    {
+        static bool initialized = false;
+        if (!initialized) {
+            WSADATA data;
+            initialized = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }
+        return initialized;
+    }
+
+    QString lastErrorString(DWORD error)
+    {
+        wchar_t *buffer = 0;
+        FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS, 0,
+                       error, 0, reinterpret_cast<LPWSTR>(&buffer), 0, 0);
+        QString message = QString::fromWCharArray(buffer).trimmed();
+        LocalFree(buffer);
+        return message;
+    }
+
+    // CreateProcess() quoting of a single argument
+    QString quoteArgument(const QString &argument)
+    {
+        if (!argument.isEmpty() && !argument.contains(QRegExp("[\\s\"]"))) {
+            return argument;
+        }
+        QString quoted = argument;
+        quoted.replace(QRegExp("(\\\\*)\""), "\\1\\1\\\"");
+        quoted.replace(QRegExp("(\\\\+)$"), "\\1\\1");
+        return "\"" + quoted + "\"";
+    }
+}
+
+namespace Servers
+{
+    qintptr FastCgiPool::openListenSocket(const QString &address, quint16 *port, int backlog, QString *error)
+    {
+        QHostAddress host(address == "localhost" ? QString("127.0.0.1") : address);
+
+        if (host.protocol() != QAbstractSocket::IPv4Protocol) {
+            *error = QString("unsupported address %1").arg(address);
+            return -1;
+        }
+
+        if (!initWinsock()) {
+            *error = "WSAStartup failed";
+            return -1;
+        }
+
+        // not overlapped: php-cgi uses blocking accept()
+        SOCKET s = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, 0, 0, 0);
+        if (s == INVALID_SOCKET) {
+            *error = lastErrorString(WSAGetLastError());
+            return -1;
+        }
+
+        // no second pool on the same port
+        BOOL on = TRUE;
+        setsockopt(s, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, reinterpret_cast<const char *>(&on), sizeof(on));
+
+        sockaddr_in sa;
+        ZeroMemory(&sa, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(*port);
+        sa.sin_addr.s_addr = htonl(host.toIPv4Address());
+
+        if (bind(s, reinterpret_cast<sockaddr *>(&sa), sizeof(sa)) == SOCKET_ERROR ||
+            listen(s, backlog) == SOCKET_ERROR) {
+            *error = lastErrorString(WSAGetLastError());
+            closesocket(s);
+            return -1;
+        }
+
+        // the port, which was bound for port 0
+        int length = sizeof(sa);
+        if (getsockname(s, reinterpret_cast<sockaddr *>(&sa), &length) == 0) {
+            *port = ntohs(sa.sin_port);
+        }
+
+        // the socket is inherited by the workers only
+        SetHandleInformation(reinterpret_cast<HANDLE>(s), HANDLE_FLAG_INHERIT, 0);
+
+        return qintptr(s);
+    }
+
+    void FastCgiPool::closeListenSocket(qintptr socket)
+    {
+        if (socket != -1) {
+            closesocket(SOCKET(socket));
+        }
+    }
+
+    qint64 FastCgiPool::spawnWorker(const QString &program, const QStringList &arguments,
+                                    const QStringList &environment, qintptr socket)
+    {
+        SECURITY_ATTRIBUTES inheritable = {sizeof(SECURITY_ATTRIBUTES), 0, TRUE};
+        HANDLE shutdownEvent = CreateEventW(&inheritable, TRUE, FALSE, 0);
+        if (!shutdownEvent) {
+            return -1;
+        }
+
+        QString commandLine = quoteArgument(QDir::toNativeSeparators(program));
+        foreach (const QString &argument, arguments) {
+            commandLine += " " + quoteArgument(argument);
+        }
+
+        // a double null terminated block of "name=value\0" strings
+        QString env;
+        foreach (const QString &variable, environment) {
+            env += variable + QChar('\0');
+        }
+        env += QString("_FCGI_SHUTDOWN_EVENT_=%1").arg(quintptr(shutdownEvent)) + QChar('\0');
+        env += QChar('\0');
+
+        HANDLE listenHandle = reinterpret_cast<HANDLE>(socket);
+        SetHandleInformation(listenHandle, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+
+        STARTUPINFOW si;
+        ZeroMemory(&si, sizeof(si));
+        si.cb = sizeof(si);
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = listenHandle;
+        si.hStdOutput = INVALID_HANDLE_VALUE;
+        si.hStdError = INVALID_HANDLE_VALUE;
+
+        PROCESS_INFORMATION pi;
+        ZeroMemory(&pi, sizeof(pi));
+
+        BOOL created = CreateProcessW(0, reinterpret_cast<LPWSTR>(commandLine.data()), 0, 0, TRUE,
+                                      CREATE_NO_WINDOW | CREATE_UNICODE_ENVIRONMENT,
+                                      const_cast<ushort *>(env.utf16()), 0, &si, &pi);
+
+        // other child processes of the control panel must not inherit the socket
+        SetHandleInformation(listenHandle, HANDLE_FLAG_INHERIT, 0);
+
+        if (!created) {
+            CloseHandle(shutdownEvent);
+            return -1;
+        }
+
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+
+        shutdownEvents.insert(qint64(pi.dwProcessId), shutdownEvent);
+
+        return qint64(pi.dwProcessId);
+    }
+
+    void FastCgiPool::shutdownWorker(qint64 pid)
+    {
+        HANDLE shutdownEvent = shutdownEvents.value(pid, 0);
+        if (shutdownEvent) {
+            SetEvent(shutdownEvent);
+        }
+    }
+
+    void FastCgiPool::releaseWorker(qint64 pid)
+    {
+        HANDLE shutdownEvent = shutdownEvents.take(pid);
+        if (shutdownEvent) {
+            CloseHandle(shutdownEvent);
+        }
+    }
+}
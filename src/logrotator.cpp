@@ -0,0 +1,311 @@
+#include "logrotator.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QRunnable>
+#include <QSet>
+
+#include <algorithm>
+#include <functional>
+
+#include <zlib.h>
+
+namespace Servers
+{
+    namespace
+    {
+        const char *timestampFormat = "yyyyMMdd-hhmmsszzz";
+
+        // a renamed log might still be written, until the server reopened its logs
+        const int reopenDelayMs = 2000;
+
+        // logs with a queued or running job, they are not rotated again
+        QMutex pendingMutex;
+        QSet<QString> pending;
+
+        bool isPending(const QString &file)
+        {
+            QMutexLocker locker(&pendingMutex);
+            return pending.contains(file);
+        }
+
+        void setPending(const QString &file, bool on)
+        {
+            QMutexLocker locker(&pendingMutex);
+            if (on) {
+                pending.insert(file);
+            } else {
+                pending.remove(file);
+            }
+        }
+
+        QRegExp segmentPattern(const QString &file)
+        {
+            return QRegExp("^" + QRegExp::escape(QFileInfo(file).fileName()) + "\\.(\\d{8}-\\d{9})(\\.gz)?$");
+        }
+
+        bool compress(const QString &file, int level)
+        {
+            QFile in(file);
+            if (!in.open(QIODevice::ReadOnly)) {
+                return false;
+            }
+
+            QString target = file + ".gz";
+            QByteArray mode = "wb" + QByteArray::number(qBound(1, level, 9));
+
+            gzFile out = gzopen(QFile::encodeName(target).constData(), mode.constData());
+            if (!out) {
+                return false;
+            }
+
+            QByteArray buffer(256 * 1024, Qt::Uninitialized);
+            bool ok = true;
+            qint64 n = 0;
+
+            while (ok && (n = in.read(buffer.data(), buffer.size())) > 0) {
+                ok = gzwrite(out, buffer.constData(), unsigned(n)) == int(n);
+            }
+
+            ok = (gzclose(out) == Z_OK) && ok && n == 0;
+            in.close();
+
+            if (!ok) {
+                QFile::remove(target);
+                return false;
+            }
+
+            return QFile::remove(file);
+        }
+
+        /// Copies or compresses a rotated log and prunes the old segments.
+        class RotationJob : public QRunnable
+        {
+        public:
+            RotationJob(const QString &file, const QString &segment, bool copyTruncate, int keep, int level)
+                : file(file), segment(segment), copyTruncate(copyTruncate), keep(keep), level(level)
+            {
+            }
+
+            void run()
+            {
+                if (copyTruncate) {
+                    // lines written between copy and truncate are lost, like with logrotate
+                    if (!QFile::copy(file, segment)) {
+                        qDebug() << "[Logs] Copying" << file << "failed";
+                        setPending(file, false);
+                        return;
+                    }
+                    QFile(file).resize(0);
+                }
+
+                // the log may be rotated again, the segment is on its own now
+                setPending(file, false);
+
+                if (level > 0 && !compress(segment, level)) {
+                    qDebug() << "[Logs] Compressing" << segment << "failed";
+                }
+
+                prune();
+            }
+
+        private:
+            QString file;
+            QString segment;
+            bool copyTruncate;
+            int keep;
+            int level;
+
+            // removes all but the newest "keep" segments, a segment is
+            // listed twice, while it is compressed
+            void prune()
+            {
+                QFileInfo info(file);
+                QDir dir = info.absoluteDir();
+                QRegExp pattern = segmentPattern(file);
+
+                QStringList names = dir.entryList(QStringList() << info.fileName() + ".*", QDir::Files, QDir::Name);
+
+                QStringList timestamps;
+                foreach (const QString &name, names) {
+                    if (pattern.exactMatch(name) && !timestamps.contains(pattern.cap(1))) {
+                        timestamps << pattern.cap(1);
+                    }
+                }
+
+                std::sort(timestamps.begin(), timestamps.end(), std::greater<QString>());
+
+                QSet<QString> expired = timestamps.mid(keep).toSet();
+
+                foreach (const QString &name, names) {
+                    if (pattern.exactMatch(name) && expired.contains(pattern.cap(1))) {
+                        dir.remove(name);
+                    }
+                }
+            }
+        };
+    }
+
+    LogRotator::LogRotator(QObject *parent) : QObject(parent)
+    {
+        // one rotation at a time, the servers keep the other cores
+        pool.setMaxThreadCount(1);
+
+        connect(&timer, SIGNAL(timeout()), this, SLOT(check()));
+    }
+
+    LogRotator::~LogRotator()
+    {
+        timer.stop();
+        pool.waitForDone();
+    }
+
+    void LogRotator::setPolicy(const Policy &policy) { this->policy = policy; }
+
+    void LogRotator::setCheckInterval(int intervalMs) { timer.setInterval(intervalMs); }
+
+    void LogRotator::addLog(const QString &serverName, const QString &file, Method method)
+    {
+        Log log;
+        log.serverName = serverName;
+        log.file = file;
+        log.method = method;
+
+        logs << log;
+    }
+
+    void LogRotator::start() { timer.start(); }
+
+    void LogRotator::stop() { timer.stop(); }
+
+    /**
+     * Rotates all logs of a server, e.g. before it is started.
+     * A stopped server has no open logs, they are always renamed.
+     */
+    void LogRotator::rotate(const QString &serverName, bool serverRunning)
+    {
+        bool renamed = false;
+
+        foreach (const Log &log, logs) {
+            if (log.serverName != serverName) {
+                continue;
+            }
+
+            if (serverRunning) {
+                renamed |= rotateFile(log, log.method, reopenDelayMs);
+            } else {
+                rotateFile(log, Rename, 0);
+            }
+        }
+
+        if (renamed) {
+            emit logsRenamed(serverName);
+        }
+    }
+
+    /**
+     * Rotates the logs, which exceed the size or age limit.
+     */
+    void LogRotator::check()
+    {
+        QStringList renamed;
+
+        foreach (const Log &log, logs) {
+            if (isDue(log) && rotateFile(log, log.method, reopenDelayMs) && !renamed.contains(log.serverName)) {
+                renamed << log.serverName;
+            }
+        }
+
+        foreach (const QString &serverName, renamed) {
+            emit logsRenamed(serverName);
+        }
+    }
+
+    bool LogRotator::isDue(const Log &log)
+    {
+        QFileInfo info(log.file);
+
+        if (!info.exists() || info.size() == 0) {
+            firstSeen.remove(log.file);
+            return false;
+        }
+
+        if (!firstSeen.contains(log.file)) {
+            firstSeen.insert(log.file, QDateTime::currentDateTime());
+        }
+
+        if (policy.maxBytes > 0 && info.size() > policy.maxBytes) {
+            return true;
+        }
+
+        return policy.maxAgeDays > 0 && lastRotation(log.file).daysTo(QDateTime::currentDateTime()) >= policy.maxAgeDays;
+    }
+
+    /**
+     * Moves the log aside and queues the background work.
+     * Returns true, if the log was renamed.
+     */
+    bool LogRotator::rotateFile(const Log &log, Method method, int compressDelayMs)
+    {
+        QFileInfo info(log.file);
+
+        if (!info.exists() || info.size() == 0 || isPending(log.file)) {
+            return false;
+        }
+
+        QString segment = segmentName(log.file);
+        firstSeen.remove(log.file);
+
+        // Windows refuses to rename a log, which is open without FILE_SHARE_DELETE
+        if (method == Rename && !QFile::rename(log.file, segment)) {
+            method = CopyTruncate;
+        }
+
+        qDebug() << "[" + log.serverName + "] Rotating" << log.file << "to" << segment
+                 << (method == Rename ? "(rename)" : "(copytruncate)");
+
+        RotationJob *job =
+            new RotationJob(log.file, segment, method == CopyTruncate, policy.keep, policy.compressionLevel);
+        setPending(log.file, true);
+
+        if (method == Rename && compressDelayMs > 0) {
+            QTimer::singleShot(compressDelayMs, this, [this, job]() { pool.start(job); });
+        } else {
+            pool.start(job);
+        }
+
+        return method == Rename;
+    }
+
+    QString LogRotator::segmentName(const QString &file)
+    {
+        return file + "." + QDateTime::currentDateTime().toString(timestampFormat);
+    }
+
+    /**
+     * The time of the newest segment or, without one, the time the log was
+     * first seen non-empty. QFileInfo::created() is the inode change time on
+     * Unix (Qt < 5.10), which every write updates.
+     */
+    QDateTime LogRotator::lastRotation(const QString &file) const
+    {
+        QFileInfo info(file);
+        QRegExp pattern = segmentPattern(file);
+
+        QStringList names =
+            info.absoluteDir().entryList(QStringList() << info.fileName() + ".*", QDir::Files, QDir::Name | QDir::Reversed);
+
+        foreach (const QString &name, names) {
+            if (pattern.exactMatch(name)) {
+                return QDateTime::fromString(pattern.cap(1), timestampFormat);
+            }
+        }
+
+        return firstSeen.value(file, QDateTime::currentDateTime());
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef LOGROTATOR_H
+#define LOGROTATOR_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+namespace Servers
+{
+    /// Rotates the log files of the servers and compresses the segments.
+    /*!
+        A log is rotated, when it is larger than "maxBytes" or its last
+        rotation is older than "maxAgeDays" (without a segment: since the log
+        was first seen non-empty, the creation time is not available on
+        every file system). The current log is moved aside as
+        "<log>.<yyyyMMdd-hhmmss>" and compressed to "<log>.<...>.gz" by zlib.
+        Only the newest "keep" segments are kept.
+
+        Logs are either renamed (the server reopens its log, e.g. nginx
+        "-s reopen", or opens it per write, like PHP) or copied and
+        truncated (copytruncate, for servers holding their log open).
+
+        The rename happens right away, it is a single metadata operation.
+        Copying, compressing and pruning run on a single background thread,
+        so a rotation never blocks the start of a server.
+    */
+    class LogRotator : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        enum Method
+        {
+            Rename, // the server reopens the log, see logsRenamed()
+            CopyTruncate
+        };
+
+        struct Policy
+        {
+            Policy() : maxBytes(10 * 1024 * 1024), maxAgeDays(7), keep(5), compressionLevel(6) {}
+
+            qint64 maxBytes; // 0 = no size limit
+            int maxAgeDays; // 0 = no age limit
+            int keep; // rotated segments per log
+            int compressionLevel; // 1-9, 0 = don't compress
+        };
+
+        explicit LogRotator(QObject *parent = 0);
+        ~LogRotator();
+
+        void setPolicy(const Policy &policy);
+        void setCheckInterval(int intervalMs);
+
+        void addLog(const QString &serverName, const QString &file, Method method);
+
+        void rotate(const QString &serverName, bool serverRunning);
+
+    public slots:
+        void start();
+        void stop();
+        void check();
+
+    signals:
+        // the server needs to reopen its logs
+        void logsRenamed(const QString &serverName);
+
+    private:
+        struct Log
+        {
+            QString serverName;
+            QString file;
+            Method method;
+        };
+
+        QList<Log> logs;
+        Policy policy;
+        QTimer timer;
+        QThreadPool pool;
+        // log => first check, which found it non-empty, since its last rotation
+        QHash<QString, QDateTime> firstSeen;
+
+        bool isDue(const Log &log);
+        bool rotateFile(const Log &log, Method method, int compressDelayMs);
+
+        static QString segmentName(const QString &file);
+        QDateTime lastRotation(const QString &file) const;
+    };
+}
+
+#endif // LOGROTATOR_H
@@ -0,0 +1,328 @@
+#include "accesslog.h"
+
+#include <ctype.h>
+#include <string.h>
+
+namespace
+{
+    const int subBuckets = 64;
+    const int linearBuckets = 2 * subBuckets; // 0-127 ms, 1 ms each
+    const int bucketCount = linearBuckets + 24 * subBuckets; // up to 2^31 ms
+
+    int highestBit(quint32 v)
+    {
+        int bit = 0;
+        while (v >>= 1) {
+            ++bit;
+        }
+        return bit;
+    }
+
+    qint64 parseNumber(const LogField &field)
+    {
+        if (field.size == 0) {
+            return -1;
+        }
+
+        qint64 n = 0;
+        for (int i = 0; i < field.size; ++i) {
+            unsigned digit = unsigned(field.data[i] - '0');
+            if (digit > 9) {
+                return -1;
+            }
+            n = n * 10 + digit;
+        }
+        return n;
+    }
+
+    // "1.234" (seconds, millisecond resolution) to 1234
+    int parseSeconds(const LogField &field)
+    {
+        const char *p = field.data;
+        const char *end = field.data + field.size;
+
+        qint64 ms = 0;
+        while (p < end && unsigned(*p - '0') <= 9) {
+            ms = ms * 10 + (*p++ - '0');
+        }
+        if (p == field.data || ms > 2000000) {
+            return -1;
+        }
+        ms *= 1000;
+
+        if (p < end && *p == '.') {
+            ++p;
+            for (int scale = 100; scale > 0 && p < end && unsigned(*p - '0') <= 9; scale /= 10) {
+                ms += (*p++ - '0') * scale;
+            }
+        }
+
+        return int(ms);
+    }
+}
+
+const char *AccessLogFormat::combined = "$remote_addr - $remote_user [$time_local] \"$request\" $status "
+                                        "$body_bytes_sent \"$http_referer\" \"$http_user_agent\"";
+
+LogField AccessLogEntry::uri() const
+{
+    if (requestUri.size > 0) {
+        return requestUri;
+    }
+
+    // the second word of "GET /path HTTP/1.1"
+    LogField uri;
+    const char *end = request.data + request.size;
+    const char *space = static_cast<const char *>(memchr(request.data, ' ', size_t(request.size)));
+    if (!space) {
+        return uri;
+    }
+
+    uri.data = space + 1;
+    const char *next = static_cast<const char *>(memchr(uri.data, ' ', size_t(end - uri.data)));
+    uri.size = int((next ? next : end) - uri.data);
+    return uri;
+}
+
+AccessLogFormat::AccessLogFormat(const QString &format) : formatString(format), valid(true)
+{
+    QByteArray f = format.trimmed().toLatin1();
+    QByteArray literal;
+
+    int i = 0;
+    while (i < f.size()) {
+        if (f.at(i) != '$') {
+            literal += f.at(i++);
+            continue;
+        }
+
+        // "$name" or "${name}"
+        bool braced = i + 1 < f.size() && f.at(i + 1) == '{';
+        int start = i + (braced ? 2 : 1);
+        int j = start;
+        while (j < f.size() && (isalnum(uchar(f.at(j))) || f.at(j) == '_')) {
+            ++j;
+        }
+
+        // two variables without a literal between them can't be told apart
+        if (j == start || (!tokens.isEmpty() && literal.isEmpty())) {
+            valid = false;
+        }
+
+        Token token;
+        token.prefix = literal;
+        token.variable = variableOf(f.mid(start, j - start));
+        tokens << token;
+
+        literal.clear();
+        i = (braced && j < f.size() && f.at(j) == '}') ? j + 1 : j;
+    }
+
+    suffix = literal;
+    valid = valid && !tokens.isEmpty();
+}
+
+bool AccessLogFormat::isValid() const { return valid; }
+
+bool AccessLogFormat::hasRequestTime() const
+{
+    foreach (const Token &token, tokens) {
+        if (token.variable == RequestTime) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString AccessLogFormat::format() const { return formatString; }
+
+AccessLogFormat::Variable AccessLogFormat::variableOf(const QByteArray &name)
+{
+    if (name == "remote_addr" || name == "http_x_forwarded_for") {
+        return RemoteAddr;
+    }
+    if (name == "request") {
+        return Request;
+    }
+    if (name == "request_uri") {
+        return RequestUri;
+    }
+    if (name == "status") {
+        return Status;
+    }
+    if (name == "body_bytes_sent") {
+        return BodyBytesSent;
+    }
+    if (name == "bytes_sent") {
+        return BytesSent;
+    }
+    if (name == "request_time") {
+        return RequestTime;
+    }
+    if (name == "http_user_agent") {
+        return UserAgent;
+    }
+    return Other;
+}
+
+/**
+ * Splits the line [begin, end) without the newline into its fields.
+ * Returns false, if the line doesn't match the format.
+ */
+bool AccessLogFormat::parse(const char *begin, const char *end, AccessLogEntry &entry) const
+{
+    entry = AccessLogEntry();
+    entry.status = 0;
+    entry.bytes = -1;
+    entry.requestTimeMs = -1;
+
+    const char *p = begin;
+
+    for (int i = 0; i < tokens.size(); ++i) {
+        const Token &token = tokens.at(i);
+
+        if (end - p < token.prefix.size() || memcmp(p, token.prefix.constData(), size_t(token.prefix.size())) != 0) {
+            return false;
+        }
+        p += token.prefix.size();
+
+        // the variable ends, where the next literal starts
+        const QByteArray &next = (i + 1 < tokens.size()) ? tokens.at(i + 1).prefix : suffix;
+        const char *fieldEnd = end;
+        if (!next.isEmpty()) {
+            fieldEnd = static_cast<const char *>(memchr(p, next.at(0), size_t(end - p)));
+            if (!fieldEnd) {
+                return false;
+            }
+        }
+
+        LogField field;
+        field.data = p;
+        field.size = int(fieldEnd - p);
+        p = fieldEnd;
+
+        switch (token.variable) {
+        case RemoteAddr:
+            entry.remoteAddr = field;
+            break;
+        case Request:
+            entry.request = field;
+            break;
+        case RequestUri:
+            entry.requestUri = field;
+            break;
+        case UserAgent:
+            entry.userAgent = field;
+            break;
+        case Status:
+            entry.status = int(parseNumber(field));
+            if (entry.status < 100 || entry.status > 599) {
+                return false;
+            }
+            break;
+        case BodyBytesSent:
+        case BytesSent:
+            entry.bytes = parseNumber(field);
+            break;
+        case RequestTime:
+            entry.requestTimeMs = parseSeconds(field);
+            break;
+        case Other:
+            break;
+        }
+    }
+
+    return true;
+}
+
+AccessLogStats::AccessLogStats()
+    : requests(0), malformed(0), bytes(0), timedRequests(0), statuses(500, 0), requestTimes(bucketCount, 0)
+{
+}
+
+void AccessLogStats::add(const AccessLogEntry &entry)
+{
+    ++requests;
+
+    if (entry.status >= 100 && entry.status <= 599) {
+        ++statuses[entry.status - 100];
+    }
+
+    if (entry.bytes > 0) {
+        bytes += quint64(entry.bytes);
+    }
+
+    if (entry.requestTimeMs >= 0) {
+        ++requestTimes[bucketOf(entry.requestTimeMs)];
+        ++timedRequests;
+    }
+}
+
+quint64 AccessLogStats::statusCount(int status) const
+{
+    return (status >= 100 && status <= 599) ? statuses.at(status - 100) : 0;
+}
+
+quint64 AccessLogStats::statusClassCount(int statusClass) const
+{
+    quint64 count = 0;
+    for (int status = statusClass * 100; status < statusClass * 100 + 100; ++status) {
+        count += statusCount(status);
+    }
+    return count;
+}
+
+QList<int> AccessLogStats::statusCodes() const
+{
+    QList<int> codes;
+    for (int i = 0; i < statuses.size(); ++i) {
+        if (statuses.at(i) > 0) {
+            codes << i + 100;
+        }
+    }
+    return codes;
+}
+
+/**
+ * The request time in ms, which p percent (0-100) of the requests don't exceed.
+ */
+int AccessLogStats::percentile(double p) const
+{
+    if (timedRequests == 0) {
+        return -1;
+    }
+
+    quint64 rank = quint64(qBound(0.0, p, 100.0) / 100.0 * double(timedRequests) + 0.5);
+    rank = qBound<quint64>(1, rank, timedRequests);
+
+    quint64 seen = 0;
+    for (int i = 0; i < requestTimes.size(); ++i) {
+        seen += requestTimes.at(i);
+        if (seen >= rank) {
+            return upperBoundOf(i);
+        }
+    }
+
+    return upperBoundOf(requestTimes.size() - 1);
+}
+
+int AccessLogStats::bucketOf(int ms)
+{
+    if (ms < linearBuckets) {
+        return ms;
+    }
+
+    int shift = highestBit(quint32(ms)) - 6;
+    return linearBuckets + (shift - 1) * subBuckets + ((ms >> shift) - subBuckets);
+}
+
+int AccessLogStats::upperBoundOf(int bucket)
+{
+    if (bucket < linearBuckets) {
+        return bucket;
+    }
+
+    int shift = (bucket - linearBuckets) / subBuckets + 1;
+    qint64 sub = (bucket - linearBuckets) % subBuckets + subBuckets;
+    return int(qMin<qint64>(((sub + 1) << shift) - 1, 0x7fffffff));
+}
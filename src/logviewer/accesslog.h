@@ -0,0 +1,116 @@
+#ifndef ACCESSLOG_H
+#define ACCESSLOG_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+/// A span of a log line, the bytes are not copied.
+struct LogField
+{
+    LogField() : data(0), size(0) {}
+
+    const char *data;
+    int size;
+
+    bool isEmpty() const { return size == 0 || (size == 1 && data[0] == '-'); }
+    QByteArray toByteArray() const { return QByteArray(data, size); }
+};
+
+/// The fields of one access log line, which the statistics use.
+struct AccessLogEntry
+{
+    LogField remoteAddr;
+    LogField request; // "GET /index.php?a=b HTTP/1.1"
+    LogField requestUri; // $request_uri, or the path of $request
+    LogField userAgent;
+    int status; // 0 = unknown
+    qint64 bytes; // $body_bytes_sent or $bytes_sent, -1 = unknown
+    int requestTimeMs; // $request_time, -1 = unknown
+
+    LogField uri() const;
+};
+
+/// An nginx "log_format", compiled for parsing.
+/*!
+    The format is split into the variables and the literal text between
+    them. A variable ends at the first character of the following literal,
+    which is found with memchr(), e.g. the '"' after "$request". The
+    default is the nginx "combined" format.
+*/
+class AccessLogFormat
+{
+public:
+    static const char *combined;
+
+    explicit AccessLogFormat(const QString &format = QString(combined));
+
+    bool isValid() const;
+    bool hasRequestTime() const;
+    QString format() const;
+
+    bool parse(const char *begin, const char *end, AccessLogEntry &entry) const;
+
+private:
+    enum Variable
+    {
+        Other,
+        RemoteAddr,
+        Request,
+        RequestUri,
+        Status,
+        BodyBytesSent,
+        BytesSent,
+        RequestTime,
+        UserAgent
+    };
+
+    struct Token
+    {
+        QByteArray prefix; // the literal text before the variable
+        Variable variable;
+    };
+
+    QString formatString;
+    QList<Token> tokens;
+    QByteArray suffix; // the literal text after the last variable
+    bool valid;
+
+    static Variable variableOf(const QByteArray &name);
+};
+
+/// Counters of an access log, updated line by line.
+/*!
+    The request times are counted in a histogram of 64 buckets per power
+    of two (128 below 128 ms), so a percentile is off by 1.6% at most and
+    the histogram has a fixed size of 14 KB.
+*/
+class AccessLogStats
+{
+public:
+    AccessLogStats();
+
+    void add(const AccessLogEntry &entry);
+    void addMalformed() { ++malformed; }
+
+    quint64 requests;
+    quint64 malformed;
+    quint64 bytes;
+    quint64 timedRequests; // with $request_time
+
+    quint64 statusCount(int status) const;
+    quint64 statusClassCount(int statusClass) const; // 2 = 2xx
+    QList<int> statusCodes() const;
+
+    int percentile(double p) const; // ms, -1 without request times
+
+private:
+    QVector<quint64> statuses; // 100-599
+    QVector<quint64> requestTimes;
+
+    static int bucketOf(int ms);
+    static int upperBoundOf(int bucket);
+};
+
+#endif // ACCESSLOG_H
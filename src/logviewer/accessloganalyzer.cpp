@@ -0,0 +1,220 @@
+#include "accessloganalyzer.h"
+
+#include <QDebug>
+#include <QFile>
+
+#include <string.h>
+
+namespace
+{
+    const qint64 chunkSize = 4 * 1024 * 1024;
+}
+
+AccessLogScanner::AccessLogScanner(const QStringList &fileNames, const AccessLogFormat &format)
+    : QObject(), fileNames(fileNames), format(format)
+{
+}
+
+const AccessLogStats &AccessLogScanner::stats() const { return statistics; }
+
+HeavyHittersReport AccessLogScanner::heavyHitters() const { return hitters.report(); }
+
+void AccessLogScanner::restart() { offsets.clear(); }
+
+void AccessLogScanner::scan()
+{
+    bool parsed = false;
+
+    foreach (const QString &fileName, fileNames) {
+        parsed |= scanFile(fileName);
+    }
+
+    emit scanned(statistics, true);
+
+    if (parsed) {
+        emit reported(hitters.report());
+    }
+}
+
+/**
+ * Parses the new lines of a log. Returns true, if there were any.
+ */
+bool AccessLogScanner::scanFile(const QString &fileName)
+{
+    // opened per scan: a rotated log is a new file under the same name
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 size = file.size();
+    qint64 &offset = offsets[fileName];
+    qint64 start = offset;
+
+    if (size < offset) {
+        offset = 0;
+    }
+
+    QByteArray buffer;
+
+    while (offset < size && !QThread::currentThread()->isInterruptionRequested()) {
+        // read, not mapped: a log, which can't be renamed, is truncated in place
+        // (copytruncate), a mapping beyond the new end would fault (SIGBUS)
+        buffer.resize(int(qMin(chunkSize, size - offset)));
+        qint64 length = file.seek(offset) ? file.read(buffer.data(), buffer.size()) : -1;
+        if (length < 0) {
+            qDebug() << "[Nginx] Reading" << fileName << "failed:" << file.errorString();
+        }
+        if (length <= 0) {
+            break; // a truncated log is read from the start on the next scan
+        }
+
+        const char *chunk = buffer.constData();
+
+        // the chunk is parsed up to its last newline
+        const char *last = chunk + length;
+        while (last > chunk && last[-1] != '\n') {
+            --last;
+        }
+
+        if (last > chunk) {
+            parseLines(chunk, last);
+            offset += last - chunk;
+        } else if (length == chunkSize) {
+            // a line longer than a chunk is no access log line
+            statistics.addMalformed();
+            offset += length;
+        }
+
+        if (last == chunk) {
+            break; // the rest is a line being written
+        }
+
+        // a long scan shows its progress
+        if (offset < size) {
+            emit scanned(statistics, false);
+        }
+    }
+
+    return offset != start;
+}
+
+void AccessLogScanner::parseLines(const char *begin, const char *end)
+{
+    AccessLogEntry entry;
+    const char *line = begin;
+
+    while (line < end) {
+        const char *newline = static_cast<const char *>(memchr(line, '\n', size_t(end - line)));
+        const char *lineEnd = (newline && newline > line && newline[-1] == '\r') ? newline - 1 : newline;
+
+        if (lineEnd > line) {
+            if (format.parse(line, lineEnd, entry)) {
+                statistics.add(entry);
+                hitters.add(entry);
+            } else {
+                statistics.addMalformed();
+            }
+        }
+
+        line = newline + 1;
+    }
+}
+
+AccessLogAnalyzer::AccessLogAnalyzer(const QStringList &fileNames, const AccessLogFormat &format, QObject *parent)
+    : QObject(parent), logFiles(fileNames), logFormat(format), scanner(new AccessLogScanner(fileNames, format)),
+      scanning(false), caughtUp(false), history(10)
+{
+    qRegisterMetaType<AccessLogStats>("AccessLogStats");
+    qRegisterMetaType<HeavyHittersReport>("HeavyHittersReport");
+
+    scanner->moveToThread(&thread);
+    connect(&thread, SIGNAL(finished()), scanner, SLOT(deleteLater()));
+    connect(scanner, SIGNAL(scanned(AccessLogStats, bool)), this, SLOT(scanned(AccessLogStats, bool)));
+    connect(scanner, SIGNAL(reported(HeavyHittersReport)), this, SLOT(reported(HeavyHittersReport)));
+
+    timer.setInterval(1000);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(scan()));
+
+    clock.start();
+}
+
+AccessLogAnalyzer::~AccessLogAnalyzer()
+{
+    timer.stop();
+
+    thread.requestInterruption();
+    thread.quit();
+    thread.wait();
+}
+
+QStringList AccessLogAnalyzer::fileNames() const { return logFiles; }
+
+AccessLogFormat AccessLogAnalyzer::format() const { return logFormat; }
+
+AccessLogStats AccessLogAnalyzer::stats() const { return latest; }
+
+HeavyHittersReport AccessLogAnalyzer::heavyHitters() const { return latestReport; }
+
+bool AccessLogAnalyzer::isCaughtUp() const { return caughtUp; }
+
+double AccessLogAnalyzer::requestRate() const
+{
+    if (history.size() < 2) {
+        return 0;
+    }
+
+    qint64 ms = history.last().first - history.at(0).first;
+    quint64 requests = history.last().second - history.at(0).second;
+
+    return ms > 0 ? requests * 1000.0 / ms : 0;
+}
+
+void AccessLogAnalyzer::setInterval(int intervalMs) { timer.setInterval(intervalMs); }
+
+void AccessLogAnalyzer::start()
+{
+    timer.start();
+    scan();
+}
+
+void AccessLogAnalyzer::stop() { timer.stop(); }
+
+/**
+ * The logs were rotated, they are read from the start on the next scan.
+ */
+void AccessLogAnalyzer::restart() { QMetaObject::invokeMethod(scanner, "restart", Qt::QueuedConnection); }
+
+void AccessLogAnalyzer::scan()
+{
+    if (!thread.isRunning()) {
+        thread.start(QThread::LowPriority);
+    }
+
+    // one scan at a time, a slow scan skips ticks
+    if (!scanning) {
+        scanning = true;
+        QMetaObject::invokeMethod(scanner, "scan", Qt::QueuedConnection);
+    }
+}
+
+void AccessLogAnalyzer::scanned(const AccessLogStats &stats, bool caughtUp)
+{
+    latest = stats;
+
+    // the rate counts the requests since the first complete scan,
+    // not the existing log
+    if (caughtUp) {
+        history.append(qMakePair(clock.elapsed(), stats.requests));
+        scanning = false;
+    }
+
+    this->caughtUp |= caughtUp;
+    emit updated();
+}
+
+void AccessLogAnalyzer::reported(const HeavyHittersReport &report)
+{
+    latestReport = report;
+    emit updated();
+}
@@ -0,0 +1,113 @@
+#ifndef ACCESSLOGANALYZER_H
+#define ACCESSLOGANALYZER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QPair>
+#include <QThread>
+#include <QTimer>
+
+#include "src/logviewer/accesslog.h"
+#include "src/logviewer/heavyhitters.h"
+#include "src/processviewer/ringbuffer.h"
+
+/// Parses the lines appended to the access logs since the last scan.
+/*!
+    The new bytes are read in chunks of 4 MB, the lines are found with
+    memchr() and parsed in place in the chunk. The
+    scan ends at the last complete line, a line still being written is
+    parsed by the next scan.
+
+    A log, which got smaller (rotated or truncated), is read from the start
+    again, the statistics keep counting. The statistics and the heavy
+    hitters are those of all logs together.
+*/
+class AccessLogScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    AccessLogScanner(const QStringList &fileNames, const AccessLogFormat &format);
+
+    const AccessLogStats &stats() const;
+    HeavyHittersReport heavyHitters() const;
+
+public slots:
+    void scan();
+    void restart();
+
+signals:
+    // "caughtUp": the scan reached the end of the log
+    void scanned(const AccessLogStats &stats, bool caughtUp);
+    void reported(const HeavyHittersReport &report);
+
+private:
+    QStringList fileNames;
+    AccessLogFormat format;
+    AccessLogStats statistics;
+    HeavyHitters hitters;
+    QHash<QString, qint64> offsets;
+
+    bool scanFile(const QString &fileName);
+    void parseLines(const char *begin, const char *end);
+};
+
+/// Keeps the statistics of the nginx access logs up to date.
+/*!
+    An AccessLogScanner parses the new lines of the log on a background
+    thread: once per interval while started, or once per call of scan().
+    The request rate is measured over the last 10 scans, after the scanner
+    caught up with the existing log.
+*/
+class AccessLogAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    AccessLogAnalyzer(const QStringList &fileNames, const AccessLogFormat &format, QObject *parent = 0);
+    ~AccessLogAnalyzer();
+
+    QStringList fileNames() const;
+    AccessLogFormat format() const;
+    AccessLogStats stats() const;
+    HeavyHittersReport heavyHitters() const;
+    bool isCaughtUp() const;
+    double requestRate() const; // requests per second
+
+    void setInterval(int intervalMs);
+
+public slots:
+    void start();
+    void stop();
+    void restart();
+    void scan();
+
+signals:
+    void updated();
+
+private slots:
+    void scanned(const AccessLogStats &stats, bool caughtUp);
+    void reported(const HeavyHittersReport &report);
+
+private:
+    QStringList logFiles;
+    AccessLogFormat logFormat;
+
+    QThread thread;
+    AccessLogScanner *scanner;
+    QTimer timer;
+    bool scanning;
+
+    AccessLogStats latest;
+    HeavyHittersReport latestReport;
+    bool caughtUp;
+
+    QElapsedTimer clock;
+    RingBuffer<QPair<qint64, quint64>> history; // ms, requests
+};
+
+Q_DECLARE_METATYPE(AccessLogStats)
+
+#endif // ACCESSLOGANALYZER_H
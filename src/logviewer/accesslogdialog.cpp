@@ -0,0 +1,160 @@
+#include "accesslogdialog.h"
+
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLocale>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QVBoxLayout>
+
+namespace
+{
+    QString formatBytes(quint64 bytes)
+    {
+        const char *units[] = {"B", "KB", "MB", "GB", "TB"};
+        double value = double(bytes);
+        int unit = 0;
+        while (value >= 1024 && unit < 4) {
+            value /= 1024;
+            ++unit;
+        }
+        return QString("%1 %2").arg(value, 0, 'f', unit ? 1 : 0).arg(units[unit]);
+    }
+}
+
+AccessLogDialog::AccessLogDialog(AccessLogAnalyzer *analyzer, QWidget *parent)
+    : QDialog(parent), analyzer(analyzer)
+{
+    // remove question mark from the title bar
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    requestsLabel = new QLabel(this);
+    rateLabel = new QLabel(this);
+    bytesLabel = new QLabel(this);
+    requestTimeLabel = new QLabel(this);
+    malformedLabel = new QLabel(this);
+    visitorsLabel = new QLabel(this);
+
+    QFormLayout *formLayout = new QFormLayout;
+    formLayout->addRow(tr("Logs:"), new QLabel(analyzer->fileNames().join("\n"), this));
+    formLayout->addRow(tr("Requests:"), requestsLabel);
+    formLayout->addRow(tr("Request rate:"), rateLabel);
+    formLayout->addRow(tr("Bytes served:"), bytesLabel);
+    formLayout->addRow(tr("Request time:"), requestTimeLabel);
+    formLayout->addRow(tr("Unparsed lines:"), malformedLabel);
+    formLayout->addRow(tr("Unique visitors:"), visitorsLabel);
+
+    statusTable = createTable(QStringList() << tr("Status") << tr("Requests") << tr("Share"));
+
+    QWidget *overview = new QWidget(this);
+    QVBoxLayout *overviewLayout = new QVBoxLayout;
+    overviewLayout->addLayout(formLayout);
+    overviewLayout->addWidget(statusTable);
+    overview->setLayout(overviewLayout);
+
+    urlsTable = createTable(QStringList() << tr("Requests") << tr("URL"));
+    slowUrlsTable = createTable(QStringList() << tr("Total request time (ms)") << tr("URL"));
+    clientsTable = createTable(QStringList() << tr("Requests") << tr("Client"));
+    userAgentsTable = createTable(QStringList() << tr("Requests") << tr("User Agent"));
+
+    QTabWidget *tabs = new QTabWidget(this);
+    tabs->addTab(overview, tr("Overview"));
+    tabs->addTab(urlsTable, tr("Top URLs"));
+    tabs->addTab(slowUrlsTable, tr("Slowest URLs"));
+    tabs->addTab(clientsTable, tr("Top Clients"));
+    tabs->addTab(userAgentsTable, tr("User Agents"));
+
+    QPushButton *btnClose = new QPushButton(tr("Close"), this);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(btnClose);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(tabs);
+    mainLayout->addLayout(buttonLayout);
+    setLayout(mainLayout);
+
+    connect(analyzer, SIGNAL(updated()), this, SLOT(refresh()));
+    connect(btnClose, SIGNAL(clicked()), this, SLOT(close()));
+
+    setWindowTitle(tr("WPX-XM Server Control Panel - Access Log Statistics"));
+    resize(600, 550);
+
+    refresh();
+    analyzer->scan();
+}
+
+void AccessLogDialog::refresh()
+{
+    QLocale locale;
+    AccessLogStats stats = analyzer->stats();
+
+    requestsLabel->setText(locale.toString(stats.requests));
+    rateLabel->setText(analyzer->isCaughtUp() ? tr("%1 / s").arg(analyzer->requestRate(), 0, 'f', 1)
+                                              : tr("reading the log..."));
+    bytesLabel->setText(formatBytes(stats.bytes));
+    malformedLabel->setText(locale.toString(stats.malformed));
+
+    HeavyHittersReport report = analyzer->heavyHitters();
+    visitorsLabel->setText("~" + locale.toString(report.uniqueVisitors));
+    showHeavyHitters(urlsTable, report.urlsByCount);
+    showHeavyHitters(slowUrlsTable, report.urlsByTime);
+    showHeavyHitters(clientsTable, report.clientIps);
+    showHeavyHitters(userAgentsTable, report.userAgents);
+
+    if (stats.timedRequests > 0) {
+        requestTimeLabel->setText(tr("p50 %1 ms, p95 %2 ms, p99 %3 ms")
+                                      .arg(stats.percentile(50))
+                                      .arg(stats.percentile(95))
+                                      .arg(stats.percentile(99)));
+    } else {
+        requestTimeLabel->setText(tr("add $request_time to the log format (\"nginx/logformat\")"));
+    }
+
+    QList<int> codes = stats.statusCodes();
+    statusTable->setRowCount(codes.size());
+
+    for (int row = 0; row < codes.size(); ++row) {
+        quint64 count = stats.statusCount(codes.at(row));
+        double share = stats.requests ? count * 100.0 / stats.requests : 0;
+
+        statusTable->setItem(row, 0, new QTableWidgetItem(QString::number(codes.at(row))));
+        statusTable->setItem(row, 1, new QTableWidgetItem(locale.toString(count)));
+        statusTable->setItem(row, 2, new QTableWidgetItem(QString::number(share, 'f', 1) + " %"));
+    }
+}
+
+QTableWidget *AccessLogDialog::createTable(const QStringList &labels)
+{
+    QTableWidget *table = new QTableWidget(0, labels.size(), this);
+    table->setHorizontalHeaderLabels(labels);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->verticalHeader()->setVisible(false);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionMode(QAbstractItemView::NoSelection);
+    return table;
+}
+
+/**
+ * The counts are estimates: "error" is the most, by which they might be too high.
+ */
+void AccessLogDialog::showHeavyHitters(QTableWidget *table, const QList<HeavyHitter> &hitters)
+{
+    QLocale locale;
+    table->setRowCount(hitters.size());
+
+    for (int row = 0; row < hitters.size(); ++row) {
+        const HeavyHitter &hitter = hitters.at(row);
+
+        QString count = locale.toString(hitter.count);
+        if (hitter.error > 0) {
+            count += QString(" ") + QChar(0x00b1) + locale.toString(hitter.error);
+        }
+
+        table->setItem(row, 0, new QTableWidgetItem(count));
+        table->setItem(row, 1, new QTableWidgetItem(QString::fromUtf8(hitter.key)));
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef ACCESSLOGDIALOG_H
+#define ACCESSLOGDIALOG_H
+
+#include "src/logviewer/accessloganalyzer.h"
+
+#include <QDialog>
+#include <QLabel>
+#include <QTableWidget>
+
+/// Shows the live statistics and the heavy hitters of the nginx access logs.
+class AccessLogDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit AccessLogDialog(AccessLogAnalyzer *analyzer, QWidget *parent = 0);
+
+private slots:
+    void refresh();
+
+private:
+    QTableWidget *createTable(const QStringList &labels);
+    void showHeavyHitters(QTableWidget *table, const QList<HeavyHitter> &hitters);
+
+    AccessLogAnalyzer *analyzer;
+
+    QLabel *requestsLabel;
+    QLabel *rateLabel;
+    QLabel *bytesLabel;
+    QLabel *requestTimeLabel;
+    QLabel *malformedLabel;
+    QLabel *visitorsLabel;
+    QTableWidget *statusTable;
+    QTableWidget *urlsTable;
+    QTableWidget *slowUrlsTable;
+    QTableWidget *clientsTable;
+    QTableWidget *userAgentsTable;
+};
+
+#endif // ACCESSLOGDIALOG_H
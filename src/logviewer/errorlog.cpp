@@ -0,0 +1,179 @@
+#include "errorlog.h"
+
+#include "src/logviewer/sketches.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    const double decaySeconds = 60;
+
+    inline bool isDigit(char c) { return unsigned(c - '0') <= 9; }
+
+    inline bool isAlpha(char c) { return unsigned((c | 0x20) - 'a') <= 25; }
+
+    inline bool isWordChar(char c) { return isDigit(c) || isAlpha(c) || c == '_'; }
+
+    inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    inline bool isHexDigit(char c) { return isDigit(c) || unsigned((c | 0x20) - 'a') <= 5; }
+
+    // month, weekday and timezone names of the timestamps
+    bool isDateWord(const char *p, int size)
+    {
+        static const char *words[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep",
+                                      "Oct", "Nov", "Dec", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat",
+                                      "Sun", "UTC", "GMT", "CET", "CEST"};
+
+        for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+            if (int(strlen(words[i])) == size && memcmp(words[i], p, size_t(size)) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // "/var/log", "\www", "C:\www" or "C:/www", after a separator
+    bool isPathStart(const char *p, const char *begin, const char *end)
+    {
+        if (p > begin && (isWordChar(p[-1]) || p[-1] == '.')) {
+            return false;
+        }
+        if (*p == '/' || *p == '\\') {
+            return p + 1 < end && (isWordChar(p[1]) || p[1] == '.');
+        }
+        return isAlpha(*p) && p + 2 < end && p[1] == ':' && (p[2] == '\\' || p[2] == '/');
+    }
+
+    inline bool isPathEnd(char c)
+    {
+        return isSpace(c) || c == '"' || c == '\'' || c == ')' || c == ',' || c == ']' || c == '>';
+    }
+}
+
+double ErrorLogGroup::ratePerMinute(const QDateTime &now) const
+{
+    qint64 ms = qMax<qint64>(0, lastSeen.msecsTo(now));
+    return decayedCount * exp(-ms / 1000.0 / decaySeconds);
+}
+
+/**
+ * Skips "[16-Oct-2016 10:01:02 UTC]", "2016/10/16 10:01:02",
+ * "2016-10-16 10:01:02 0" and "1234:M 16 Oct 2016 10:01:02.123".
+ */
+const char *ErrorLogNormalizer::skipTimestamp(const char *p, const char *end)
+{
+    for (;;) {
+        while (p < end && isSpace(*p)) {
+            ++p;
+        }
+        if (p == end) {
+            return p;
+        }
+
+        if (*p == '[') {
+            // a bracket with a date, not a level like "[error]"
+            const char *close = static_cast<const char *>(memchr(p, ']', size_t(end - p)));
+            if (!close || close == p + 1 || !isDigit(p[1])) {
+                return p;
+            }
+            p = close + 1;
+        } else if (isDigit(*p)) {
+            const char *q = p;
+            while (q < end && (isDigit(*q) || strchr("-/:.,+", *q))) {
+                ++q;
+            }
+            // the role of a Redis process, "1234:M"
+            if (q < end && q[-1] == ':' && isAlpha(*q) && (q + 1 == end || isSpace(q[1]))) {
+                ++q;
+            }
+            p = q;
+        } else if (isAlpha(*p)) {
+            const char *q = p;
+            while (q < end && isAlpha(*q)) {
+                ++q;
+            }
+            if (!isDateWord(p, int(q - p)) || (q < end && isWordChar(*q))) {
+                return p;
+            }
+            p = q;
+        } else {
+            return p;
+        }
+    }
+}
+
+QByteArray ErrorLogNormalizer::normalize(const char *begin, const char *end)
+{
+    QByteArray pattern;
+    pattern.reserve(qMin(int(end - begin), MaxPatternLength));
+
+    const char *p = skipTimestamp(begin, end);
+    bool space = false;
+
+    while (p < end && pattern.size() < MaxPatternLength) {
+        if (isSpace(*p)) {
+            space = !pattern.isEmpty();
+            ++p;
+            continue;
+        }
+
+        if (space) {
+            pattern += ' ';
+            space = false;
+        }
+
+        if (isPathStart(p, begin, end)) {
+            pattern += "<path>";
+            while (p < end && !isPathEnd(*p)) {
+                ++p;
+            }
+            continue;
+        }
+
+        if (!isWordChar(*p)) {
+            pattern += *p++;
+            continue;
+        }
+
+        // a word, a number ("1.5", "127.0.0.1", "0x7ffe") or a mix ("utf8mb4")
+        const char *q = p;
+        bool hasDigit = false;
+        bool allHex = true;
+        while (q < end && (isWordChar(*q) || (*q == '.' && isDigit(*p) && q + 1 < end && isDigit(q[1])))) {
+            hasDigit |= isDigit(*q);
+            allHex &= isHexDigit(*q);
+            ++q;
+        }
+
+        if (!hasDigit) {
+            if (isDateWord(p, int(q - p))) {
+                pattern += '#';
+            } else {
+                pattern.append(p, int(q - p));
+            }
+        } else if (isDigit(*p) || (allHex && q - p >= 8)) {
+            pattern += '#';
+        } else {
+            for (const char *c = p; c < q; ++c) {
+                if (!isDigit(*c)) {
+                    pattern += *c;
+                } else if (c == p || !isDigit(c[-1])) {
+                    pattern += '#';
+                }
+            }
+        }
+
+        p = q;
+    }
+
+    return pattern;
+}
+
+quint64 ErrorLogNormalizer::fingerprint(const QString &serverName, const QByteArray &pattern)
+{
+    QByteArray server = serverName.toLatin1();
+    quint64 seed = Sketches::hash(server.constData(), server.size());
+    return Sketches::hash(pattern.constData(), pattern.size(), seed);
+}
@@ -0,0 +1,56 @@
+#ifndef ERRORLOG_H
+#define ERRORLOG_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMetaType>
+#include <QString>
+
+/// The entries of an error log, which differ only in numbers, paths and times.
+struct ErrorLogGroup
+{
+    ErrorLogGroup() : count(0), decayedCount(0) {}
+
+    QString serverName;
+    QByteArray pattern; // the normalized entry
+    QByteArray sample; // the last entry, as written
+    quint64 count;
+    QDateTime firstSeen;
+    QDateTime lastSeen;
+
+    // the count, decaying with a time constant of one minute: the steady
+    // state of n entries per minute is n
+    double decayedCount;
+
+    double ratePerMinute(const QDateTime &now) const;
+};
+
+typedef QHash<quint64, ErrorLogGroup> ErrorLogGroups;
+
+/// Reduces an error log entry to a pattern, the same for all repetitions.
+/*!
+    The timestamp, pid and log level prefix is removed (php, nginx,
+    MariaDB and Redis formats), paths become "<path>", numbers, IPs and
+    hex strings "#", and runs of whitespace a single space. The pattern
+    and the server name are hashed to the fingerprint.
+
+    Example (PHP):
+        [16-Oct-2016 10:01:02 UTC] PHP Notice:  Undefined index: id in C:\www\a.php on line 12
+        PHP Notice: Undefined index: id in <path> on line #
+*/
+class ErrorLogNormalizer
+{
+public:
+    static const int MaxPatternLength = 512;
+
+    static QByteArray normalize(const char *begin, const char *end);
+    static quint64 fingerprint(const QString &serverName, const QByteArray &pattern);
+
+private:
+    static const char *skipTimestamp(const char *p, const char *end);
+};
+
+Q_DECLARE_METATYPE(ErrorLogGroups)
+
+#endif // ERRORLOG_H
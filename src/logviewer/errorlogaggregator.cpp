@@ -0,0 +1,275 @@
+#include "errorlogaggregator.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QPair>
+#include <QVector>
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    const qint64 chunkSize = 4 * 1024 * 1024;
+    const int maxSampleLength = 1024;
+    const double decayMs = 60 * 1000;
+}
+
+ErrorLogScanner::ErrorLogScanner(qint64 backlog, int maxGroups) : QObject(), backlog(backlog), maxGroups(maxGroups)
+{
+}
+
+void ErrorLogScanner::addLog(const QString &serverName, const QString &fileName)
+{
+    Log log;
+    log.serverName = serverName;
+    log.fileName = fileName;
+    log.offset = -1;
+
+    logs << log;
+}
+
+const ErrorLogGroups &ErrorLogScanner::groups() const { return groupsByFingerprint; }
+
+void ErrorLogScanner::scan()
+{
+    bool changed = false;
+
+    for (int i = 0; i < logs.size(); ++i) {
+        changed |= scanFile(logs[i]);
+    }
+
+    if (changed && groupsByFingerprint.size() > maxGroups) {
+        dropOldGroups();
+    }
+
+    emit scanned(groupsByFingerprint, changed);
+}
+
+/**
+ * The logs of the server were rotated, the new logs are read from the start.
+ */
+void ErrorLogScanner::restart(const QString &serverName)
+{
+    for (int i = 0; i < logs.size(); ++i) {
+        if (logs.at(i).serverName == serverName && logs.at(i).offset >= 0) {
+            logs[i].offset = 0;
+        }
+    }
+}
+
+void ErrorLogScanner::clear()
+{
+    groupsByFingerprint.clear();
+    emit scanned(groupsByFingerprint, true);
+}
+
+/**
+ * Groups the new lines of a log. Returns true, if there were any.
+ */
+bool ErrorLogScanner::scanFile(Log &log)
+{
+    // opened per scan: a rotated log is a new file under the same name
+    QFile file(log.fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 size = file.size();
+
+    // the history before the first scan is dated by the last write
+    bool live = log.offset >= 0;
+    QDateTime seen = live ? QDateTime::currentDateTime() : QFileInfo(file).lastModified();
+
+    if (!live) {
+        log.offset = (backlog < 0) ? 0 : qMax<qint64>(0, size - backlog);
+    } else if (size < log.offset) {
+        log.offset = 0;
+    }
+
+    qint64 start = log.offset;
+    bool midLine = !live && log.offset > 0;
+    QByteArray buffer;
+
+    while (log.offset < size && !QThread::currentThread()->isInterruptionRequested()) {
+        // read, not mapped: the log rotator truncates logs in place (copytruncate),
+        // a mapping beyond the new end would fault (SIGBUS)
+        buffer.resize(int(qMin(chunkSize, size - log.offset)));
+        qint64 length = file.seek(log.offset) ? file.read(buffer.data(), buffer.size()) : -1;
+        if (length < 0) {
+            qDebug() << "[" + log.serverName + "] Reading" << log.fileName << "failed:" << file.errorString();
+        }
+        if (length <= 0) {
+            break; // a truncated log is read from the start on the next scan
+        }
+
+        const char *chunk = buffer.constData();
+        const char *first = chunk;
+        const char *last = chunk + length;
+
+        // the backlog starts somewhere in a line
+        if (midLine) {
+            const char *newline = static_cast<const char *>(memchr(chunk, '\n', size_t(length)));
+            first = newline ? newline + 1 : last;
+            midLine = !newline;
+        }
+
+        while (last > first && last[-1] != '\n') {
+            --last;
+        }
+
+        if (last > first) {
+            parseLines(log.serverName, first, last, seen, live);
+            log.offset += last - chunk;
+        } else if (length == chunkSize) {
+            // a line longer than a chunk is skipped
+            log.offset += length;
+            midLine = true;
+        } else {
+            // the rest is a line being written
+            log.offset += first - chunk;
+            break;
+        }
+    }
+
+    return log.offset != start;
+}
+
+void ErrorLogScanner::parseLines(const QString &serverName, const char *begin, const char *end,
+                                 const QDateTime &seen, bool live)
+{
+    const char *line = begin;
+
+    while (line < end) {
+        const char *newline = static_cast<const char *>(memchr(line, '\n', size_t(end - line)));
+        const char *lineEnd = (newline > line && newline[-1] == '\r') ? newline - 1 : newline;
+
+        // empty lines and continuations, e.g. stack traces
+        if (lineEnd > line && *line != ' ' && *line != '\t') {
+            QByteArray pattern = ErrorLogNormalizer::normalize(line, lineEnd);
+            ErrorLogGroup &group = groupsByFingerprint[ErrorLogNormalizer::fingerprint(serverName, pattern)];
+
+            if (group.count == 0) {
+                group.serverName = serverName;
+                group.pattern = pattern;
+                group.firstSeen = seen;
+            }
+
+            // a flood of entries is seen at the same time: one sample and decay per scan
+            if (group.count == 0 || group.lastSeen != seen) {
+                if (group.count > 0) {
+                    group.decayedCount *= exp(-group.lastSeen.msecsTo(seen) / decayMs);
+                }
+                group.sample = QByteArray(line, int(qMin<qint64>(lineEnd - line, maxSampleLength)));
+                group.lastSeen = seen;
+            }
+
+            // the history doesn't count for the rate
+            if (live) {
+                group.decayedCount += 1;
+            }
+            ++group.count;
+        }
+
+        line = newline + 1;
+    }
+}
+
+/**
+ * Drops the groups, which were not seen for the longest time, down to 90% of "maxGroups".
+ */
+void ErrorLogScanner::dropOldGroups()
+{
+    typedef QPair<QDateTime, quint64> Age;
+
+    QVector<Age> ages;
+    ages.reserve(groupsByFingerprint.size());
+    for (ErrorLogGroups::const_iterator it = groupsByFingerprint.constBegin(); it != groupsByFingerprint.constEnd();
+         ++it) {
+        ages.append(Age(it.value().lastSeen, it.key()));
+    }
+
+    int drop = groupsByFingerprint.size() - maxGroups * 9 / 10;
+    std::nth_element(ages.begin(), ages.begin() + drop, ages.end());
+
+    for (int i = 0; i < drop; ++i) {
+        groupsByFingerprint.remove(ages.at(i).second);
+    }
+}
+
+ErrorLogAggregator::ErrorLogAggregator(qint64 backlog, int maxGroups, QObject *parent)
+    : QObject(parent), scanner(new ErrorLogScanner(backlog, maxGroups)), scanning(false)
+{
+    qRegisterMetaType<ErrorLogGroups>("ErrorLogGroups");
+
+    scanner->moveToThread(&thread);
+    connect(&thread, SIGNAL(finished()), scanner, SLOT(deleteLater()));
+    connect(scanner, SIGNAL(scanned(ErrorLogGroups, bool)), this, SLOT(scanned(ErrorLogGroups, bool)));
+
+    timer.setInterval(1000);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(scan()));
+}
+
+ErrorLogAggregator::~ErrorLogAggregator()
+{
+    timer.stop();
+
+    thread.requestInterruption();
+    thread.quit();
+    thread.wait();
+}
+
+void ErrorLogAggregator::addLog(const QString &serverName, const QString &fileName)
+{
+    scanner->addLog(serverName, fileName);
+    logFiles << fileName;
+    logServers << serverName;
+}
+
+QStringList ErrorLogAggregator::fileNames() const { return logFiles; }
+
+QStringList ErrorLogAggregator::serverNames() const { return logServers; }
+
+ErrorLogGroups ErrorLogAggregator::groups() const { return latest; }
+
+void ErrorLogAggregator::setInterval(int intervalMs) { timer.setInterval(intervalMs); }
+
+void ErrorLogAggregator::start()
+{
+    timer.start();
+    scan();
+}
+
+void ErrorLogAggregator::stop() { timer.stop(); }
+
+void ErrorLogAggregator::scan()
+{
+    if (!thread.isRunning()) {
+        thread.start(QThread::LowPriority);
+    }
+
+    // one scan at a time, a slow scan skips ticks
+    if (!scanning) {
+        scanning = true;
+        QMetaObject::invokeMethod(scanner, "scan", Qt::QueuedConnection);
+    }
+}
+
+void ErrorLogAggregator::restart(const QString &serverName)
+{
+    QMetaObject::invokeMethod(scanner, "restart", Qt::QueuedConnection, Q_ARG(QString, serverName));
+}
+
+void ErrorLogAggregator::clear() { QMetaObject::invokeMethod(scanner, "clear", Qt::QueuedConnection); }
+
+void ErrorLogAggregator::scanned(const ErrorLogGroups &groups, bool changed)
+{
+    scanning = false;
+
+    if (changed) {
+        latest = groups;
+        emit updated();
+    }
+}
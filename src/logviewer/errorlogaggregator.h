@@ -0,0 +1,102 @@
+#ifndef ERRORLOGAGGREGATOR_H
+#define ERRORLOGAGGREGATOR_H
+
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+
+#include "src/logviewer/errorlog.h"
+
+/// Tails error logs and groups their entries by fingerprint.
+/*!
+    A log is read from its end, minus "backlog" bytes of history (-1 reads
+    the whole log). Each scan reads only the bytes appended since the last
+    scan and stops at the last complete line. Lines starting with
+    whitespace continue the previous entry and are not counted.
+
+    At most "maxGroups" groups are kept, the longest unseen are dropped.
+*/
+class ErrorLogScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    ErrorLogScanner(qint64 backlog, int maxGroups);
+
+    void addLog(const QString &serverName, const QString &fileName);
+    const ErrorLogGroups &groups() const;
+
+public slots:
+    void scan();
+    void restart(const QString &serverName);
+    void clear();
+
+signals:
+    void scanned(const ErrorLogGroups &groups, bool changed);
+
+private:
+    struct Log
+    {
+        QString serverName;
+        QString fileName;
+        qint64 offset; // -1 = not read yet
+    };
+
+    QList<Log> logs;
+    ErrorLogGroups groupsByFingerprint;
+    qint64 backlog;
+    int maxGroups;
+
+    bool scanFile(Log &log);
+    void parseLines(const QString &serverName, const char *begin, const char *end, const QDateTime &seen, bool live);
+    void dropOldGroups();
+};
+
+/// Keeps the error log groups of the servers up to date.
+/*!
+    An ErrorLogScanner tails the logs on a background thread, once per
+    interval while started, or once per call of scan().
+*/
+class ErrorLogAggregator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ErrorLogAggregator(qint64 backlog = 1024 * 1024, int maxGroups = 10000, QObject *parent = 0);
+    ~ErrorLogAggregator();
+
+    // before the first scan
+    void addLog(const QString &serverName, const QString &fileName);
+
+    QStringList fileNames() const;
+    QStringList serverNames() const; // of each file in fileNames()
+    ErrorLogGroups groups() const;
+
+    void setInterval(int intervalMs);
+
+public slots:
+    void start();
+    void stop();
+    void scan();
+    void restart(const QString &serverName);
+    void clear();
+
+signals:
+    void updated();
+
+private slots:
+    void scanned(const ErrorLogGroups &groups, bool changed);
+
+private:
+    QThread thread;
+    ErrorLogScanner *scanner;
+    QTimer timer;
+    bool scanning;
+
+    QStringList logFiles;
+    QStringList logServers;
+    ErrorLogGroups latest;
+};
+
+#endif // ERRORLOGAGGREGATOR_H
@@ -0,0 +1,119 @@
+#include "errorlogdialog.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLocale>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+namespace
+{
+    enum Column { ServerColumn, CountColumn, RateColumn, FirstSeenColumn, LastSeenColumn, EntryColumn };
+
+    bool lastSeenFirst(const ErrorLogGroup *a, const ErrorLogGroup *b) { return a->lastSeen > b->lastSeen; }
+
+    // shown as text, sorted by the number
+    class NumberItem : public QTableWidgetItem
+    {
+    public:
+        NumberItem(const QString &text, double value) : QTableWidgetItem(text) { setData(Qt::UserRole, value); }
+
+        bool operator<(const QTableWidgetItem &other) const
+        {
+            return data(Qt::UserRole).toDouble() < other.data(Qt::UserRole).toDouble();
+        }
+    };
+}
+
+ErrorLogDialog::ErrorLogDialog(ErrorLogAggregator *aggregator, QWidget *parent)
+    : QDialog(parent), aggregator(aggregator)
+{
+    // remove question mark from the title bar
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    summaryLabel = new QLabel(this);
+
+    QStringList labels;
+    labels << tr("Server") << tr("Count") << tr("Rate / min") << tr("First seen") << tr("Last seen") << tr("Entry");
+
+    table = new QTableWidget(0, labels.size(), this);
+    table->setHorizontalHeaderLabels(labels);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->verticalHeader()->setVisible(false);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setWordWrap(false);
+    table->setSortingEnabled(true);
+    table->sortByColumn(LastSeenColumn, Qt::DescendingOrder);
+
+    QPushButton *btnClear = new QPushButton(tr("Clear"), this);
+    QPushButton *btnClose = new QPushButton(tr("Close"), this);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(btnClear);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(btnClose);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(new QLabel(aggregator->fileNames().join("\n"), this));
+    mainLayout->addWidget(summaryLabel);
+    mainLayout->addWidget(table);
+    mainLayout->addLayout(buttonLayout);
+    setLayout(mainLayout);
+
+    connect(aggregator, SIGNAL(updated()), this, SLOT(refresh()));
+    connect(btnClear, SIGNAL(clicked()), aggregator, SLOT(clear()));
+    connect(btnClose, SIGNAL(clicked()), this, SLOT(close()));
+
+    setWindowTitle(tr("WPX-XM Server Control Panel - Error Logs"));
+    resize(900, 550);
+
+    refresh();
+    aggregator->scan();
+}
+
+/**
+ * Shows the "MaxRows" most recently seen groups, the sample entry is the tooltip.
+ */
+void ErrorLogDialog::refresh()
+{
+    QLocale locale;
+    QDateTime now = QDateTime::currentDateTime();
+    ErrorLogGroups groups = aggregator->groups();
+
+    QList<const ErrorLogGroup *> recent;
+    quint64 entries = 0;
+    for (ErrorLogGroups::const_iterator it = groups.constBegin(); it != groups.constEnd(); ++it) {
+        recent << &it.value();
+        entries += it.value().count;
+    }
+    std::sort(recent.begin(), recent.end(), lastSeenFirst);
+
+    summaryLabel->setText(
+        tr("%1 entries in %2 groups").arg(locale.toString(entries)).arg(locale.toString(groups.size())));
+
+    int rows = qMin(recent.size(), int(MaxRows));
+
+    table->setSortingEnabled(false);
+    table->setRowCount(rows);
+
+    for (int row = 0; row < rows; ++row) {
+        const ErrorLogGroup *group = recent.at(row);
+        double rate = group->ratePerMinute(now);
+
+        QTableWidgetItem *entry = new QTableWidgetItem(QString::fromUtf8(group->pattern));
+        entry->setToolTip(QString::fromUtf8(group->sample));
+
+        table->setItem(row, ServerColumn, new QTableWidgetItem(group->serverName));
+        table->setItem(row, CountColumn, new NumberItem(locale.toString(group->count), double(group->count)));
+        table->setItem(row, RateColumn, new NumberItem(QString::number(rate, 'f', 1), rate));
+        table->setItem(row, FirstSeenColumn, new QTableWidgetItem(group->firstSeen.toString("yyyy-MM-dd hh:mm:ss")));
+        table->setItem(row, LastSeenColumn, new QTableWidgetItem(group->lastSeen.toString("yyyy-MM-dd hh:mm:ss")));
+        table->setItem(row, EntryColumn, entry);
+    }
+
+    table->setSortingEnabled(true);
+}
@@ -0,0 +1,30 @@
+#ifndef ERRORLOGDIALOG_H
+#define ERRORLOGDIALOG_H
+
+#include "src/logviewer/errorlogaggregator.h"
+
+#include <QDialog>
+#include <QLabel>
+#include <QTableWidget>
+
+/// Shows the grouped entries of the server error logs, most recent first.
+class ErrorLogDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    static const int MaxRows = 500;
+
+    explicit ErrorLogDialog(ErrorLogAggregator *aggregator, QWidget *parent = 0);
+
+private slots:
+    void refresh();
+
+private:
+    ErrorLogAggregator *aggregator;
+
+    QLabel *summaryLabel;
+    QTableWidget *table;
+};
+
+#endif // ERRORLOGDIALOG_H
@@ -0,0 +1,49 @@
+#include "heavyhitters.h"
+
+#include <string.h>
+
+HeavyHitters::HeavyHitters(int capacity)
+    : urls(capacity), urlTimes(capacity), clients(capacity), userAgents(capacity)
+{
+}
+
+void HeavyHitters::add(const AccessLogEntry &entry)
+{
+    LogField uri = entry.uri();
+
+    if (uri.size > 0) {
+        const char *query = static_cast<const char *>(memchr(uri.data, '?', size_t(uri.size)));
+        int size = qMin(int(query ? query - uri.data : uri.size), MaxKeyLength);
+        quint64 hash = Sketches::hash(uri.data, size);
+
+        urls.add(hash, uri.data, size);
+
+        if (entry.requestTimeMs >= 0) {
+            urlTimes.add(hash, uri.data, size, quint64(entry.requestTimeMs));
+        }
+    }
+
+    if (entry.remoteAddr.size > 0) {
+        int size = qMin(entry.remoteAddr.size, MaxKeyLength);
+        quint64 hash = Sketches::hash(entry.remoteAddr.data, size);
+
+        clients.add(hash, entry.remoteAddr.data, size);
+        visitors.add(Sketches::hash(entry.userAgent.data, entry.userAgent.size, hash));
+    }
+
+    if (!entry.userAgent.isEmpty()) {
+        int size = qMin(entry.userAgent.size, MaxKeyLength);
+        userAgents.add(Sketches::hash(entry.userAgent.data, size), entry.userAgent.data, size);
+    }
+}
+
+HeavyHittersReport HeavyHitters::report(int n) const
+{
+    HeavyHittersReport report;
+    report.urlsByCount = urls.top(n);
+    report.urlsByTime = urlTimes.top(n);
+    report.clientIps = clients.top(n);
+    report.userAgents = userAgents.top(n);
+    report.uniqueVisitors = visitors.count();
+    return report;
+}
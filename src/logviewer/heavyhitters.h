@@ -0,0 +1,49 @@
+#ifndef HEAVYHITTERS_H
+#define HEAVYHITTERS_H
+
+#include "src/logviewer/accesslog.h"
+#include "src/logviewer/sketches.h"
+
+#include <QMetaType>
+
+struct HeavyHittersReport
+{
+    HeavyHittersReport() : uniqueVisitors(0) {}
+
+    QList<HeavyHitter> urlsByCount;
+    QList<HeavyHitter> urlsByTime; // count = total request time in ms
+    QList<HeavyHitter> clientIps;
+    QList<HeavyHitter> userAgents;
+    quint64 uniqueVisitors; // distinct client IP and user agent pairs
+};
+
+/// The most requested URLs, the slowest URLs and the busiest clients of an access log.
+/*!
+    The memory is bounded, however many lines and distinct keys the log
+    has: three Space-Saving summaries and a Count-Min sketch with a heap,
+    of "capacity" keys each, and a HyperLogLog for the unique visitors.
+    With the defaults this takes about 2 MB.
+
+    URLs are counted without their query string.
+*/
+class HeavyHitters
+{
+public:
+    static const int MaxKeyLength = 256;
+
+    explicit HeavyHitters(int capacity = 1000);
+
+    void add(const AccessLogEntry &entry);
+    HeavyHittersReport report(int n = 25) const;
+
+private:
+    Sketches::SpaceSaving urls;
+    Sketches::CountMinTop urlTimes;
+    Sketches::SpaceSaving clients;
+    Sketches::SpaceSaving userAgents;
+    Sketches::HyperLogLog visitors;
+};
+
+Q_DECLARE_METATYPE(HeavyHittersReport)
+
+#endif // HEAVYHITTERS_H
@@ -0,0 +1,273 @@
+#include "logfile.h"
+
+#include <QDebug>
+#include <QFileInfo>
+
+#include <string.h>
+
+namespace
+{
+    const qint64 chunkSize = 4 * 1024 * 1024;
+    const qint64 windowSize = 1024 * 1024;
+}
+
+LineIndexer::LineIndexer(const QString &fileName) : QObject(), fileName(fileName), lines(0), position(0) {}
+
+void LineIndexer::index()
+{
+    // opened per call: a rotated log is a new file under the same name
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    qint64 size = file.size();
+
+    if (size < position) {
+        lines = 0;
+        position = 0;
+        emit restarted();
+    }
+
+    qint64 scanned = position;
+    QByteArray buffer;
+
+    while (scanned < size && !QThread::currentThread()->isInterruptionRequested()) {
+        // read, not mapped: a log truncated meanwhile (copytruncate) ends the read,
+        // a mapping would fault (SIGBUS)
+        buffer.resize(int(qMin(chunkSize, size - scanned)));
+        qint64 length = file.seek(scanned) ? file.read(buffer.data(), buffer.size()) : -1;
+        if (length < 0) {
+            qDebug() << "[LogViewer] Reading" << fileName << "failed:" << file.errorString();
+        }
+        if (length <= 0) {
+            return; // a truncated log restarts on the next call
+        }
+
+        const char *chunk = buffer.constData();
+        QVector<qint64> blockStarts;
+        const char *p = chunk;
+        const char *end = chunk + length;
+
+        while (const char *newline = static_cast<const char *>(memchr(p, '\n', size_t(end - p)))) {
+            if (lines % LogFile::IndexStride == 0) {
+                blockStarts.append(position);
+            }
+            ++lines;
+            position = scanned + (newline - chunk) + 1;
+            p = newline + 1;
+        }
+
+        scanned += length;
+
+        emit indexed(blockStarts, lines, position, scanned, size);
+    }
+}
+
+LogFile::LogFile(const QString &fileName, QObject *parent)
+    : QObject(parent), file(fileName), indexer(new LineIndexer(fileName)), completeLines(0), indexedEnd(0),
+      scannedEnd(0), fileSize(0), windowStart(0), windowLength(0)
+{
+    qRegisterMetaType<QVector<qint64>>("QVector<qint64>");
+
+    indexer->moveToThread(&thread);
+    connect(&thread, SIGNAL(finished()), indexer, SLOT(deleteLater()));
+    connect(indexer, SIGNAL(restarted()), this, SLOT(reset()));
+    connect(indexer, SIGNAL(indexed(QVector<qint64>, qint64, qint64, qint64, qint64)), this,
+            SLOT(indexed(QVector<qint64>, qint64, qint64, qint64, qint64)));
+
+    changeTimer.setSingleShot(true);
+    changeTimer.setInterval(10);
+    connect(&changeTimer, SIGNAL(timeout()), indexer, SLOT(index()));
+    connect(&watcher, SIGNAL(fileChanged(QString)), this, SLOT(fileChanged()));
+    connect(&watcher, SIGNAL(directoryChanged(QString)), this, SLOT(directoryChanged()));
+}
+
+LogFile::~LogFile()
+{
+    thread.requestInterruption();
+    thread.quit();
+    thread.wait();
+}
+
+QString LogFile::fileName() const { return file.fileName(); }
+
+qint64 LogFile::size() const { return fileSize; }
+
+qint64 LogFile::indexedSize() const { return scannedEnd; }
+
+/**
+ * The complete lines and the last line, while it is written.
+ */
+qint64 LogFile::lineCount() const { return completeLines + (scannedEnd > indexedEnd ? 1 : 0); }
+
+/**
+ * Starts indexing and watching the file.
+ */
+void LogFile::open()
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "[LogViewer] Opening" << file.fileName() << "failed:" << file.errorString();
+        return;
+    }
+
+    watcher.addPath(file.fileName());
+    watcher.addPath(QFileInfo(file).absolutePath());
+    thread.start(QThread::LowPriority);
+
+    QMetaObject::invokeMethod(indexer, "index", Qt::QueuedConnection);
+}
+
+QString LogFile::line(qint64 row)
+{
+    if (row < 0 || row >= lineCount()) {
+        return QString();
+    }
+
+    qint64 start = indexedEnd;
+    qint64 end = scannedEnd;
+
+    if (row < completeLines) {
+        start = blockStarts.at(int(row / IndexStride));
+        for (qint64 i = row % IndexStride; i > 0; --i) {
+            start = nextLine(start);
+        }
+        end = nextLine(start) - 1;
+    }
+
+    const char *last = end > start ? data(end - 1, 1) : 0;
+    if (last && *last == '\r') {
+        --end;
+    }
+
+    bool cut = end - start > MaxLineLength;
+    qint64 length = qMin<qint64>(end - start, MaxLineLength);
+
+    const char *bytes = data(start, length);
+    if (!bytes) {
+        return QString();
+    }
+
+    QString text = QString::fromUtf8(bytes, int(length));
+    if (cut) {
+        text += QChar(0x2026);
+    }
+    return text;
+}
+
+void LogFile::indexed(const QVector<qint64> &blockStarts, qint64 lines, qint64 position, qint64 scanned,
+                      qint64 size)
+{
+    qint64 oldCount = lineCount();
+
+    this->blockStarts += blockStarts;
+    completeLines = lines;
+    indexedEnd = position;
+    scannedEnd = scanned;
+    fileSize = size;
+
+    emit linesChanged(oldCount, lineCount());
+}
+
+/**
+ * The file was truncated or replaced: the window belongs to the old file.
+ */
+void LogFile::reset()
+{
+    clearWindow();
+
+    file.close();
+    file.open(QIODevice::ReadOnly);
+
+    blockStarts.clear();
+    completeLines = 0;
+    indexedEnd = 0;
+    scannedEnd = 0;
+    fileSize = 0;
+
+    emit restarted();
+}
+
+void LogFile::fileChanged()
+{
+    if (!changeTimer.isActive()) {
+        changeTimer.start();
+    }
+}
+
+/**
+ * A rotated log is created again: the watch follows the name, not the old file.
+ */
+void LogFile::directoryChanged()
+{
+    if (QFileInfo(file.fileName()).exists()) {
+        watcher.removePath(file.fileName());
+        watcher.addPath(file.fileName());
+    }
+
+    fileChanged();
+}
+
+/**
+ * Returns the bytes at offset, reading the window, which contains them.
+ *
+ * The window is read, not mapped: the log might be truncated any time
+ * (copytruncate) and a mapping beyond the end of the file faults (SIGBUS).
+ */
+const char *LogFile::data(qint64 offset, qint64 length)
+{
+    if (windowLength == 0 || offset < windowStart || offset + length > windowStart + windowLength) {
+        clearWindow();
+
+        qint64 start = offset - offset % windowSize;
+        qint64 end = qMin(qMax(start + windowSize, offset + length), scannedEnd);
+
+        if (offset + length > end || !file.seek(start)) {
+            return 0;
+        }
+
+        window = file.read(end - start);
+
+        // truncated since the last scan, the indexer restarts
+        if (window.size() < end - start) {
+            window.clear();
+            return 0;
+        }
+
+        windowStart = start;
+        windowLength = window.size();
+    }
+
+    return window.constData() + (offset - windowStart);
+}
+
+/**
+ * Returns the start of the line after the line at offset.
+ */
+qint64 LogFile::nextLine(qint64 offset)
+{
+    while (offset < indexedEnd) {
+        // reads the window at offset only, if it isn't read yet
+        const char *p = data(offset, 1);
+        if (!p) {
+            break;
+        }
+
+        // a line crossing the end of the window continues in the next one
+        qint64 length = qMin(windowStart + windowLength, indexedEnd) - offset;
+        const char *newline = static_cast<const char *>(memchr(p, '\n', size_t(length)));
+        if (newline) {
+            return offset + (newline - p) + 1;
+        }
+        offset += length;
+    }
+
+    return indexedEnd;
+}
+
+void LogFile::clearWindow()
+{
+    window.clear();
+    windowStart = 0;
+    windowLength = 0;
+}
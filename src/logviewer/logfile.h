@@ -0,0 +1,105 @@
+#ifndef LOGFILE_H
+#define LOGFILE_H
+
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+
+/// Scans a log file for line starts, in a background thread.
+/*!
+    Each call of index() scans only the bytes appended since the last call,
+    chunk by chunk, with memchr(). The start of every
+    LogFile::IndexStride-th line is reported, so the index of a log with
+    50 million lines takes about 6 MB.
+
+    A file, which got smaller (truncated or rotated), is scanned again.
+*/
+class LineIndexer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LineIndexer(const QString &fileName);
+
+public slots:
+    void index();
+
+signals:
+    void restarted();
+    // "position" is the end of the last complete line, "scanned" of the scanned bytes
+    void indexed(const QVector<qint64> &blockStarts, qint64 lines, qint64 position, qint64 scanned, qint64 size);
+
+private:
+    QString fileName;
+    qint64 lines;
+    qint64 position;
+};
+
+/// A log file of any size, with random access to its lines.
+/*!
+    The lines are decoded on demand from a window of the file read into
+    memory, so only the lines a view shows are read. The line index is
+    built and extended by a LineIndexer in a background thread.
+
+    Appended lines are picked up, when the file system reports a change
+    (inotify on Linux, change notifications on Windows): only the new bytes
+    are scanned, the file is never read again. The directory is watched
+    too, for a log, which is rotated and created again.
+*/
+class LogFile : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int IndexStride = 64;
+    static const int MaxLineLength = 4096; // longer lines are cut
+
+    explicit LogFile(const QString &fileName, QObject *parent = 0);
+    ~LogFile();
+
+    QString fileName() const;
+    qint64 size() const;
+    qint64 indexedSize() const;
+    qint64 lineCount() const;
+    QString line(qint64 row);
+
+public slots:
+    void open();
+
+signals:
+    void restarted();
+    void linesChanged(qint64 oldCount, qint64 newCount);
+
+private slots:
+    void indexed(const QVector<qint64> &blockStarts, qint64 lines, qint64 position, qint64 scanned, qint64 size);
+    void reset();
+    void fileChanged();
+    void directoryChanged();
+
+private:
+    QFile file;
+    QFileSystemWatcher watcher;
+    QTimer changeTimer; // coalesces bursts of change notifications
+
+    QThread thread;
+    LineIndexer *indexer;
+
+    QVector<qint64> blockStarts; // start of every IndexStride-th line
+    qint64 completeLines;
+    qint64 indexedEnd;
+    qint64 scannedEnd;
+    qint64 fileSize;
+
+    QByteArray window;
+    qint64 windowStart;
+    qint64 windowLength;
+
+    const char *data(qint64 offset, qint64 length);
+    qint64 nextLine(qint64 offset);
+    void clearWindow();
+};
+
+#endif // LOGFILE_H
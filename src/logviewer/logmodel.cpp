@@ -0,0 +1,51 @@
+#include "logmodel.h"
+
+#include <limits>
+
+namespace
+{
+    // rows are ints, the lines beyond are not shown
+    int toRows(qint64 lines) { return int(qMin<qint64>(lines, std::numeric_limits<int>::max())); }
+}
+
+LogModel::LogModel(LogFile *logFile, QObject *parent) : QAbstractListModel(parent), logFile(logFile), rows(0)
+{
+    connect(logFile, SIGNAL(linesChanged(qint64, qint64)), this, SLOT(linesChanged(qint64, qint64)));
+    connect(logFile, SIGNAL(restarted()), this, SLOT(restarted()));
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const { return parent.isValid() ? 0 : rows; }
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    return logFile->line(index.row());
+}
+
+void LogModel::linesChanged(qint64 oldCount, qint64 newCount)
+{
+    int oldRows = rows;
+    int newRows = toRows(newCount);
+
+    // the last line was still written, it might have grown
+    if (oldCount > 0 && oldRows > 0 && oldRows == toRows(oldCount)) {
+        QModelIndex last = index(oldRows - 1);
+        emit dataChanged(last, last);
+    }
+
+    if (newRows > oldRows) {
+        beginInsertRows(QModelIndex(), oldRows, newRows - 1);
+        rows = newRows;
+        endInsertRows();
+    }
+}
+
+void LogModel::restarted()
+{
+    beginResetModel();
+    rows = 0;
+    endResetModel();
+}
@@ -0,0 +1,32 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+
+#include "src/logviewer/logfile.h"
+
+/// The lines of a LogFile, for a QListView.
+/*!
+    Only the rows a view asks for are decoded, so a view with uniform item
+    sizes reads just the visible lines, whatever the size of the log.
+*/
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit LogModel(LogFile *logFile, QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+private slots:
+    void linesChanged(qint64 oldCount, qint64 newCount);
+    void restarted();
+
+private:
+    LogFile *logFile;
+    int rows;
+};
+
+#endif // LOGMODEL_H
@@ -0,0 +1,78 @@
+#include "logviewerdialog.h"
+
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QLocale>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+LogViewerDialog::LogViewerDialog(const QString &fileName, QWidget *parent) : QDialog(parent)
+{
+    // remove question mark from the title bar
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    logFile = new LogFile(fileName, this);
+    model = new LogModel(logFile, this);
+
+    listView = new QListView(this);
+    listView->setModel(model);
+    // all rows have the same height: the view asks only for the visible rows
+    listView->setUniformItemSizes(true);
+    listView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    listView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    listView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    followCheckBox = new QCheckBox(tr("Follow"), this);
+    followCheckBox->setChecked(true);
+
+    statusLabel = new QLabel(this);
+
+    QPushButton *btnEditor = new QPushButton(tr("Open in Editor"), this);
+    QPushButton *btnClose = new QPushButton(tr("Close"), this);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(followCheckBox);
+    buttonLayout->addWidget(statusLabel, 1);
+    buttonLayout->addWidget(btnEditor);
+    buttonLayout->addWidget(btnClose);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(listView);
+    mainLayout->addLayout(buttonLayout);
+    setLayout(mainLayout);
+
+    connect(model, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(rowsInserted()));
+    connect(logFile, SIGNAL(linesChanged(qint64, qint64)), this, SLOT(updateStatus()));
+    connect(logFile, SIGNAL(restarted()), this, SLOT(updateStatus()));
+    connect(followCheckBox, SIGNAL(toggled(bool)), this, SLOT(rowsInserted()));
+    connect(btnEditor, SIGNAL(clicked()), this, SLOT(editorButtonClicked()));
+    connect(btnClose, SIGNAL(clicked()), this, SLOT(close()));
+
+    setWindowTitle(tr("WPX-XM Server Control Panel - Log Viewer - ") + fileName);
+    resize(900, 600);
+
+    updateStatus();
+    logFile->open();
+}
+
+void LogViewerDialog::rowsInserted()
+{
+    if (followCheckBox->isChecked()) {
+        listView->scrollToBottom();
+    }
+}
+
+void LogViewerDialog::updateStatus()
+{
+    QLocale locale;
+    QString status = tr("%1 lines").arg(locale.toString(logFile->lineCount()));
+
+    if (logFile->indexedSize() < logFile->size()) {
+        status += tr(", indexing %1%").arg(logFile->indexedSize() * 100 / logFile->size());
+    }
+
+    statusLabel->setText(status);
+}
+
+void LogViewerDialog::editorButtonClicked() { emit openInEditor(QUrl::fromLocalFile(logFile->fileName())); }
@@ -0,0 +1,38 @@
+#ifndef LOGVIEWERDIALOG_H
+#define LOGVIEWERDIALOG_H
+
+#include "src/logviewer/logfile.h"
+#include "src/logviewer/logmodel.h"
+
+#include <QCheckBox>
+#include <QDialog>
+#include <QLabel>
+#include <QListView>
+#include <QUrl>
+
+/// Shows a log file of any size and follows its new lines.
+class LogViewerDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit LogViewerDialog(const QString &fileName, QWidget *parent = 0);
+
+signals:
+    void openInEditor(const QUrl &file);
+
+private slots:
+    void rowsInserted();
+    void updateStatus();
+    void editorButtonClicked();
+
+private:
+    LogFile *logFile;
+    LogModel *model;
+
+    QListView *listView;
+    QCheckBox *followCheckBox;
+    QLabel *statusLabel;
+};
+
+#endif // LOGVIEWERDIALOG_H
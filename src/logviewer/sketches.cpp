@@ -0,0 +1,281 @@
+#include "sketches.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace Sketches
+{
+    namespace
+    {
+        int leadingZeros(quint64 v)
+        {
+            if (v == 0) {
+                return 64;
+            }
+
+            // about two steps: the ranks are geometrically distributed
+            int n = 0;
+            while (!(v & Q_UINT64_C(0x8000000000000000))) {
+                v <<= 1;
+                ++n;
+            }
+            return n;
+        }
+
+        bool byCountDescending(const HeavyHitter &a, const HeavyHitter &b) { return a.count > b.count; }
+    }
+
+    /**
+     * FNV-1a, with the bits mixed afterwards: the sketches take their
+     * indexes from the high and the low bits.
+     */
+    quint64 hash(const char *data, int size, quint64 seed)
+    {
+        quint64 h = Q_UINT64_C(14695981039346656037) ^ seed;
+        for (int i = 0; i < size; ++i) {
+            h ^= uchar(data[i]);
+            h *= Q_UINT64_C(1099511628211);
+        }
+        return mix(h);
+    }
+
+    // the finalizer of MurmurHash3
+    quint64 mix(quint64 h)
+    {
+        h ^= h >> 33;
+        h *= Q_UINT64_C(0xff51afd7ed558ccd);
+        h ^= h >> 33;
+        h *= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+        h ^= h >> 33;
+        return h;
+    }
+
+    HyperLogLog::HyperLogLog(int precision) : precision(qBound(4, precision, 18)), registers(1 << this->precision, 0)
+    {
+    }
+
+    void HyperLogLog::add(quint64 hash)
+    {
+        int index = int(hash >> (64 - precision));
+
+        // the position of the first 1 bit of the rest, a guard bit stops at 64 - precision
+        quint64 rest = (hash << precision) | (Q_UINT64_C(1) << (precision - 1));
+        quint8 rank = quint8(leadingZeros(rest) + 1);
+
+        if (registers.at(index) < rank) {
+            registers[index] = rank;
+        }
+    }
+
+    quint64 HyperLogLog::count() const
+    {
+        double m = registers.size();
+        double sum = 0;
+        int zeros = 0;
+
+        for (int i = 0; i < registers.size(); ++i) {
+            sum += ldexp(1.0, -registers.at(i));
+            if (registers.at(i) == 0) {
+                ++zeros;
+            }
+        }
+
+        double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+
+        // linear counting is more accurate for small counts
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * log(m / zeros);
+        }
+
+        return quint64(estimate + 0.5);
+    }
+
+    CountMinSketch::CountMinSketch(int width, int depth) : width(width), depth(depth), counters(width * depth, 0) {}
+
+    quint64 CountMinSketch::add(quint64 hash, quint64 weight)
+    {
+        quint64 estimate = this->estimate(hash) + weight;
+
+        // conservative update: no counter is raised above the new estimate
+        for (int row = 0; row < depth; ++row) {
+            quint64 &counter = counters[row * width + column(hash, row)];
+            if (counter < estimate) {
+                counter = estimate;
+            }
+        }
+
+        return estimate;
+    }
+
+    quint64 CountMinSketch::estimate(quint64 hash) const
+    {
+        quint64 estimate = counters.at(column(hash, 0));
+        for (int row = 1; row < depth; ++row) {
+            estimate = qMin(estimate, counters.at(row * width + column(hash, row)));
+        }
+        return estimate;
+    }
+
+    // the rows use the hashes h1 + row * h2 (Kirsch-Mitzenmacher)
+    int CountMinSketch::column(quint64 hash, int row) const
+    {
+        quint32 h1 = quint32(hash);
+        quint32 h2 = quint32(hash >> 32) | 1;
+        return int((h1 + quint32(row) * h2) % quint32(width));
+    }
+
+    KeyHeap::KeyHeap(int capacity) : maxSize(capacity)
+    {
+        entries.reserve(capacity);
+        hashes.reserve(capacity);
+        heapPositions.reserve(capacity);
+        heap.reserve(capacity);
+        slots.reserve(capacity);
+    }
+
+    int KeyHeap::capacity() const { return maxSize; }
+
+    int KeyHeap::size() const { return heap.size(); }
+
+    int KeyHeap::find(quint64 hash) const { return slots.value(hash, -1); }
+
+    const HeavyHitter &KeyHeap::at(int slot) const { return entries.at(slot); }
+
+    const HeavyHitter &KeyHeap::min() const { return entries.at(heap.at(0).slot); }
+
+    void KeyHeap::insert(quint64 hash, const char *key, int keySize, quint64 count, quint64 error)
+    {
+        HeavyHitter entry;
+        entry.key = QByteArray(key, keySize);
+        entry.count = count;
+        entry.error = error;
+
+        Node node;
+        node.count = count;
+        node.slot = entries.size();
+
+        entries.append(entry);
+        hashes.append(hash);
+        heapPositions.append(heap.size());
+        heap.append(node);
+        slots.insert(hash, node.slot);
+
+        siftUp(heap.size() - 1);
+    }
+
+    void KeyHeap::replaceMin(quint64 hash, const char *key, int keySize, quint64 count, quint64 error)
+    {
+        int slot = heap.at(0).slot;
+
+        slots.remove(hashes.at(slot));
+        slots.insert(hash, slot);
+        hashes[slot] = hash;
+
+        // the buffer of the old key is reused
+        HeavyHitter &entry = entries[slot];
+        entry.key.resize(keySize);
+        memcpy(entry.key.data(), key, size_t(keySize));
+        entry.count = count;
+        entry.error = error;
+
+        heap[0].count = count;
+        siftDown(0);
+    }
+
+    void KeyHeap::increase(int slot, quint64 count)
+    {
+        int pos = heapPositions.at(slot);
+
+        entries[slot].count = count;
+        heap[pos].count = count;
+        siftDown(pos);
+    }
+
+    QList<HeavyHitter> KeyHeap::top(int n) const
+    {
+        QVector<HeavyHitter> sorted = entries;
+        n = qMin(n, sorted.size());
+
+        std::partial_sort(sorted.begin(), sorted.begin() + n, sorted.end(), byCountDescending);
+
+        return sorted.mid(0, n).toList();
+    }
+
+    void KeyHeap::swap(int a, int b)
+    {
+        std::swap(heap[a], heap[b]);
+        heapPositions[heap.at(a).slot] = a;
+        heapPositions[heap.at(b).slot] = b;
+    }
+
+    void KeyHeap::siftUp(int pos)
+    {
+        while (pos > 0) {
+            int parent = (pos - 1) / 2;
+            if (heap.at(parent).count <= heap.at(pos).count) {
+                break;
+            }
+            swap(pos, parent);
+            pos = parent;
+        }
+    }
+
+    void KeyHeap::siftDown(int pos)
+    {
+        for (;;) {
+            int smallest = pos;
+            int left = 2 * pos + 1;
+            int right = left + 1;
+
+            if (left < heap.size() && heap.at(left).count < heap.at(smallest).count) {
+                smallest = left;
+            }
+            if (right < heap.size() && heap.at(right).count < heap.at(smallest).count) {
+                smallest = right;
+            }
+            if (smallest == pos) {
+                break;
+            }
+
+            swap(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+    SpaceSaving::SpaceSaving(int capacity) : heap(capacity) {}
+
+    void SpaceSaving::add(quint64 hash, const char *key, int keySize, quint64 weight)
+    {
+        int slot = heap.find(hash);
+
+        if (slot >= 0) {
+            heap.increase(slot, heap.at(slot).count + weight);
+        } else if (heap.size() < heap.capacity()) {
+            heap.insert(hash, key, keySize, weight, 0);
+        } else {
+            quint64 min = heap.min().count;
+            heap.replaceMin(hash, key, keySize, min + weight, min);
+        }
+    }
+
+    QList<HeavyHitter> SpaceSaving::top(int n) const { return heap.top(n); }
+
+    CountMinTop::CountMinTop(int capacity, int width, int depth) : sketch(width, depth), heap(capacity) {}
+
+    void CountMinTop::add(quint64 hash, const char *key, int keySize, quint64 weight)
+    {
+        quint64 estimate = sketch.add(hash, weight);
+        int slot = heap.find(hash);
+
+        if (slot >= 0) {
+            heap.increase(slot, estimate);
+        } else if (heap.size() < heap.capacity()) {
+            heap.insert(hash, key, keySize, estimate, 0);
+        } else if (estimate > heap.min().count) {
+            heap.replaceMin(hash, key, keySize, estimate, 0);
+        }
+    }
+
+    QList<HeavyHitter> CountMinTop::top(int n) const { return heap.top(n); }
+}
@@ -0,0 +1,141 @@
+#ifndef SKETCHES_H
+#define SKETCHES_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+/// A key with its (estimated) count, "error" is the possible overestimation.
+struct HeavyHitter
+{
+    QByteArray key;
+    quint64 count;
+    quint64 error;
+};
+
+namespace Sketches
+{
+    quint64 hash(const char *data, int size, quint64 seed = 0);
+    quint64 mix(quint64 h);
+
+    /// Counts the distinct hashes with 2^precision registers of a byte.
+    /*!
+        The standard error is 1.04 / sqrt(2^precision), 0.8% for the
+        default precision of 14 (16 KB).
+    */
+    class HyperLogLog
+    {
+    public:
+        explicit HyperLogLog(int precision = 14);
+
+        void add(quint64 hash);
+        quint64 count() const;
+
+    private:
+        int precision;
+        QVector<quint8> registers;
+    };
+
+    /// Estimates the total weight of a hash, never too low.
+    /*!
+        "depth" rows of "width" counters, a weight is added to one counter
+        per row (conservative update: only to the smallest ones). The
+        estimate is the smallest counter, it exceeds the true total by at
+        most 2/width of all weights with a probability of 1 - 2^-depth.
+    */
+    class CountMinSketch
+    {
+    public:
+        CountMinSketch(int width = 16384, int depth = 4);
+
+        quint64 add(quint64 hash, quint64 weight); // returns the new estimate
+        quint64 estimate(quint64 hash) const;
+
+    private:
+        int width;
+        int depth;
+        QVector<quint64> counters;
+
+        int column(quint64 hash, int row) const;
+    };
+
+    /// A min-heap of at most "capacity" keys, with a lookup by hash.
+    /*!
+        The keys stay in their slot, the heap orders (count, slot) pairs: a
+        sift moves 16 bytes and updates no hash table.
+    */
+    class KeyHeap
+    {
+    public:
+        explicit KeyHeap(int capacity);
+
+        int capacity() const;
+        int size() const;
+        int find(quint64 hash) const; // the slot, -1 if not found
+        const HeavyHitter &at(int slot) const;
+        const HeavyHitter &min() const;
+
+        void insert(quint64 hash, const char *key, int keySize, quint64 count, quint64 error);
+        void replaceMin(quint64 hash, const char *key, int keySize, quint64 count, quint64 error);
+        void increase(int slot, quint64 count);
+
+        QList<HeavyHitter> top(int n) const;
+
+    private:
+        QVector<HeavyHitter> entries; // by slot
+        QVector<quint64> hashes; // by slot
+        QVector<int> heapPositions; // by slot
+        struct Node
+        {
+            quint64 count;
+            int slot;
+        };
+
+        QVector<Node> heap;
+        QHash<quint64, int> slots;
+        int maxSize;
+
+        void swap(int a, int b);
+        void siftUp(int pos);
+        void siftDown(int pos);
+    };
+
+    /// The "capacity" most frequent keys of a stream (Space-Saving).
+    /*!
+        A new key replaces the key with the smallest count and inherits its
+        count as "error". Every key with more than 1/capacity of the total
+        weight is kept.
+    */
+    class SpaceSaving
+    {
+    public:
+        explicit SpaceSaving(int capacity = 1000);
+
+        void add(quint64 hash, const char *key, int keySize, quint64 weight = 1);
+        QList<HeavyHitter> top(int n) const;
+
+    private:
+        KeyHeap heap;
+    };
+
+    /// The "capacity" keys with the largest total weight (Count-Min and a heap).
+    /*!
+        The totals are estimated by a CountMinSketch, the heap keeps the
+        keys with the largest estimates.
+    */
+    class CountMinTop
+    {
+    public:
+        explicit CountMinTop(int capacity = 1000, int width = 16384, int depth = 4);
+
+        void add(quint64 hash, const char *key, int keySize, quint64 weight);
+        QList<HeavyHitter> top(int n) const;
+
+    private:
+        CountMinSketch sketch;
+        KeyHeap heap;
+    };
+}
+
+#endif // SKETCHES_H
@@ -5,7 +5,8 @@ namespace ServerControlPanel
 {
 
     MainWindow::MainWindow(QWidget *parent)
-        : QMainWindow(parent), ui(new ServerControlPanel::Ui::MainWindow)
+        : QMainWindow(parent), ui(new ServerControlPanel::Ui::MainWindow),
+          startAllServersRequested(false)
     {
         ui->setupUi(this);
 
@@ -65,6 +66,8 @@ namespace ServerControlPanel
 
         connect(servers, SIGNAL(signalMainWindow_updateVersion(QString)), this,
                 SLOT(updateVersion(QString)));
+        connect(servers->versions, SIGNAL(versionDetected(QString, QString)), this,
+                SLOT(setVersion(QString, QString)));
         connect(servers, SIGNAL(signalMainWindow_updatePort(QString)), this,
                 SLOT(updatePort(QString)));
 
@@ -73,6 +76,23 @@ namespace ServerControlPanel
         connect(servers, SIGNAL(signalMainWindow_EnableToolsPushButtons(bool)), this,
                 SLOT(enableToolsPushButtons(bool)));
 
+        // server state changes, including crashes and manual starts outside of
+        // the control panel, are reflected by the tray icons and messages
+        connect(servers, &Servers::Servers::serverStateChanged, this, &MainWindow::serverStateChanged);
+        connect(servers, &Servers::Servers::serverWarning, this,
+                [this](const QString &serverName, const QString &message) {
+                    tray->showMessage(serverName, message, QSystemTrayIcon::Warning);
+                });
+        connect(servers->orchestrator, SIGNAL(serversStarted()), this, SLOT(allServersStarted()));
+        servers->processMonitor->start();
+        servers->resourceSampler->start();
+
+        // resource usage of the servers, shown as tooltip of the status panel
+        serverUsageTimer = new QTimer(this);
+        serverUsageTimer->setInterval(5000);
+        connect(serverUsageTimer, SIGNAL(timeout()), this, SLOT(updateServerUsage()));
+        serverUsageTimer->start();
+
         // server autostart
         if (settings->get("global/autostartservers").toBool()) {
             qDebug() << "[Servers] Autostart enabled";
@@ -97,6 +117,7 @@ namespace ServerControlPanel
         if (settings->get("global/stopserversonquit").toBool()) {
             qDebug() << "[Servers] Stopping All Servers on Quit...";
             stopAllServers();
+            servers->orchestrator->waitForFinished(settings->get("servers/stoptimeout", 15000).toInt());
         }
 
         delete ui;
@@ -114,13 +135,18 @@ namespace ServerControlPanel
 
     void MainWindow::updateServerStatusIndicators()
     {
-        foreach (Process process, processes->getRunningProcesses())
+        // one snapshot for all servers
+        ProcessSnapshot snapshot = processes->snapshot();
+
+        foreach (const Process &process, snapshot.processes())
         {
-            if(processes->isSystemProcess(process.name)) {
+            QString name = process.name();
+
+            if(processes->isSystemProcess(name)) {
                 continue;
             }
 
-            QString processName = process.name.section(".", 0, 0);
+            QString processName = name.section(".", 0, 0);
 
             QString serverName = servers->getCamelCasedServerName(processName);
 
@@ -137,6 +163,52 @@ namespace ServerControlPanel
         }
     }
 
+    void MainWindow::serverStateChanged(const QString &serverName, Servers::Server::State state)
+    {
+        Servers::Server *server = servers->findServer(serverName);
+
+        if (!server) {
+            return;
+        }
+
+        switch (state) {
+        case Servers::Server::Starting:
+        case Servers::Server::Stopping:
+            server->trayMenu->setIcon(QIcon(":/status_reload"));
+            break;
+        case Servers::Server::Ready:
+            server->trayMenu->setIcon(QIcon(":/status_run"));
+            break;
+        case Servers::Server::Stopped:
+            server->trayMenu->setIcon(QIcon(":/status_stop"));
+            break;
+        case Servers::Server::Failed:
+            server->trayMenu->setIcon(QIcon(":/status_stop"));
+            tray->showMessage(serverName, server->stateReason, QSystemTrayIcon::Warning);
+            break;
+        }
+    }
+
+    void MainWindow::updateServerUsage()
+    {
+        QMap<QString, Servers::ServerUsage> usages = servers->getServersUsage();
+
+        for (QMap<QString, Servers::ServerUsage>::const_iterator it = usages.constBegin();
+             it != usages.constEnd(); ++it) {
+            QString toolTip = it.key() + ": " + it.value().toString();
+
+            QLabel *labelStatus = ui->centralWidget->findChild<QLabel *>("label_" + it.key() + "_Status");
+            if (labelStatus) {
+                labelStatus->setToolTip(toolTip);
+            }
+
+            QLabel *labelName = ui->centralWidget->findChild<QLabel *>("label_" + it.key() + "_Name");
+            if (labelName) {
+                labelName->setToolTip(toolTip);
+            }
+        }
+    }
+
     void MainWindow::runSelfUpdate()
     {
         selfUpdater = new Updater::SelfUpdater();
@@ -206,68 +278,20 @@ namespace ServerControlPanel
         quitAction = new QAction(tr("&Quit"), this);
         connect(quitAction, SIGNAL(triggered()), this, SLOT(quitApplication()));
 
-        // Connect Actions for Status Table - Column Action (Start)
-        connect(ui->centralWidget->findChild<QPushButton *>("pushButton_Start_Nginx"),
-                SIGNAL(clicked()), servers, SLOT(startNginx()));
-        connect(ui->centralWidget->findChild<QPushButton *>("pushButton_Start_PHP"),
-                SIGNAL(clicked()), servers, SLOT(startPHP()));
-        connect(
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Start_MariaDb"),
-            SIGNAL(clicked()), servers, SLOT(startMariaDb()));
-        QPushButton *buttonStartMongoDb =
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Start_MongoDb");
-        if (buttonStartMongoDb != 0) {
-            connect(buttonStartMongoDb, SIGNAL(clicked()), servers,
-                    SLOT(startMongoDb()));
-        }
-        QPushButton *buttonStartMemcached =
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Start_Memcached");
-        if (buttonStartMemcached != 0) {
-            connect(buttonStartMemcached, SIGNAL(clicked()), servers,
-                    SLOT(startMemcached()));
-        }
-        QPushButton *buttonStartPostgreSQL =
-            ui->centralWidget->findChild<QPushButton *>(
-                "pushButton_Start_PostgreSQL");
-        if (buttonStartPostgreSQL != 0) {
-            connect(buttonStartPostgreSQL, SIGNAL(clicked()), servers,
-                    SLOT(startPostgreSQL()));
-        }
-        QPushButton *buttonStartRedis =
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Start_Redis");
-        if (buttonStartRedis != 0) {
-            connect(buttonStartRedis, SIGNAL(clicked()), servers, SLOT(startRedis()));
-        }
-
-        // Connect Actions for Status Table - Column Action (Stop)
-        connect(ui->centralWidget->findChild<QPushButton *>("pushButton_Stop_Nginx"),
-                SIGNAL(clicked()), servers, SLOT(stopNginx()));
-        connect(ui->centralWidget->findChild<QPushButton *>("pushButton_Stop_PHP"),
-                SIGNAL(clicked()), servers, SLOT(stopPHP()));
-        connect(
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Stop_MariaDb"),
-            SIGNAL(clicked()), servers, SLOT(stopMariaDb()));
-        QPushButton *buttonStopMongoDb =
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Stop_MongoDb");
-        if (buttonStopMongoDb != 0) {
-            connect(buttonStopMongoDb, SIGNAL(clicked()), servers, SLOT(stopMongoDb()));
-        }
-        QPushButton *buttonStopMemcached =
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Stop_Memcached");
-        if (buttonStopMemcached != 0) {
-            connect(buttonStopMemcached, SIGNAL(clicked()), servers,
-                    SLOT(stopMemcached()));
-        }
-        QPushButton *buttonStopPostgreSQL =
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Stop_PostgreSQL");
-        if (buttonStopPostgreSQL != 0) {
-            connect(buttonStopPostgreSQL, SIGNAL(clicked()), servers,
-                    SLOT(stopPostgreSQL()));
-        }
-        QPushButton *buttonStopRedis =
-            ui->centralWidget->findChild<QPushButton *>("pushButton_Stop_Redis");
-        if (buttonStopRedis != 0) {
-            connect(buttonStopRedis, SIGNAL(clicked()), servers, SLOT(stopRedis()));
+        // Connect Actions for Status Table - Column Action (Start, Stop)
+        foreach (const QString &name, servers->getListOfServerNames()) {
+            QString serverName = servers->getCamelCasedServerName(name);
+
+            QPushButton *buttonStart =
+                ui->centralWidget->findChild<QPushButton *>("pushButton_Start_" + serverName);
+            if (buttonStart != 0) {
+                connect(buttonStart, SIGNAL(clicked()), this, SLOT(startServerFromPushButton()));
+            }
+            QPushButton *buttonStop =
+                ui->centralWidget->findChild<QPushButton *>("pushButton_Stop_" + serverName);
+            if (buttonStop != 0) {
+                connect(buttonStop, SIGNAL(clicked()), this, SLOT(stopServerFromPushButton()));
+            }
         }
 
         // Connect Actions for Status Table - AllServers Start, Stop
@@ -629,232 +653,61 @@ namespace ServerControlPanel
         if (settings->get("global/stopserversonquit").toBool()) {
             qDebug() << "[Servers] Stopping on Quit...\n";
             stopAllServers();
+            servers->orchestrator->waitForFinished(settings->get("servers/stoptimeout", 15000).toInt());
         }
         qApp->quit();
     }
 
-    QString MainWindow::getNginxVersion()
-    {
-        // this happens only during testing
-        if (!QFile().exists("./bin/nginx/nginx.exe")) {
-            return "0.0.0";
-        }
-
-        QProcess process;
-        process.setProcessChannelMode(QProcess::MergedChannels);
-        process.start("./bin/nginx/nginx.exe -v");
-
-        if (!process.waitForFinished()) {
-            qDebug() << "[Nginx] Version failed:" << process.errorString();
-            return "";
-        }
-
-        QByteArray p_stdout = process.readAll();
-
-        // string for regexp testing
-        // QString p_stdout = "nginx version: nginx/1.2.1";
-
-        qDebug() << "[Nginx] Version: \n"
-                 << p_stdout;
-
-        return parseVersionNumber(p_stdout);
-    }
-
-    QString MainWindow::getMariaVersion()
+    //*
+    //* Action slots
+    //*
+    void MainWindow::startAllServers()
     {
-        // this happens only during testing
-        if (!QFile().exists("./bin/mariadb/bin/mysqld.exe") ||
-            !QFile().exists("./bin/mariadb/bin/mysqlcheck.exe")) {
-            return "0.0.0";
-        }
-
-        QProcess process;
-        process.setProcessChannelMode(QProcess::MergedChannels);
-        process.start("./bin/mariadb/bin/mysqlcheck.exe -V"); // upper-case V
-
-        if (!process.waitForFinished()) {
-            qDebug() << "[MariaDb] Version failed:" << process.errorString();
-            return "";
+        QStringList serverNames;
+        foreach (Servers::Server *server, servers->servers()) {
+            serverNames << server->name;
         }
 
-        QByteArray p_stdout = process.readAll();
-
-        // string for regexp testing
-        // QString p_stdout = ".\\bin\\mariadb\\bin\\mysqlcheck.exe  Ver 15.1 Distrib
-        // 5.5.24-MariaDB, for Win32 (x86)";
-        // QString p_stdout = ".\\bin\\mariadb\\bin\\mysqlcheck.exe  Ver 2.7.4-MariaDB
-        // Distrib 10.1.6-MariaDB, for Win64 (AMD64)\r\n";
-
-        qDebug() << "[MariaDb] Version: \n"
-                 << p_stdout;
-
-        // scrape second version number
-        return parseVersionNumber(p_stdout.mid(p_stdout.lastIndexOf("Distrib "), 15));
+        startAllServersRequested = true;
+        servers->orchestrator->startServers(serverNames);
     }
 
-    QString MainWindow::getPHPVersion()
+    void MainWindow::allServersStarted()
     {
-        // this happens only during testing
-        if (!QFile().exists("./bin/php/php.exe")) {
-            return "0.0.0";
-        }
-
-        QProcess process;
-        process.setProcessChannelMode(QProcess::MergedChannels);
-        process.start("./bin/php/php.exe -v");
-
-        if (!process.waitForFinished()) {
-            qDebug() << "[PHP] Version failed:" << process.errorString();
-            return "";
-        }
-
-        QByteArray p_stdout = process.readAll();
-
-        // string for regexp testing
-        // QString p_stdout = "PHP 5.4.3 (cli) (built: Feb 29 2012 19:06:50)";
-        // QString p_stdout = "PHP 7.0.0alpha2 (cli)  (non semantic version)";
-
-        qDebug() << "[PHP] Version: \n"
-                 << p_stdout;
-
-        // - grab inside "PHP x (cli)"
-        // - "\\d.\\d.\\d." = grab "1.2.3"
-        // - "(\\w+\\d+)?" = grab optional "alpha2" version
-        QRegExp regex("PHP\\s(\\d.\\d.\\d.(\\w+\\d+)?)\\s\\(cli\\)");
-        regex.indexIn(p_stdout);
-
-        return regex.cap(1);
-    }
-
-    QString MainWindow::getMongoVersion()
-    {
-        QProcess process;
-        process.start("./bin/mongodb/bin/mongod.exe --version");
-
-        if (!process.waitForFinished()) {
-            qDebug() << "[MongoDB] Version failed:" << process.errorString();
-            return "";
+        // autostart and tray starts do not open the webinterface
+        if (!startAllServersRequested) {
+            return;
         }
+        startAllServersRequested = false;
 
-        QByteArray p_stdout = process.readLine();
-
-        qDebug() << "[MongoDb] Version: \n"
-                 << p_stdout;
-
-        return parseVersionNumber(p_stdout.mid(3)); // 21
-    }
-
-    QString MainWindow::getPostgresqlVersion()
-    {
-        QProcess process;
-        process.start("./bin/pgsql/bin/pg_ctl.exe -V");
-
-        if (!process.waitForFinished()) {
-            qDebug() << "[PostgreSQL] Version failed:" << process.errorString();
-            return "";
+        if (settings->get("global/OnStartAllOpenWebinterface").toBool()) {
+            openWebinterface();
         }
 
-        QByteArray p_stdout = process.readAll();
-
-        qDebug() << "[PostgreSQL] Version: \n"
-                 << p_stdout;
-
-        return parseVersionNumber(p_stdout.mid(2)); // 10
-    }
-
-    QString MainWindow::getMemcachedVersion()
-    {
-        QProcess process;
-        process.start("./bin/memcached/memcached.exe -h");
-
-        if (!process.waitForFinished()) {
-            qDebug() << "[Memcached] Version failed:" << process.errorString();
-            return "";
+        if (settings->get("global/OnStartAllMinimize").toBool()) {
+            setWindowState(Qt::WindowMinimized);
         }
-
-        QByteArray p_stdout = process.readLine();
-
-        qDebug() << "[Memcached] Version: \n"
-                 << p_stdout;
-
-        return parseVersionNumber(p_stdout.mid(2)); // 10
     }
 
-    QString MainWindow::getRedisVersion()
+    void MainWindow::stopAllServers()
     {
-        QProcess process;
-        process.start("./bin/redis/redis-server.exe -v");
-
-        if (!process.waitForFinished()) {
-            qDebug() << "[Redis] Version failed:" << process.errorString();
-            return "";
+        QStringList serverNames;
+        foreach (Servers::Server *server, servers->servers()) {
+            serverNames << server->name;
         }
 
-        QByteArray p_stdout = process.readLine();
-
-        qDebug() << "[Redis] Version: \n"
-                 << p_stdout;
-
-        // Redis server v=2.8.21 sha
-        return parseVersionNumber(p_stdout);
+        startAllServersRequested = false;
+        servers->orchestrator->stopServers(serverNames);
     }
 
-    QString MainWindow::parseVersionNumber(QString stringWithVersion)
+    void MainWindow::startServerFromPushButton()
     {
-        qDebug() << stringWithVersion;
-
-        // This RegExp matches version numbers: (\d+\.)?(\d+\.)?(\d+\.)?(\*|\d+)
-        // This is the same, but escaped:
-        QRegExp regex("(\\d+\\.)?(\\d+\\.)?(\\d+\\.)?(\\*|\\d+)");
-
-        regex.indexIn(stringWithVersion);
-
-        return regex.cap(0);
-
-        // Leave this for debugging purposes
-        //    int pos = 0;
-        //    while((pos = regex.indexIn(stringWithVersion, pos)) != -1)
-        //    {
-        //        qDebug() << "Match at pos " << pos
-        //                 << " with length " << regex.matchedLength()
-        //                 << ", captured = " <<
-        //                 regex.capturedTexts().at(0).toLatin1().data()
-        //                 << ".\n";
-        //        pos += regex.matchedLength();
-        //    }
+        servers->startServer(getServerNameFromPushButton((QPushButton *)sender()));
     }
 
-    //*
-    //* Action slots
-    //*
-    void MainWindow::startAllServers()
+    void MainWindow::stopServerFromPushButton()
     {
-        servers->startNginx();
-        servers->startPHP();
-        servers->startMariaDb();
-        servers->startMongoDb();
-        servers->startMemcached();
-        servers->startPostgreSQL();
-        servers->startRedis();
-
-        if (settings->get("global/OnStartAllOpenWebinterface").toBool()) {
-            openWebinterface();
-        }
-
-        if (settings->get("global/OnStartAllMinimize").toBool()) {
-            setWindowState(Qt::WindowMinimized);
-        }
-    }
-
-    void MainWindow::stopAllServers()
-    {
-        servers->stopMariaDb();
-        servers->stopPHP();
-        servers->stopNginx();
-        servers->stopMongoDb();
-        servers->stopMemcached();
-        servers->stopPostgreSQL();
-        servers->stopRedis();
+        servers->stopServer(getServerNameFromPushButton((QPushButton *)sender()));
     }
 
     void MainWindow::goToWebsite()
@@ -1041,7 +894,7 @@ namespace ServerControlPanel
 
         // fetch config file for server from the ini
         QString cfgFile =
-            QDir(settings->get(serverName + "/config").toString()).absolutePath();
+            QDir(settings->get(Servers::findDescriptor(serverName)->configKey).toString()).absolutePath();
 
         if (!QFile().exists(cfgFile)) {
             QMessageBox::warning(this, tr("Warning"),
@@ -1097,6 +950,10 @@ namespace ServerControlPanel
             QMessageBox::warning(this, tr("Warning"),
                                  tr("Log file not found: \n") + logfile,
                                  QMessageBox::Yes);
+        } else if (settings->get("global/logviewer", true).toBool()) {
+            LogViewerDialog *viewer = new LogViewerDialog(logfile, this);
+            connect(viewer, SIGNAL(openInEditor(QUrl)), this, SLOT(execEditor(QUrl)));
+            viewer->show();
         } else {
             QDesktopServices::setUrlHandler("file", this, "execEditor");
             // if no UrlHandler is set, this executes the OS-dependend scheme handler
@@ -1183,20 +1040,15 @@ namespace ServerControlPanel
     void MainWindow::autostartServers()
     {
         qDebug() << "[Servers] Autostarting...";
-        if (settings->get("autostart/nginx").toBool())
-            servers->startNginx();
-        if (settings->get("autostart/php").toBool())
-            servers->startPHP();
-        if (settings->get("autostart/mariadb").toBool())
-            servers->startMariaDb();
-        if (settings->get("autostart/mongodb").toBool())
-            servers->startMongoDb();
-        if (settings->get("autostart/memcached").toBool())
-            servers->startMemcached();
-        if (settings->get("autostart/postgresql").toBool())
-            servers->startPostgreSQL();
-        if (settings->get("autostart/redis").toBool())
-            servers->startRedis();
+
+        QStringList serverNames;
+        foreach (Servers::Server *server, servers->servers()) {
+            if (settings->get("autostart/" + server->name.toLower()).toBool()) {
+                serverNames << server->name;
+            }
+        }
+
+        servers->orchestrator->startServers(serverNames);
     }
 
     void MainWindow::setDefaultSettings()
@@ -1550,77 +1402,23 @@ namespace ServerControlPanel
         this->setFixedHeight(ServersBoxBottomY + BottomWidget.height() + 10);
     }
 
-    QString MainWindow::getVersion(QString server)
-    {
-        QString s = server.toLower();
-        if (s == "nginx") {
-            return getNginxVersion();
-        }
-        if (s == "memcached") {
-            return getMemcachedVersion();
-        }
-        if (s == "mongodb") {
-            return getMongoVersion();
-        }
-        if (s == "mariadb") {
-            return getMariaVersion();
-        }
-        if (s == "php") {
-            return getPHPVersion();
-        }
-        if (s == "postgresql") {
-            return getPostgresqlVersion();
-        }
-        if (s == "redis") {
-            return getRedisVersion();
-        }
-
-        qDebug() << "The function for fetching the version for " + s +
-                        " is not implemented, yet.";
+    QString MainWindow::getVersion(QString server) { return servers->versions->version(server); }
 
-        return ":(";
-    }
+    void MainWindow::updateVersion(QString server) { setVersion(server, getVersion(server)); }
 
-    void MainWindow::updateVersion(QString server)
+    /**
+     * Shows the version of a server, e.g. when its detection finished.
+     */
+    void MainWindow::setVersion(const QString &server, const QString &version)
     {
-        QString version = getVersion(server);
-        QLabel *label =
-            qApp->activeWindow()->findChild<QLabel *>("label_" + server + "_Version");
+        // versions are detected in the background, the window might be inactive
+        QLabel *label = ui->centralWidget->findChild<QLabel *>("label_" + server + "_Version");
         if (label != 0) {
             label->setText(version);
         }
     }
 
-    QString MainWindow::getPort(QString server)
-    {
-        QString s = server.toLower();
-        if (s == "nginx") {
-            return getNginxPort();
-        }
-        if (s == "memcached") {
-            return getMemcachedPort();
-        }
-        if (s == "mongodb") {
-            return getMongoPort();
-        }
-        if (s == "mariadb") {
-            return getMariaPort();
-        }
-        if (s == "php") {
-            return getPHPPort();
-        }
-        if (s == "postgresql") {
-            return getPostgresqlPort();
-        }
-        if (s == "redis") {
-            return getRedisPort();
-        }
-
-        qDebug() << "The function for fetching the port for " + s +
-                        " is not implemented, yet.";
-
-        return ":(";
-    }
+    QString MainWindow::getPort(QString server) { return servers->getPort(server); }
 
     void MainWindow::updatePort(QString server)
     {
@@ -1632,38 +1430,6 @@ namespace ServerControlPanel
         }
     }
 
-    QString MainWindow::getNginxPort()
-    {
-        return settings->get("nginx/port").toString();
-    }
-
-    QString MainWindow::getMemcachedPort()
-    {
-        return settings->get("memcached/tcpport").toString();
-    }
-
-    QString MainWindow::getMongoPort()
-    {
-        return settings->get("mongodb/port").toString();
-    }
-
-    QString MainWindow::getMariaPort()
-    {
-        return settings->get("mariadb/port").toString();
-    }
-
-    QString MainWindow::getPHPPort() { return "Pool"; }
-
-    QString MainWindow::getPostgresqlPort()
-    {
-        return settings->get("postgresql/port").toString();
-    }
-
-    QString MainWindow::getRedisPort()
-    {
-        return settings->get("redis/port").toString();
-    }
-
     void MainWindow::on_pushButton_Updater_clicked() { this->openUpdaterDialog(); }
 
     void MainWindow::openUpdaterDialog()
@@ -7,6 +7,7 @@
 #include <QSystemTrayIcon>
 
 #include "config/configurationdialog.h"
+#include "logviewer/logviewerdialog.h"
 #include "processviewer/processes.h"
 #include "processviewer/processviewerdialog.h"
 #include "selfupdater.h"
@@ -34,24 +35,6 @@ namespace ServerControlPanel
 
         void setVisible(bool visible);
 
-        QString getPHPVersion();
-        QString getNginxVersion();
-        QString getMariaVersion();
-        QString getMongoVersion();
-        QString getMemcachedVersion();
-        QString getPostgresqlVersion();
-        QString getRedisVersion();
-
-        QString getPHPPort();
-        QString getNginxPort();
-        QString getMariaPort();
-        QString getMongoPort();
-        QString getMemcachedPort();
-        QString getPostgresqlPort();
-        QString getRedisPort();
-
-        QString parseVersionNumber(QString stringWithVersion);
-
     public slots:
 
         // General Action Slots of the MainWindow
@@ -93,6 +76,7 @@ namespace ServerControlPanel
 
         void setLabelStatusActive(QString label, bool enabled);
         void updateVersion(QString server);
+        void setVersion(const QString &server, const QString &version);
         void updatePort(QString port);
 
         void enableToolsPushButtons(bool enabled);
@@ -124,6 +108,11 @@ namespace ServerControlPanel
         QAction *restoreAction;
         QAction *quitAction;
 
+        QTimer *serverUsageTimer;
+
+        // "start all" from the main window, which opens the webinterface
+        bool startAllServersRequested;
+
         void checkPorts();
         void createActions();
         void createTrayIcon();
@@ -157,6 +146,13 @@ namespace ServerControlPanel
 
         void updateServerStatusIndicators();
 
+        void serverStateChanged(const QString &serverName, Servers::Server::State state);
+        void allServersStarted();
+        void startServerFromPushButton();
+        void stopServerFromPushButton();
+
+        void updateServerUsage();
+
     protected:
         void closeEvent(QCloseEvent *event);
         void changeEvent(QEvent *event);
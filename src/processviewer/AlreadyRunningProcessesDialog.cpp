@@ -27,14 +27,20 @@ void AlreadyRunningProcessesDialog::checkAlreadyRunningServers()
     QGroupBox *groupBox = new QGroupBox(tr("Running Processes"));
     QVBoxLayout *vbox = new QVBoxLayout;
 
-    QList<Process> runningProcessesList =
-        Processes::getInstance()->getRunningProcesses();
+    // the server processes found by areThereAlreadyRunningProcesses(),
+    // one checkbox per executable (taskkill works by image name)
+    QStringList names;
+    foreach (const Process &p, Processes::getMonitoredProcessesList()) {
+        if (!names.contains(p.name())) {
+            names << p.name();
+        }
+    }
 
     // iterate over proccesFoundList and draw a "process shutdown" checkbox for
     // each one
-    foreach (Process p, runningProcessesList) {
+    foreach (const QString &name, names) {
         // create checkbox
-        QCheckBox *checkbox = new QCheckBox(p.name);
+        QCheckBox *checkbox = new QCheckBox(name);
         checkbox->setChecked(true);
         checkbox->setCheckable(true);
         // add checkbox to view
@@ -85,15 +91,18 @@ void AlreadyRunningProcessesDialog::checkAlreadyRunningServers()
         // fetch all checkboxes
         QList<QCheckBox *> allCheckBoxes = dlg->findChildren<QCheckBox *>();
 
+        QStringList killedNames;
+
         // iterate checkbox values
         int c = allCheckBoxes.size();
         for (int i = 0; i < c; ++i) {
             QCheckBox *cb = allCheckBoxes.at(i);
             if (cb->isChecked()) {
                 qDebug() << "[Process Shutdown]" << cb->text();
+                killedNames << cb->text();
 
                 // handle the PostgreSQL PID file deletion, too
-                if (cb->text() == "postgres") {
+                if (ProcessSnapshot::normalizeName(cb->text()) == "postgres") {
                     QString file = QDir::toNativeSeparators(
                         qApp->applicationDirPath() + "/bin/pgsql/data/postmaster.pid");
                     if (QFile().exists(file)) {
@@ -116,8 +125,14 @@ void AlreadyRunningProcessesDialog::checkAlreadyRunningServers()
             delete cb;
         }
 
-        // delay, after process kills
-        Processes::getInstance()->delay(250);
+        // wait, until the killed processes are gone
+        QList<qint64> pids;
+        foreach (const Process &p, Processes::getMonitoredProcessesList()) {
+            if (killedNames.contains(p.name())) {
+                pids << p.pid;
+            }
+        }
+        Processes::waitForExit(pids, 2000);
 
         //}
 
@@ -23,33 +23,37 @@ void AlreadyUsedPortsDialog::checkAlreadyUsedPorts()
 
     QList<PidAndPort> ports = Processes::getInstance()->getPorts();
 
+    // resolve the owners of all ports using one process snapshot
+    ProcessSnapshot processes = Processes::getInstance()->snapshot();
+
     // iterate over ports list and draw a label for each
     foreach (PidAndPort p, ports) {
         // qDebug() << "[Ports] Used: " << p.pid << p.port;
 
-        Process proc = Processes::getInstance()->findByPid(p.pid);
+        Process proc = processes.findByPid(p.pid);
+        QString procName = proc.name();
 
         // create label
-        QLabel *label = new QLabel("Port " + p.port + " used by " + proc.name +
-                                   " (PID " + p.pid + ")");
+        QLabel *label = new QLabel("Port " + QString::number(p.port) + " used by " + procName +
+                                   " (PID " + QString::number(p.pid) + ")");
 
         // filter: skip ports used by chrome
-        if (proc.name == "chrome.exe" || proc.name == "[System Process]" ||
-            proc.name == "svchost.exe") {
+        if (procName == "chrome.exe" || procName == "[System Process]" ||
+            procName == "svchost.exe") {
             continue;
         }
 
         // filter: system pid
-        if (p.pid == "4") {
+        if (p.pid == 4) {
             continue;
         }
 
         // highlight commonly used ports: 80, 8080, 443
-        if (p.port == "80" || p.port == "8080" || p.port == "443") {
+        if (p.port == 80 || p.port == 8080 || p.port == 443) {
             QPalette palette = label->palette();
 
             // check, if it a server from a prior wpnxm run (mark it green)
-            if (QDir::cleanPath(proc.path).contains(QDir::currentPath())) {
+            if (QDir::cleanPath(proc.path()).contains(QDir::currentPath())) {
                 palette.setColor(QPalette::WindowText, Qt::darkGreen);
             } else {
                 // else it's possible port collision (mark it red)
@@ -0,0 +1,81 @@
+#include "porttable.h"
+
+#include <algorithm>
+
+PortTable::PortTable() {}
+
+PortTable::PortTable(const QList<PidAndPort> &entries) : list(entries)
+{
+    byPid.reserve(list.size());
+    byPort.reserve(list.size());
+
+    for (int index = 0; index < list.size(); ++index) {
+        const PidAndPort &entry = list.at(index);
+
+        if (entry.pid >= 0) {
+            byPid.insert(entry.pid, index);
+        }
+        byPort.insert(entry.port, index);
+    }
+}
+
+const QList<PidAndPort> &PortTable::entries() const { return list; }
+
+bool PortTable::isEmpty() const { return list.isEmpty(); }
+
+/**
+ * Returns the local ports used by a process (sorted, without duplicates).
+ */
+QList<quint16> PortTable::ports(qint64 pid) const
+{
+    QList<quint16> ports;
+
+    QMultiHash<qint64, int>::const_iterator it = byPid.constFind(pid);
+    for (; it != byPid.constEnd() && it.key() == pid; ++it) {
+        ports.append(list.at(it.value()).port);
+    }
+
+    std::sort(ports.begin(), ports.end());
+    ports.erase(std::unique(ports.begin(), ports.end()), ports.end());
+
+    return ports;
+}
+
+/**
+ * Returns the ports a process is listening on (sorted, without duplicates).
+ */
+QList<quint16> PortTable::listeningPorts(qint64 pid) const
+{
+    QList<quint16> ports;
+
+    QMultiHash<qint64, int>::const_iterator it = byPid.constFind(pid);
+    for (; it != byPid.constEnd() && it.key() == pid; ++it) {
+        const PidAndPort &entry = list.at(it.value());
+        if (entry.listening) {
+            ports.append(entry.port);
+        }
+    }
+
+    std::sort(ports.begin(), ports.end());
+    ports.erase(std::unique(ports.begin(), ports.end()), ports.end());
+
+    return ports;
+}
+
+/**
+ * Returns the pids of all processes using the local port.
+ */
+QList<qint64> PortTable::owners(quint16 port) const
+{
+    QList<qint64> pids;
+
+    QMultiHash<quint16, int>::const_iterator it = byPort.constFind(port);
+    for (; it != byPort.constEnd() && it.key() == port; ++it) {
+        qint64 pid = list.at(it.value()).pid;
+        if (pid >= 0 && !pids.contains(pid)) {
+            pids.append(pid);
+        }
+    }
+
+    return pids;
+}
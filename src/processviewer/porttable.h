@@ -0,0 +1,59 @@
+#ifndef PORTTABLE_H
+#define PORTTABLE_H
+
+#include <QHash>
+#include <QList>
+
+struct PidAndPort
+{
+    enum Protocol
+    {
+        Tcp,
+        Tcp6,
+        Udp,
+        Udp6
+    };
+
+    qint64 pid; // -1, if the owner is not visible to us
+    quint16 port; // local port
+    quint8 protocol;
+    bool listening; // TCP: LISTEN state, UDP: bound, not connected
+    quint32 rxQueue; // TCP LISTEN: connections waiting for accept()
+};
+
+/// Load of a TCP listener, see Processes::getListenerLoad().
+struct ListenerLoad
+{
+    ListenerLoad() : queued(0), connections(0) {}
+
+    quint32 queued; // connections waiting for accept(), 0 where not available (Windows)
+    quint32 connections; // established connections on the local port, accepted or queued
+};
+
+/// Socket ownership table: which process uses which local port.
+/*!
+    The table is taken once and joined to a process snapshot through
+    the pid index, instead of scanning the socket list for every process.
+    Copies are cheap, because all members are implicitly shared.
+*/
+class PortTable
+{
+public:
+    PortTable();
+    explicit PortTable(const QList<PidAndPort> &entries);
+
+    const QList<PidAndPort> &entries() const;
+    bool isEmpty() const;
+
+    QList<quint16> ports(qint64 pid) const;
+    QList<quint16> listeningPorts(qint64 pid) const;
+    QList<qint64> owners(quint16 port) const;
+
+private:
+    QList<PidAndPort> list;
+
+    QMultiHash<qint64, int> byPid;
+    QMultiHash<quint16, int> byPort;
+};
+
+#endif // PORTTABLE_H
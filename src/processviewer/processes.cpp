@@ -2,6 +2,7 @@
 
 #include <QApplication>
 #include <QDebug>
+#include <QSet>
 #include <QTime>
 
 // initialize static members
@@ -9,6 +10,9 @@ Processes *Processes::theInstance = NULL;
 
 QList<Process> Processes::monitoredProcessesList;
 
+ProcessSnapshot Processes::currentSnapshot;
+QElapsedTimer Processes::currentSnapshotAge;
+
 Processes *Processes::getInstance()
 {
     if (theInstance == NULL) {
@@ -28,33 +32,56 @@ void Processes::release()
 
 Processes::Processes() { }
 
-Process Processes::findByName(const QString &name)
+/**
+ * Returns the shared process snapshot.
+ *
+ * All callers within one tick (snapshotMaxAge) query the same snapshot,
+ * so a sequence of lookups costs one system scan instead of one per lookup.
+ * Actions changing the process list (start, kill) invalidate the snapshot.
+ */
+// static
+ProcessSnapshot Processes::snapshot()
 {
-    QList<Process> processes = getRunningProcesses();
-    Process p;
-    foreach (p, processes) {
-        if (p.pid < 0) {
-            continue; // if negative pid
-        }
-        if (name.contains(p.name)) { // || name == p.name || name + ".exe" == p.name
-            return p; // if executable name matches
-        }
+    if (!currentSnapshotAge.isValid() || currentSnapshotAge.hasExpired(snapshotMaxAge)) {
+        currentSnapshot = takeSnapshot();
+        currentSnapshotAge.start();
     }
-    p.name = "process not found";
-    return p;
+
+    return currentSnapshot;
 }
 
-Process Processes::findByPid(const QString &pid)
-{    
-    QList<Process> processes = getRunningProcesses();
-    Process p;
-    foreach (p, processes) {
-        if (p.pid == pid) {
-            return p;
-        }
-    }
-    p.name = "process not found";
-    return p;
+/**
+ * Takes a fresh snapshot of all running processes.
+ */
+// static
+ProcessSnapshot Processes::takeSnapshot()
+{
+    return ProcessSnapshot(getRunningProcesses());
+}
+
+// static
+void Processes::invalidateSnapshot()
+{
+    currentSnapshotAge.invalidate();
+}
+
+Process Processes::findByName(const QString &name)
+{
+    return snapshot().findByName(name);
+}
+
+Process Processes::findByPid(qint64 pid)
+{
+    return snapshot().findByPid(pid);
+}
+
+/**
+ * Returns all sockets with their owning pid.
+ */
+// static
+QList<PidAndPort> Processes::getPorts()
+{
+    return getPortTable().entries();
 }
 
 QStringList Processes::getProcessNamesToSearchFor()
@@ -75,425 +102,236 @@ QStringList Processes::getProcessNamesToSearchFor()
     return processesToSearch;
 }
 
+/**
+ * Looks for running server processes (from a prior or a foreign run).
+ *
+ * All processes are classified in a single pass over one snapshot:
+ * a process is a server process, if its normalized executable name is one
+ * of the server names, which is one hash lookup of the interned name.
+ * The costs do not grow with the number of supported servers.
+ */
 bool Processes::areThereAlreadyRunningProcesses()
 {
     qDebug() << "[Processes]"
              << "Check for already running processes.";
 
-    QStringList processesToSearch = getProcessNamesToSearchFor();
-
-    // foreach processesToSearch take a look in the runningProcessesList
-    for (int i = 0; i < processesToSearch.size(); ++i) {
-        qDebug() << "Searching for process: "
-                 << processesToSearch.at(i).toLocal8Bit().constData();
-        foreach (Process process, getRunningProcesses())
-        {
-            if(isSystemProcess(process.name)) {
-                continue;
-            }
+    monitoredProcessesList.clear();
 
-            if (process.name.contains(processesToSearch.at(i).toLatin1().constData())) {
-                qDebug() << "Found: " << process.name;
-                monitoredProcessesList.append(process);
-            }
+    foreach (const Process &process, snapshot().processes())
+    {
+        if (isServerProcess(process)) {
+            qDebug() << "Found: " << process.name();
+            monitoredProcessesList.append(process);
         }
     }
 
     return (!monitoredProcessesList.isEmpty());
 }
 
-// static
-bool Processes::isSystemProcess(QString processName)
+QList<Process> Processes::getMonitoredProcessesList()
 {
-    if (processName == "[System Process]" ||
-        processName == "svchost.exe" ||
-        processName == "System" ||
-        processName == "wininit" ||
-        processName == "winlogon" ||
-        processName == "dllhost" ||
-        processName == "csrss")
-    {
-        return true;
-    }
-
-    return false;
+    return monitoredProcessesList;
 }
 
 // static
-QList<Process> Processes::getRunningProcesses()
+bool Processes::isServerProcess(const Process &process)
 {
-    QList<Process> processes;
-
-    PROCESSENTRY32 pe;
-
-    // set the size of the structure before using it
-    pe.dwSize = sizeof(PROCESSENTRY32);
-
-    // take a snapshot of all processes in the system
-    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-
-    if (hSnapshot == INVALID_HANDLE_VALUE) {
-        return processes;
-    }
-
-    BOOL hasNext = Process32First(hSnapshot, &pe);
+    // the ids of the normalized server names, interned once
+    static QSet<quint32> serverNameKeys;
 
-    while (hasNext) {
-        QStringList details = getProcessDetails(pe.th32ProcessID);
-
-        Process p;
-        p.pid = QString::number((int)pe.th32ProcessID);
-        p.ppid = QString::number((int)pe.th32ParentProcessID);
-        p.name = QString::fromWCharArray(pe.szExeFile);
-
-        if (!details.empty()) {
-            p.path = details.at(0);
-            p.memoryUsage = details.at(1);
-
-            // get icon
-            QFileInfo fileInfo = QFileInfo(p.path);
-            QFileIconProvider fileicon;
-            p.icon = fileicon.icon(fileInfo);
+    if (serverNameKeys.isEmpty()) {
+        foreach (const QString &name, getProcessNamesToSearchFor()) {
+            serverNameKeys.insert(ProcessStrings::intern(ProcessSnapshot::normalizeName(name)));
         }
-
-        processes.append(p);
-
-        hasNext = Process32Next(hSnapshot, &pe);
-    }
-
-    CloseHandle(hSnapshot);
-
-    return processes;
-}
-
-// static
-QStringList Processes::getProcessDetails(DWORD processID)
-{
-    QStringList processInfos;
-
-    // init: get a handle to the process
-    HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ,
-                                  FALSE, processID);
-
-    // we will inevitable run into processes that don't let us peek at them,
-    // because we don't have enough rights. including the "System" process,
-    // which is a place-holder for ring0 code. let's move on, nothing to see
-    // there...
-    if (!hProcess) {
-        return processInfos;
     }
 
-    // 0 = get executable path
-    WCHAR szProcessPath[MAX_PATH];
-    DWORD bufSize = MAX_PATH;
-    QueryFullProcessImageNameW(hProcess, 0, (LPWSTR)&szProcessPath, &bufSize);
-    QString processPath = QString::fromUtf16((ushort *)szProcessPath, bufSize);
-    processInfos.append(processPath);
-
-    // 1 - add memory usage
-    PROCESS_MEMORY_COUNTERS pmc;
-    if (GetProcessMemoryInfo(hProcess, &pmc, sizeof(pmc))) {
-        QString memoryUsage = getSizeHumanReadable((float)pmc.WorkingSetSize);
-        processInfos.append(memoryUsage);
-    }
-
-    CloseHandle(hProcess);
-
-    return processInfos;
+    return serverNameKeys.contains(ProcessStrings::nameKey(process.nameId));
 }
 
 // static
-QList<PidAndPort> Processes::getPorts()
+bool Processes::isSystemProcess(QString processName)
 {
-    QList<PidAndPort> ports;
-
-    MIB_TCPTABLE_OWNER_PID *pTCPInfo;
-    MIB_TCPROW_OWNER_PID *owner;
-    DWORD size;
-    DWORD result;
-
-    result = GetExtendedTcpTable(NULL, &size, false, AF_INET,
-                                 TCP_TABLE_OWNER_PID_ALL, 0);
-    pTCPInfo = (MIB_TCPTABLE_OWNER_PID *)malloc(size);
-    result = GetExtendedTcpTable(pTCPInfo, &size, false, AF_INET,
-                                 TCP_TABLE_OWNER_PID_ALL, 0);
-
-    if (result != NO_ERROR) {
-        // qDebug() << "Couldn't get our IP table";
-        return ports;
-    }
-
-    // iterate through tcpinfo table
-    for (DWORD dwLoop = 0; dwLoop < pTCPInfo->dwNumEntries; dwLoop++) {
-        owner = &pTCPInfo->table[dwLoop];
-
-        // The dwLocalPort, and dwRemotePort members are in network byte order.
-        // The ntohs() or inet_ntoa() functions in Windows Sockets or conversion is
-        // needed.
-        // here's a trick, which saves header inclusion headache:
-        long port = (owner->dwLocalPort / 256) + (owner->dwLocalPort % 256) * 256;
-
-        PidAndPort p;
-        p.pid = QString::number(owner->dwOwningPid);
-        p.port = QString::number(port);
-
-        ports.append(p);
+    if (processName == "[System Process]" ||
+        processName == "svchost.exe" ||
+        processName == "System" ||
+        processName == "wininit" ||
+        processName == "winlogon" ||
+        processName == "dllhost" ||
+        processName == "csrss")
+    {
+        return true;
     }
 
-    return ports;
+    return false;
 }
 
 Processes::ProcessState
 Processes::getProcessState(const QString &processName) const
 {
-    Process p = findByName(processName);
+    Process p = snapshot().findByName(processName);
 
-    qDebug("[Processes::getProcessState] %s : %s", processName.toLatin1().constData(), p.name.toLatin1().constData());
+    qDebug("[Processes::getProcessState] %s : %s", processName.toLatin1().constData(),
+           p.isValid() ? p.name().toLatin1().constData() : "process not found");
 
-    return (p.name == "process not found") ? ProcessState::NotRunning : ProcessState::Running;
+    return p.isValid() ? ProcessState::Running : ProcessState::NotRunning;
 }
 
 // static
-bool Processes::killProcess(qint64 pid)
+bool Processes::killProcess(const QString &name)
 {
-    qDebug() << "going to kill process of pid:" << pid;
-
-    HANDLE hProcess;
-
-    hProcess = OpenProcess(PROCESS_ALL_ACCESS | PROCESS_TERMINATE, FALSE, DWORD(pid));
+    Process p = findByName(name);
 
-    if (hProcess == NULL) {
-        qDebug() << "OpenProcess() failed, ecode:" << GetLastError();
+    if (!p.isValid()) {
         return false;
     }
 
-    BOOL result = TerminateProcess(hProcess, 0); // 137 = SIGKILL
+    return killProcess(p.pid);
+}
 
-    CloseHandle(hProcess);
+bool Processes::killProcessTree(const QString &name, int gracePeriodMs)
+{
+    Process p = findByName(name);
 
-    if (result == 0) {
-        qDebug() << "Error. Could not TerminateProcess with PID:" << pid;
+    if (!p.isValid()) {
         return false;
     }
 
-    return true;
+    return killProcessTree(p.pid, gracePeriodMs);
 }
 
+/**
+ * Stops a process and all of its descendants.
+ *
+ * The tree is taken from the shared snapshot, then all processes are
+ * stopped together, see terminateProcesses(). A grace period of 0 kills
+ * them right away. Returns true, if all processes exited.
+ */
 // static
-bool Processes::killProcessTree(qint64 pid)
+bool Processes::killProcessTree(qint64 pid, int gracePeriodMs, QList<KillResult> *results)
 {
     qDebug() << "going to kill process tree of pid:" << pid;
 
-    PROCESSENTRY32 pe;
-    memset(&pe, 0, sizeof(PROCESSENTRY32));
-    pe.dwSize = sizeof(PROCESSENTRY32);
-
-    HANDLE hSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (pid <= 0) {
+        return false;
+    }
 
-    if (Process32First(hSnap, &pe))
-    {
-        BOOL bContinue = TRUE;
-
-        // kill child processes
-        while (bContinue)
-        {
-            // only kill child processes
-            if (pe.th32ParentProcessID == pid)
-            {
-                HANDLE hChildProc = OpenProcess(PROCESS_ALL_ACCESS, FALSE, pe.th32ProcessID);
-
-                if (hChildProc) {
-                    TerminateProcess(hChildProc, 1);
-                    CloseHandle(hChildProc);
-                }
-            }
+    // the parent first, so that it does not respawn its children
+    QList<qint64> pids;
+    pids << pid;
+    foreach (const Process &p, snapshot().descendants(pid)) {
+        pids << p.pid;
+    }
 
-            bContinue = Process32Next(hSnap, &pe);
-        }
+    QList<KillResult> outcomes = terminateProcesses(pids, gracePeriodMs);
 
-        // kill the main process
-        HANDLE hProcess = OpenProcess(PROCESS_ALL_ACCESS, FALSE, pid);
+    if (results) {
+        *results = outcomes;
+    }
 
-        if (hProcess) {
-            TerminateProcess(hProcess, 1);
-            CloseHandle(hProcess);
+    foreach (const KillResult &result, outcomes) {
+        if (result.outcome == KillResult::Failed) {
+            return false;
         }
     }
+
     return true;
 }
 
+/**
+ * Stops processes gracefully, with a deadline.
+ *
+ * All processes get SIGTERM at once and are waited for in parallel.
+ * Processes still running after the grace period get SIGKILL and are
+ * waited for again, up to killTimeoutMs. So stopping a pool of N processes
+ * takes one deadline at most, not N.
+ * Where no graceful signal exists (Windows), processes are killed right away.
+ *
+ * Returns the outcome and the elapsed time for every pid.
+ */
 // static
-bool Processes::killProcess(const QString &name)
-{
-    Process p = findByName(name);
-
-    qint64 pid = (p.pid).toLong();
-
-    return killProcess(pid);
-}
-
-bool Processes::killProcessTree(const QString &name)
+QList<KillResult> Processes::terminateProcesses(const QList<qint64> &pids, int gracePeriodMs, int killTimeoutMs)
 {
-    Process p = findByName(name);
+    QElapsedTimer timer;
+    timer.start();
 
-    return killProcessTree(p.pid.toLong());
-}
+    QList<qint64> pending;
+    QSet<qint64> seen;
+    QSet<qint64> killed;
 
-// static
-QString Processes::getSizeHumanReadable(float bytes)
-{
-    QStringList list;
-    list << "KB"
-         << "MB";
+    foreach (qint64 pid, pids) {
+        if (pid <= 0 || seen.contains(pid)) {
+            continue;
+        }
+        seen.insert(pid);
+        pending << pid;
 
-    QStringListIterator i(list);
-    QString unit("bytes");
+        if (gracePeriodMs > 0 && signalProcess(pid, false)) {
+            continue;
+        }
 
-    while (bytes >= 1024.0 && i.hasNext()) {
-        unit = i.next();
-        bytes /= 1024.0;
+        signalProcess(pid, true);
+        killed.insert(pid);
     }
-    return QString::fromLatin1("%1 %2").arg(bytes, 3, 'f', 1).arg(unit);
-}
-
-// needed for Processes::startDetached.
-// can be removed, when we compile with Qt5.8 where startDetached() is fixed.
-// whenever that happens.
-QString Processes::qt_create_commandline(const QString &program,
-                                         const QStringList &arguments)
-{
-    QString cmd;
 
-    cmd = "C:\\windows\\system32\\cmd.exe /c " + program + QLatin1Char(' ');
+    invalidateSnapshot();
 
-    for (int i = 0; i < arguments.size(); ++i) {
-        cmd += QLatin1Char(' ') + arguments.at(i);
-    }
+    QHash<qint64, qint64> exitedAfterMs;
+    QList<qint64> stillRunning;
 
-    return cmd;
-}
+    // phase 1: the grace period (only killed processes, if there is none)
+    int timeout = (killed.size() == pending.size()) ? killTimeoutMs : gracePeriodMs;
+    waitForExit(pending, timeout, &stillRunning, &exitedAfterMs);
 
-// can be removed, when we compile with Qt5.8 where startDetached() is fixed.
-bool Processes::startDetached(const QString &program,
-                              const QStringList &arguments,
-                              const QString &workingDir)
-{
-    bool success = false;
-    static const DWORD errorElevationRequired = 740;
-    PROCESS_INFORMATION pinfo;
-
-    // the goal is to create a new process, which is able to survive, if the
-    // parent (wpn-xm.exe) is killed
-    // we need DETACHED_PROCESS or CREATE_NEW_PROCESS_GROUP for this.
-
-    // changed to parent-> runs cmd.exe with no window -> runs child -> parent
-    // kills cmd.exe (child gets parentless)
-
-    DWORD dwCreationFlags =
-        CREATE_UNICODE_ENVIRONMENT | CREATE_DEFAULT_ERROR_MODE | CREATE_NO_WINDOW;
-    STARTUPINFOW startupInfo = {sizeof(STARTUPINFO),
-                                0,
-                                0,
-                                0,
-                                (ulong)CW_USEDEFAULT,
-                                (ulong)CW_USEDEFAULT,
-                                (ulong)CW_USEDEFAULT,
-                                (ulong)CW_USEDEFAULT,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0};
-
-    QString cmd =
-        "C:\\windows\\system32\\cmd.exe /c " + program + QLatin1Char(' ');
-
-    for (int i = 0; i < arguments.size(); ++i) {
-        cmd += QLatin1Char(' ') + arguments.at(i);
-    }
+    // phase 2: escalation
+    qint64 escalatedAt = timer.elapsed();
+    QHash<qint64, qint64> killedAfterMs;
 
-    qDebug("[Process::startDetached] \"%s\"", cmd.toLatin1().constData());
+    if (!stillRunning.isEmpty()) {
+        QList<qint64> escalated = stillRunning;
 
-    success =
-        CreateProcess(0, (wchar_t *)cmd.utf16(), 0, 0, FALSE, dwCreationFlags, 0,
-                      workingDir.isEmpty() ? 0 : (wchar_t *)workingDir.utf16(),
-                      &startupInfo, &pinfo);
+        foreach (qint64 pid, escalated) {
+            if (!killed.contains(pid)) {
+                qDebug() << "[Processes] Grace period expired, killing pid:" << pid;
+                signalProcess(pid, true);
+                killed.insert(pid);
+            }
+        }
 
-    if (success) {
-        CloseHandle(pinfo.hThread);
-        CloseHandle(pinfo.hProcess);
+        waitForExit(escalated, killTimeoutMs, 0, &killedAfterMs);
+    }
 
-        // if we have a cmd.exe parent, kill it, so that it's child gets
-        // independent/parentless
-        if (cmd.contains("cmd.exe")) {
-            delay(500);
-            killProcess(pinfo.dwProcessId);
+    QList<KillResult> results;
+
+    foreach (qint64 pid, pending) {
+        KillResult result;
+        result.pid = pid;
+
+        if (exitedAfterMs.contains(pid)) {
+            result.outcome = killed.contains(pid) ? KillResult::Killed : KillResult::Exited;
+            result.elapsedMs = exitedAfterMs.value(pid);
+        } else if (killedAfterMs.contains(pid)) {
+            result.outcome = KillResult::Killed;
+            result.elapsedMs = escalatedAt + killedAfterMs.value(pid);
+        } else {
+            result.outcome = KillResult::Failed;
+            result.elapsedMs = timer.elapsed();
         }
 
-    } else if (GetLastError() == errorElevationRequired) {
-        // startDetachedUacPrompt
-        qDebug() << "[Process::startDetached] errorElevationRequired";
-        success = false;
+        qDebug("[Processes::terminateProcesses] pid %lld: %s after %lld ms", result.pid,
+               result.outcome == KillResult::Exited ? "exited" :
+               result.outcome == KillResult::Killed ? "killed" : "still running",
+               result.elapsedMs);
+
+        results << result;
     }
 
-    return success;
+    return results;
 }
 
-bool Processes::start(const QString &program, const QStringList &arguments, const QString &workingDir)
+// static
+bool Processes::waitForExit(qint64 pid, int timeoutMs)
 {
-    bool success = false;
-
-    static const DWORD errorElevationRequired = 740;
-    PROCESS_INFORMATION pinfo;
-    DWORD dwCreationFlags =
-        CREATE_UNICODE_ENVIRONMENT | CREATE_DEFAULT_ERROR_MODE | CREATE_NO_WINDOW;
-    STARTUPINFOW startupInfo = {sizeof(STARTUPINFO),
-                                0,
-                                0,
-                                0,
-                                (ulong)CW_USEDEFAULT,
-                                (ulong)CW_USEDEFAULT,
-                                (ulong)CW_USEDEFAULT,
-                                (ulong)CW_USEDEFAULT,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0,
-                                0};
-
-    QString cmd = program + QLatin1Char(' ');
-
-    for (int i = 0; i < arguments.size(); ++i) {
-        cmd += QLatin1Char(' ') + arguments.at(i);
-    }
-
-    qDebug("[Process::start] \"%s\"", cmd.toLatin1().constData());
-
-    success =
-        CreateProcess(0, (wchar_t *)cmd.utf16(), 0, 0, FALSE, dwCreationFlags, 0,
-                      workingDir.isEmpty() ? 0 : (wchar_t *)workingDir.utf16(),
-                      &startupInfo, &pinfo);
-
-    if (success) {
-        CloseHandle(pinfo.hThread);
-        CloseHandle(pinfo.hProcess);
-
-    } else if (GetLastError() == errorElevationRequired) {
-        qDebug() << "[Process::start] errorElevationRequired";
-        success = false;
-    }
-
-    return success;
+    return waitForExit(QList<qint64>() << pid, timeoutMs);
 }
 
 void Processes::delay(int millisecondsToWait)
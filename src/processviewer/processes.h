@@ -1,11 +1,16 @@
 #ifndef PROCESSES_H
 #define PROCESSES_H
 
+#include <QElapsedTimer>
 #include <QFileIconProvider>
 #include <QFileInfo>
 #include <QIcon>
 #include <QObject>
 
+#include "porttable.h"
+#include "processsnapshot.h"
+
+#ifdef Q_OS_WIN
 #include <windows.h>
 #include <TlHelp32.h>
 #include <psapi.h>
@@ -14,22 +19,38 @@
 // Need to link with Iphlpapi.lib for GetExtendedTcpTable() used in getPorts()
 #include <iphlpapi.h>
 #pragma comment(lib, "iphlpapi.lib")
+#endif
 
-struct Process
+/// Outcome of stopping one process, see Processes::terminateProcesses().
+struct KillResult
 {
-    QString name; // 1
-    QString path;
-    QString pid; // 2
-    QString ppid;
-    QString port; // 3
-    QString memoryUsage; // 4
-    QIcon icon;
+    enum Outcome
+    {
+        Exited, // exited within the grace period (SIGTERM)
+        Killed, // exited after it was killed (SIGKILL, TerminateProcess)
+        Failed // still running
+    };
+
+    qint64 pid;
+    Outcome outcome;
+    qint64 elapsedMs; // from the first signal until the exit was seen
 };
 
-struct PidAndPort
+/// Raw resource counters of one process, see Processes::getResourceCounters().
+struct ResourceCounters
 {
-    QString pid;
-    QString port;
+    ResourceCounters()
+        : cpuTimeMs(0), rssBytes(0), pssBytes(0), readBytes(0), writeBytes(0), fdCount(0), threadCount(0)
+    {
+    }
+
+    quint64 cpuTimeMs; // user + system time
+    quint64 rssBytes; // resident set size (working set on Windows)
+    quint64 pssBytes; // proportional set size, 0 if not requested or not available
+    quint64 readBytes; // storage I/O since the process started
+    quint64 writeBytes;
+    quint32 fdCount; // open file descriptors (handles on Windows)
+    quint32 threadCount; // 0 if not available
 };
 
 class Processes : public QObject
@@ -49,18 +70,36 @@ public:
     static bool killProcess(qint64 pid);
     static bool killProcess(const QString &name);
 
-    static bool killProcessTree(const QString &name);    
-    static bool killProcessTree(qint64 pid);
+    static bool killProcessTree(const QString &name, int gracePeriodMs = 0);
+    static bool killProcessTree(qint64 pid, int gracePeriodMs = 0, QList<KillResult> *results = 0);
+
+    static QList<KillResult> terminateProcesses(const QList<qint64> &pids, int gracePeriodMs,
+                                                int killTimeoutMs = 2000);
+
+    // SIGTERM or SIGKILL (force), without waiting; false, if there is no
+    // graceful signal (Windows)
+    static bool signalProcess(qint64 pid, bool force);
+    // without reaping or snapshot, a zombie is not alive
+    static bool isAlive(qint64 pid);
 
     static Process findByName(const QString &name);
-    static Process findByPid(const QString &pid);
+    static Process findByPid(qint64 pid);
 
-    static QList<Process> getRunningProcesses();
+    static QVector<Process> getRunningProcesses();
     static QList<PidAndPort> getPorts();
+    static PortTable getPortTable();
+    static bool getListenerLoad(quint16 port, ListenerLoad &load);
+
+    static bool getResourceCounters(qint64 pid, ResourceCounters &counters, bool withPss = false);
+
+    static ProcessSnapshot snapshot();
+    static ProcessSnapshot takeSnapshot();
+    static void invalidateSnapshot();
 
     static bool areThereAlreadyRunningProcesses();
 
     static bool isSystemProcess(QString processName);
+    static bool isServerProcess(const Process &process);
 
     enum ProcessState
     {
@@ -83,6 +122,12 @@ public:
                               const QStringList &arguments);
     static bool startDetached(const QString &command);
 
+    // blocking, see ProcessWaiter for the asynchronous wait
+    static bool waitForExit(const QList<qint64> &pids, int timeoutMs,
+                            QList<qint64> *stillRunning = 0,
+                            QHash<qint64, qint64> *exitedAfterMs = 0);
+    static bool waitForExit(qint64 pid, int timeoutMs);
+
     static void delay(int millisecondsToWait);
 
 private:
@@ -91,8 +136,14 @@ private:
 
     static QList<Process> monitoredProcessesList;
 
-    static QStringList getProcessDetails(DWORD processID);
-    static QString getSizeHumanReadable(float bytes);
+    // the shared snapshot, see snapshot()
+    static ProcessSnapshot currentSnapshot;
+    static QElapsedTimer currentSnapshotAge;
+    static const int snapshotMaxAge = 250; // ms
+
+#ifdef Q_OS_WIN
+    static void getProcessDetails(DWORD processID, Process &process);
+#endif
 
     static QStringList getProcessNamesToSearchFor();
 
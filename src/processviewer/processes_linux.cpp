@@ -0,0 +1,889 @@
+#include "processes.h"
+
+#include <QDebug>
+#include <QProcess>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+/*
+ * Linux backend of the Processes API.
+ *
+ * A snapshot is taken in a single pass over /proc.
+ * Every /proc/<pid> directory is opened exactly once and the files we need
+ * are read relative to that directory handle: "stat" delivers pid, ppid, comm
+ * and RSS in one read, the "exe" link delivers the executable path.
+ * The read buffers live outside of the loop and are reused for all processes.
+ *
+ * The port table is built from /proc/net/{tcp,tcp6,udp,udp6}. These tables
+ * list the socket inode, but not the owner: the inodes are mapped to pids
+ * by a single walk over the /proc/<pid>/fd links of all processes.
+ */
+
+namespace
+{
+    // reads a (small) proc file relative to an open /proc/<pid> directory
+    ssize_t readProcFile(int dirFd, const char *name, char *buffer, size_t size)
+    {
+        int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+
+        ssize_t length = read(fd, buffer, size - 1);
+        close(fd);
+
+        if (length < 0) {
+            return -1;
+        }
+        buffer[length] = '\0';
+        return length;
+    }
+
+    bool isNumeric(const char *name)
+    {
+        if (*name == '\0') {
+            return false;
+        }
+        for (; *name; ++name) {
+            if (*name < '0' || *name > '9') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the stat line is "pid (comm) state ppid pgrp session tty_nr tpgid flags
+    // minflt cminflt majflt cmajflt utime stime cutime cstime priority nice
+    // num_threads itrealvalue starttime vsize rss ..."
+    // comm may contain spaces and parentheses, so we scan from the last ')'.
+    bool parseStat(char *stat, QString &comm, long &ppid, quint64 &startTime, long &rssPages)
+    {
+        char *open = strchr(stat, '(');
+        char *close = strrchr(stat, ')');
+        if (!open || !close || close < open) {
+            return false;
+        }
+
+        comm = QString::fromLocal8Bit(open + 1, int(close - open - 1));
+
+        // field 3 (state) starts two chars after ')'
+        char *field = close + 2;
+        int fieldNumber = 3;
+        ppid = 0;
+        startTime = 0;
+        rssPages = 0;
+
+        while (*field) {
+            if (fieldNumber == 4) {
+                ppid = strtol(field, 0, 10);
+            } else if (fieldNumber == 22) {
+                startTime = strtoull(field, 0, 10);
+            } else if (fieldNumber == 24) {
+                rssPages = strtol(field, 0, 10);
+                return true;
+            }
+            field = strchr(field, ' ');
+            if (!field) {
+                break;
+            }
+            ++field;
+            ++fieldNumber;
+        }
+
+        return fieldNumber > 4;
+    }
+
+    // reads a whole proc file (proc files report a size of 0)
+    bool readWholeFile(const char *path, QByteArray &buffer)
+    {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        if (buffer.size() < 65536) {
+            buffer.resize(65536);
+        }
+
+        int length = 0;
+        for (;;) {
+            if (length == buffer.size()) {
+                buffer.resize(buffer.size() * 2);
+            }
+            ssize_t n = read(fd, buffer.data() + length, size_t(buffer.size() - length));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            length += int(n);
+        }
+
+        close(fd);
+
+        // shrinking keeps the allocation for the next file
+        buffer.resize(length);
+        return true;
+    }
+
+    inline int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+
+    inline quint64 parseHex(const char *&p, const char *end)
+    {
+        quint64 value = 0;
+        int digit;
+        while (p < end && (digit = hexDigit(*p)) >= 0) {
+            value = (value << 4) | quint64(digit);
+            ++p;
+        }
+        return value;
+    }
+
+    inline quint64 parseDecimal(const char *&p, const char *end)
+    {
+        quint64 value = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + quint64(*p - '0');
+            ++p;
+        }
+        return value;
+    }
+
+    inline void skipSpaces(const char *&p, const char *end)
+    {
+        while (p < end && *p == ' ') {
+            ++p;
+        }
+    }
+
+    inline void skipField(const char *&p, const char *end)
+    {
+        while (p < end && *p != ' ') {
+            ++p;
+        }
+        skipSpaces(p, end);
+    }
+
+    /*
+     * Parses a /proc/net/{tcp,tcp6,udp,udp6} table:
+     *
+     *   sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode
+     *    0: 0100007F:0050 00000000:0000 0A 00000000:00000000 00:00000000 00000000  1000        0 21364 ...
+     *
+     * The IPv6 tables have 32 hex digits per address, otherwise the format is
+     * fixed, so we scan the fields in place without splitting the line.
+     */
+    void parseSocketTable(const QByteArray &data, quint8 protocol,
+                          QList<PidAndPort> &entries, QList<quint64> &inodes)
+    {
+        const char *p = data.constData();
+        const char *end = p + data.size();
+
+        // skip the header line
+        const char *lineEnd = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+
+        while (lineEnd && lineEnd + 1 < end) {
+            p = lineEnd + 1;
+            lineEnd = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+            const char *eol = lineEnd ? lineEnd : end;
+
+            skipSpaces(p, eol);
+            skipField(p, eol); // sl
+
+            // local address "ADDRESS:PORT"
+            parseHex(p, eol);
+            if (p >= eol || *p != ':') {
+                continue;
+            }
+            ++p;
+            quint16 port = quint16(parseHex(p, eol));
+            skipSpaces(p, eol);
+
+            skipField(p, eol); // rem_address
+            int state = int(parseHex(p, eol));
+            skipSpaces(p, eol);
+
+            parseHex(p, eol); // tx_queue
+            if (p < eol && *p == ':') {
+                ++p;
+            }
+            quint32 rxQueue = quint32(parseHex(p, eol));
+            skipSpaces(p, eol);
+
+            skipField(p, eol); // tr:tm->when
+            skipField(p, eol); // retrnsmt
+            skipField(p, eol); // uid
+            skipField(p, eol); // timeout
+            quint64 inode = parseDecimal(p, eol);
+
+            // sockets in TIME_WAIT have no inode and no owner
+            if (inode == 0) {
+                continue;
+            }
+
+            bool isTcp = (protocol == PidAndPort::Tcp || protocol == PidAndPort::Tcp6);
+
+            PidAndPort entry;
+            entry.pid = -1;
+            entry.port = port;
+            entry.protocol = protocol;
+            // TCP_LISTEN = 0x0A, an unconnected UDP socket is in TCP_CLOSE = 0x07
+            entry.listening = isTcp ? (state == 0x0A) : (state == 0x07);
+            entry.rxQueue = (isTcp && entry.listening) ? rxQueue : 0;
+
+            entries.append(entry);
+            inodes.append(inode);
+        }
+    }
+
+    /*
+     * Sums the accept queue of the listener and the established connections
+     * on a local port, in the same pass over a /proc/net/tcp table.
+     */
+    void parseListenerLoad(const QByteArray &data, quint16 port, ListenerLoad &load)
+    {
+        const char *p = data.constData();
+        const char *end = p + data.size();
+
+        // skip the header line
+        const char *lineEnd = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+
+        while (lineEnd && lineEnd + 1 < end) {
+            p = lineEnd + 1;
+            lineEnd = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+            const char *eol = lineEnd ? lineEnd : end;
+
+            skipSpaces(p, eol);
+            skipField(p, eol); // sl
+
+            parseHex(p, eol);
+            if (p >= eol || *p != ':') {
+                continue;
+            }
+            ++p;
+            if (quint16(parseHex(p, eol)) != port) {
+                continue;
+            }
+            skipSpaces(p, eol);
+
+            skipField(p, eol); // rem_address
+            int state = int(parseHex(p, eol));
+            skipSpaces(p, eol);
+
+            parseHex(p, eol); // tx_queue
+            if (p < eol && *p == ':') {
+                ++p;
+            }
+            quint32 rxQueue = quint32(parseHex(p, eol));
+
+            // TCP_ESTABLISHED = 0x01, TCP_LISTEN = 0x0A
+            if (state == 0x01) {
+                load.connections++;
+            } else if (state == 0x0A) {
+                load.queued += rxQueue;
+            }
+        }
+    }
+
+    /*
+     * Maps socket inodes to pids in one walk over /proc/<pid>/fd.
+     * The fd directories of foreign processes are not readable,
+     * their sockets stay unresolved (-1).
+     */
+    void resolveSocketOwners(QHash<quint64, qint64> &owners)
+    {
+        int unresolved = owners.size();
+
+        DIR *procDir = opendir("/proc");
+        if (!procDir) {
+            return;
+        }
+
+        int procFd = dirfd(procDir);
+        char fdPath[32];
+        char link[64];
+
+        struct dirent *entry;
+        while (unresolved > 0 && (entry = readdir(procDir)) != NULL) {
+            if (!isNumeric(entry->d_name)) {
+                continue;
+            }
+
+            snprintf(fdPath, sizeof(fdPath), "%s/fd", entry->d_name);
+
+            int fdDirFd = openat(procFd, fdPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fdDirFd < 0) {
+                continue;
+            }
+
+            DIR *fdDir = fdopendir(fdDirFd);
+            if (!fdDir) {
+                close(fdDirFd);
+                continue;
+            }
+
+            qint64 pid = strtoll(entry->d_name, 0, 10);
+
+            struct dirent *fdEntry;
+            while ((fdEntry = readdir(fdDir)) != NULL) {
+                if (fdEntry->d_name[0] == '.') {
+                    continue;
+                }
+
+                ssize_t length = readlinkat(fdDirFd, fdEntry->d_name, link, sizeof(link) - 1);
+
+                // "socket:[12345]"
+                if (length < 10 || memcmp(link, "socket:[", 8) != 0) {
+                    continue;
+                }
+                link[length] = '\0';
+
+                QHash<quint64, qint64>::iterator it = owners.find(strtoull(link + 8, 0, 10));
+                if (it != owners.end() && it.value() < 0) {
+                    it.value() = pid;
+                    --unresolved;
+                }
+            }
+
+            closedir(fdDir); // closes fdDirFd
+        }
+
+        closedir(procDir);
+    }
+
+    // utime + stime (clock ticks), num_threads and rss (pages) of a stat line
+    bool parseStatCounters(char *stat, quint64 &cpuTicks, long &threads, long &rssPages)
+    {
+        char *close = strrchr(stat, ')');
+        if (!close) {
+            return false;
+        }
+
+        char *field = close + 2;
+        int fieldNumber = 3;
+        cpuTicks = 0;
+        threads = 0;
+        rssPages = 0;
+
+        while (*field) {
+            if (fieldNumber == 14 || fieldNumber == 15) {
+                cpuTicks += strtoull(field, 0, 10);
+            } else if (fieldNumber == 20) {
+                threads = strtol(field, 0, 10);
+            } else if (fieldNumber == 24) {
+                rssPages = strtol(field, 0, 10);
+                return true;
+            }
+            field = strchr(field, ' ');
+            if (!field) {
+                break;
+            }
+            ++field;
+            ++fieldNumber;
+        }
+
+        return false;
+    }
+
+    // the value of a "key: value" line, e.g. "Pss:" of smaps_rollup
+    quint64 findValue(const char *buffer, const char *key)
+    {
+        const char *line = buffer;
+        while ((line = strstr(line, key)) != NULL) {
+            if (line == buffer || line[-1] == '\n') {
+                return strtoull(line + strlen(key), 0, 10);
+            }
+            ++line;
+        }
+        return 0;
+    }
+
+    // number of open file descriptors of a process
+    quint32 countFds(int dirFd)
+    {
+        // since Linux 6.2 the size of the fd directory is the number of fds
+        struct stat st;
+        if (fstatat(dirFd, "fd", &st, 0) == 0 && st.st_size > 0) {
+            return quint32(st.st_size);
+        }
+
+        int fdDirFd = openat(dirFd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fdDirFd < 0) {
+            return 0;
+        }
+
+        DIR *fdDir = fdopendir(fdDirFd);
+        if (!fdDir) {
+            close(fdDirFd);
+            return 0;
+        }
+
+        quint32 count = 0;
+        struct dirent *entry;
+        while ((entry = readdir(fdDir)) != NULL) {
+            if (entry->d_name[0] != '.') {
+                ++count;
+            }
+        }
+
+        closedir(fdDir); // closes fdDirFd
+
+        return count;
+    }
+
+    /*
+     * Splits a command line into program arguments, honoring double quotes.
+     * Our callers pass "option value" pairs as one argument (the Windows
+     * backend joins everything into a command line), so we have to split here.
+     */
+    QStringList splitCommandLine(const QString &command)
+    {
+        QStringList args;
+        QString current;
+        bool inQuote = false;
+        bool hasToken = false;
+
+        for (int i = 0; i < command.size(); ++i) {
+            QChar c = command.at(i);
+            if (c == QLatin1Char('"')) {
+                inQuote = !inQuote;
+                hasToken = true;
+            } else if (!inQuote && c.isSpace()) {
+                if (hasToken) {
+                    args << current;
+                    current.clear();
+                    hasToken = false;
+                }
+            } else {
+                current += c;
+                hasToken = true;
+            }
+        }
+        if (hasToken) {
+            args << current;
+        }
+
+        return args;
+    }
+}
+
+// static
+QVector<Process> Processes::getRunningProcesses()
+{
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    static int lastCount = 256;
+
+    QVector<Process> processes;
+    processes.reserve(lastCount);
+
+    DIR *procDir = opendir("/proc");
+    if (!procDir) {
+        qDebug() << "[Processes] Could not open /proc";
+        return processes;
+    }
+
+    int procFd = dirfd(procDir);
+
+    // buffers are reused for every process
+    char statBuffer[1024];
+    char pathBuffer[PATH_MAX];
+    QString comm;
+
+    // the last path and name, most processes share the executable of a sibling
+    QByteArray lastPath;
+    quint32 lastPathId = 0;
+    quint32 lastNameId = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(procDir)) != NULL) {
+        if (!isNumeric(entry->d_name)) {
+            continue;
+        }
+
+        int pidFd = openat(procFd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (pidFd < 0) {
+            continue; // process vanished
+        }
+
+        long ppid = 0;
+        quint64 startTime = 0;
+        long rssPages = 0;
+
+        if (readProcFile(pidFd, "stat", statBuffer, sizeof(statBuffer)) <= 0 ||
+            !parseStat(statBuffer, comm, ppid, startTime, rssPages)) {
+            close(pidFd);
+            continue;
+        }
+
+        // the exe link is not readable for kernel threads and foreign processes
+        ssize_t pathLength = readlinkat(pidFd, "exe", pathBuffer, sizeof(pathBuffer) - 1);
+
+        close(pidFd);
+
+        Process p;
+        p.pid = strtoll(entry->d_name, 0, 10);
+        p.ppid = ppid;
+        p.rssBytes = quint64(rssPages) * quint64(pageSize);
+        p.startTime = startTime;
+
+        if (pathLength > 0) {
+            if (lastPath.size() != pathLength ||
+                memcmp(lastPath.constData(), pathBuffer, size_t(pathLength)) != 0) {
+                lastPath = QByteArray(pathBuffer, int(pathLength));
+                QString path = QString::fromLocal8Bit(lastPath);
+                lastPathId = ProcessStrings::intern(path);
+                // comm is truncated to 15 chars, prefer the basename of the executable
+                lastNameId = ProcessStrings::intern(path.mid(path.lastIndexOf(QLatin1Char('/')) + 1));
+            }
+            p.pathId = lastPathId;
+            p.nameId = lastNameId;
+        } else {
+            p.nameId = ProcessStrings::intern(comm);
+        }
+
+        processes.append(p);
+    }
+
+    closedir(procDir);
+
+    lastCount = processes.size();
+
+    return processes;
+}
+
+// static
+PortTable Processes::getPortTable()
+{
+    static const struct
+    {
+        const char *path;
+        PidAndPort::Protocol protocol;
+    } tables[] = {{"/proc/net/tcp", PidAndPort::Tcp},
+                  {"/proc/net/tcp6", PidAndPort::Tcp6},
+                  {"/proc/net/udp", PidAndPort::Udp},
+                  {"/proc/net/udp6", PidAndPort::Udp6}};
+
+    QList<PidAndPort> entries;
+    QList<quint64> inodes; // parallel to entries
+
+    QByteArray buffer;
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); ++i) {
+        if (readWholeFile(tables[i].path, buffer)) {
+            parseSocketTable(buffer, quint8(tables[i].protocol), entries, inodes);
+        }
+    }
+
+    QHash<quint64, qint64> owners;
+    owners.reserve(inodes.size());
+    foreach (quint64 inode, inodes) {
+        owners.insert(inode, -1);
+    }
+
+    resolveSocketOwners(owners);
+
+    for (int i = 0; i < entries.size(); ++i) {
+        entries[i].pid = owners.value(inodes.at(i), -1);
+    }
+
+    return PortTable(entries);
+}
+
+/**
+ * Reads the load of a local TCP listener: the accept queue (rx_queue of the
+ * LISTEN socket) and the established connections on its port.
+ * Cheap enough for a 1s tick, because the socket owners are not resolved.
+ */
+// static
+bool Processes::getListenerLoad(quint16 port, ListenerLoad &load)
+{
+    load = ListenerLoad();
+
+    QByteArray buffer;
+    bool found = false;
+
+    const char *tables[] = {"/proc/net/tcp", "/proc/net/tcp6"};
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); ++i) {
+        if (readWholeFile(tables[i], buffer)) {
+            parseListenerLoad(buffer, port, load);
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+/**
+ * Reads the resource counters of a process.
+ *
+ * "stat" delivers CPU time, threads and RSS, "io" the storage I/O and the
+ * "fd" directory the number of open files. The PSS is read from
+ * "smaps_rollup" on request only: the kernel walks all page tables of the
+ * process to produce it, which is too expensive for every sample.
+ * Returns false, if the process is gone.
+ */
+// static
+bool Processes::getResourceCounters(qint64 pid, ResourceCounters &counters, bool withPss)
+{
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+
+    if (pid <= 0) {
+        return false;
+    }
+
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%lld", (long long)pid);
+
+    int pidFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (pidFd < 0) {
+        return false;
+    }
+
+    char buffer[4096];
+    quint64 cpuTicks = 0;
+    long threads = 0;
+    long rssPages = 0;
+
+    if (readProcFile(pidFd, "stat", buffer, sizeof(buffer)) <= 0 ||
+        !parseStatCounters(buffer, cpuTicks, threads, rssPages)) {
+        close(pidFd);
+        return false;
+    }
+
+    counters = ResourceCounters();
+    counters.cpuTimeMs = cpuTicks * 1000 / quint64(ticksPerSecond);
+    counters.threadCount = quint32(threads);
+    counters.rssBytes = quint64(rssPages) * quint64(pageSize);
+
+    // "io" and "fd" are not readable for processes of other users
+    if (readProcFile(pidFd, "io", buffer, sizeof(buffer)) > 0) {
+        counters.readBytes = findValue(buffer, "read_bytes:");
+        counters.writeBytes = findValue(buffer, "write_bytes:");
+    }
+
+    counters.fdCount = countFds(pidFd);
+
+    if (withPss && readProcFile(pidFd, "smaps_rollup", buffer, sizeof(buffer)) > 0) {
+        counters.pssBytes = findValue(buffer, "Pss:") * 1024; // kB
+    }
+
+    close(pidFd);
+
+    return true;
+}
+
+// static
+bool Processes::killProcess(qint64 pid)
+{
+    qDebug() << "going to kill process of pid:" << pid;
+
+    // never signal a process group (pid 0) or all processes (pid -1)
+    if (pid <= 0) {
+        return false;
+    }
+
+    invalidateSnapshot();
+
+    if (::kill(pid_t(pid), SIGKILL) != 0) {
+        qDebug() << "Error. Could not kill process with PID:" << pid << strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+// static
+bool Processes::signalProcess(qint64 pid, bool force)
+{
+    // never signal a process group (pid 0) or all processes (pid -1)
+    if (pid <= 0) {
+        return false;
+    }
+
+    return ::kill(pid_t(pid), force ? SIGKILL : SIGTERM) == 0;
+}
+
+/**
+ * A zombie has exited, it only waits for its parent to collect the exit
+ * status. Nothing is reaped here, the exit status belongs to the parent.
+ */
+// static
+bool Processes::isAlive(qint64 pid)
+{
+    if (pid <= 0 || (::kill(pid_t(pid), 0) != 0 && errno != EPERM)) {
+        return false;
+    }
+
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%lld/stat", static_cast<long long>(pid));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    char stat[512];
+    ssize_t length = read(fd, stat, sizeof(stat) - 1);
+    close(fd);
+
+    if (length <= 0) {
+        return false;
+    }
+    stat[length] = '\0';
+
+    // "pid (comm) S ...", comm might contain spaces and parentheses
+    const char *paren = strrchr(stat, ')');
+    char state = (paren && paren[1] == ' ') ? paren[2] : 'R';
+
+    return state != 'Z' && state != 'X';
+}
+
+/**
+ * Waits until all processes exited or the timeout expired. Blocks, no events
+ * are processed: for the CLI and the startup, the GUI waits with a
+ * ProcessWaiter.
+ *
+ * Every process is watched with a pidfd, all of them are waited for with one
+ * poll() call, so the wait ends the moment the last process is gone.
+ * Kernels without pidfd (< 5.3) fall back to probing the pids every 10 ms.
+ * Returns true, if all processes exited. The optional exitedAfterMs receives
+ * the time of each exit, relative to the call.
+ */
+// static
+bool Processes::waitForExit(const QList<qint64> &pids, int timeoutMs, QList<qint64> *stillRunning,
+                            QHash<qint64, qint64> *exitedAfterMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<struct pollfd> fds;
+    QVector<qint64> fdPids; // parallel to fds
+    QList<qint64> probed; // no pidfd available
+
+    foreach (qint64 pid, pids) {
+        if (pid <= 0) {
+            continue;
+        }
+
+        int fd = int(syscall(SYS_pidfd_open, pid_t(pid), 0));
+        if (fd >= 0) {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            fds.append(pfd);
+            fdPids.append(pid);
+        } else if (errno == ESRCH) {
+            // already gone
+            if (exitedAfterMs) {
+                exitedAfterMs->insert(pid, timer.elapsed());
+            }
+        } else {
+            probed.append(pid);
+        }
+    }
+
+    for (;;) {
+        for (int i = probed.size() - 1; i >= 0; --i) {
+            if (!isAlive(probed.at(i))) {
+                if (exitedAfterMs) {
+                    exitedAfterMs->insert(probed.at(i), timer.elapsed());
+                }
+                probed.removeAt(i);
+            }
+        }
+
+        if (fds.isEmpty() && probed.isEmpty()) {
+            break;
+        }
+
+        // a timeout of 0 checks the pidfds once
+        qint64 remaining = qMax<qint64>(timeoutMs - timer.elapsed(), 0);
+
+        // the probed pids are checked again after 10 ms
+        int slice = int(probed.isEmpty() ? remaining : qMin<qint64>(remaining, 10));
+
+        if (::poll(fds.data(), nfds_t(fds.size()), slice) > 0) {
+            for (int i = fds.size() - 1; i >= 0; --i) {
+                if (fds.at(i).revents != 0) {
+                    close(fds.at(i).fd);
+                    if (exitedAfterMs) {
+                        exitedAfterMs->insert(fdPids.at(i), timer.elapsed());
+                    }
+                    fds.remove(i);
+                    fdPids.remove(i);
+                }
+            }
+        }
+
+        if (timer.elapsed() >= timeoutMs) {
+            break;
+        }
+    }
+
+    QList<qint64> running = probed;
+    for (int i = 0; i < fds.size(); ++i) {
+        close(fds.at(i).fd);
+        running.append(fdPids.at(i));
+    }
+
+    if (stillRunning) {
+        *stillRunning = running;
+    }
+
+    invalidateSnapshot();
+
+    return running.isEmpty();
+}
+
+bool Processes::startDetached(const QString &program,
+                              const QStringList &arguments,
+                              const QString &workingDir)
+{
+    QStringList args = splitCommandLine(arguments.join(QLatin1Char(' ')));
+
+    qDebug("[Process::startDetached] \"%s %s\"", program.toLatin1().constData(),
+           args.join(QLatin1Char(' ')).toLatin1().constData());
+
+    invalidateSnapshot();
+
+    return QProcess::startDetached(program, args, workingDir);
+}
+
+bool Processes::start(const QString &program, const QStringList &arguments, const QString &workingDir)
+{
+    QStringList args = splitCommandLine(arguments.join(QLatin1Char(' ')));
+
+    qDebug("[Process::start] \"%s %s\"", program.toLatin1().constData(),
+           args.join(QLatin1Char(' ')).toLatin1().constData());
+
+    invalidateSnapshot();
+
+    return QProcess::startDetached(program, args, workingDir);
+}
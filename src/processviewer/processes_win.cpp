@@ -0,0 +1,499 @@
+#include "processes.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+// static
+QVector<Process> Processes::getRunningProcesses()
+{
+    QVector<Process> processes;
+
+    PROCESSENTRY32 pe;
+
+    // set the size of the structure before using it
+    pe.dwSize = sizeof(PROCESSENTRY32);
+
+    // take a snapshot of all processes in the system
+    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+
+    if (hSnapshot == INVALID_HANDLE_VALUE) {
+        return processes;
+    }
+
+    BOOL hasNext = Process32First(hSnapshot, &pe);
+
+    while (hasNext) {
+        Process p;
+        p.pid = qint64(pe.th32ProcessID);
+        p.ppid = qint64(pe.th32ParentProcessID);
+        p.nameId = ProcessStrings::intern(QString::fromWCharArray(pe.szExeFile));
+
+        getProcessDetails(pe.th32ProcessID, p);
+
+        processes.append(p);
+
+        hasNext = Process32Next(hSnapshot, &pe);
+    }
+
+    CloseHandle(hSnapshot);
+
+    return processes;
+}
+
+// static
+void Processes::getProcessDetails(DWORD processID, Process &process)
+{
+    // init: get a handle to the process
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ,
+                                  FALSE, processID);
+
+    // we will inevitable run into processes that don't let us peek at them,
+    // because we don't have enough rights. including the "System" process,
+    // which is a place-holder for ring0 code. let's move on, nothing to see
+    // there...
+    if (!hProcess) {
+        return;
+    }
+
+    // executable path
+    WCHAR szProcessPath[MAX_PATH];
+    DWORD bufSize = MAX_PATH;
+    if (QueryFullProcessImageNameW(hProcess, 0, (LPWSTR)&szProcessPath, &bufSize)) {
+        process.pathId = ProcessStrings::intern(QString::fromUtf16((ushort *)szProcessPath, bufSize));
+    }
+
+    // memory usage
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(hProcess, &pmc, sizeof(pmc))) {
+        process.rssBytes = quint64(pmc.WorkingSetSize);
+    }
+
+    CloseHandle(hProcess);
+}
+
+// static
+PortTable Processes::getPortTable()
+{
+    QList<PidAndPort> ports;
+
+    MIB_TCPTABLE_OWNER_PID *pTCPInfo;
+    MIB_TCPROW_OWNER_PID *owner;
+    DWORD size = 0;
+    DWORD result;
+
+    result = GetExtendedTcpTable(NULL, &size, false, AF_INET,
+                                 TCP_TABLE_OWNER_PID_ALL, 0);
+    pTCPInfo = (MIB_TCPTABLE_OWNER_PID *)malloc(size);
+    result = GetExtendedTcpTable(pTCPInfo, &size, false, AF_INET,
+                                 TCP_TABLE_OWNER_PID_ALL, 0);
+
+    if (result != NO_ERROR) {
+        // qDebug() << "Couldn't get our IP table";
+        free(pTCPInfo);
+        return PortTable(ports);
+    }
+
+    // iterate through tcpinfo table
+    for (DWORD dwLoop = 0; dwLoop < pTCPInfo->dwNumEntries; dwLoop++) {
+        owner = &pTCPInfo->table[dwLoop];
+
+        // The dwLocalPort, and dwRemotePort members are in network byte order.
+        // The ntohs() or inet_ntoa() functions in Windows Sockets or conversion is
+        // needed.
+        // here's a trick, which saves header inclusion headache:
+        long port = (owner->dwLocalPort / 256) + (owner->dwLocalPort % 256) * 256;
+
+        PidAndPort p;
+        p.pid = qint64(owner->dwOwningPid);
+        p.port = quint16(port);
+        p.protocol = PidAndPort::Tcp;
+        p.listening = (owner->dwState == MIB_TCP_STATE_LISTEN);
+        p.rxQueue = 0;
+
+        ports.append(p);
+    }
+
+    free(pTCPInfo);
+
+    return PortTable(ports);
+}
+
+/**
+ * Reads the load of a local TCP listener.
+ * Windows does not expose the accept queue: "queued" stays 0 and
+ * "connections" includes the connections waiting for accept().
+ */
+// static
+bool Processes::getListenerLoad(quint16 port, ListenerLoad &load)
+{
+    load = ListenerLoad();
+
+    DWORD size = 0;
+    GetExtendedTcpTable(NULL, &size, false, AF_INET, TCP_TABLE_BASIC_CONNECTIONS, 0);
+
+    MIB_TCPTABLE *table = (MIB_TCPTABLE *)malloc(size);
+    if (GetExtendedTcpTable(table, &size, false, AF_INET, TCP_TABLE_BASIC_CONNECTIONS, 0) != NO_ERROR) {
+        free(table);
+        return false;
+    }
+
+    for (DWORD i = 0; i < table->dwNumEntries; i++) {
+        const MIB_TCPROW &row = table->table[i];
+
+        // network byte order, see getPortTable()
+        quint16 localPort = quint16((row.dwLocalPort / 256) + (row.dwLocalPort % 256) * 256);
+
+        if (localPort == port && row.dwState == MIB_TCP_STATE_ESTAB) {
+            load.connections++;
+        }
+    }
+
+    free(table);
+
+    return true;
+}
+
+/**
+ * Reads the resource counters of a process.
+ *
+ * There is no proportional set size and no cheap thread count on Windows,
+ * pssBytes and threadCount stay 0. The I/O counters include all I/O of the
+ * process (files, pipes, network), not only storage I/O.
+ * Returns false, if the process is gone or not accessible.
+ */
+// static
+bool Processes::getResourceCounters(qint64 pid, ResourceCounters &counters, bool withPss)
+{
+    Q_UNUSED(withPss)
+
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, DWORD(pid));
+
+    if (!hProcess) {
+        return false;
+    }
+
+    counters = ResourceCounters();
+
+    // times are in 100 ns units
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(hProcess, &creationTime, &exitTime, &kernelTime, &userTime)) {
+        ULARGE_INTEGER kernel, user;
+        kernel.LowPart = kernelTime.dwLowDateTime;
+        kernel.HighPart = kernelTime.dwHighDateTime;
+        user.LowPart = userTime.dwLowDateTime;
+        user.HighPart = userTime.dwHighDateTime;
+        counters.cpuTimeMs = (kernel.QuadPart + user.QuadPart) / 10000;
+    }
+
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(hProcess, &pmc, sizeof(pmc))) {
+        counters.rssBytes = quint64(pmc.WorkingSetSize);
+    }
+
+    IO_COUNTERS io;
+    if (GetProcessIoCounters(hProcess, &io)) {
+        counters.readBytes = quint64(io.ReadTransferCount);
+        counters.writeBytes = quint64(io.WriteTransferCount);
+    }
+
+    DWORD handleCount = 0;
+    if (GetProcessHandleCount(hProcess, &handleCount)) {
+        counters.fdCount = quint32(handleCount);
+    }
+
+    CloseHandle(hProcess);
+
+    return true;
+}
+
+// static
+bool Processes::isAlive(qint64 pid)
+{
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, DWORD(pid));
+    if (!hProcess) {
+        // not accessible, but running (ERROR_INVALID_PARAMETER: no such process)
+        return GetLastError() != ERROR_INVALID_PARAMETER;
+    }
+
+    DWORD exitCode = 0;
+    bool alive = GetExitCodeProcess(hProcess, &exitCode) && exitCode == STILL_ACTIVE;
+
+    CloseHandle(hProcess);
+
+    return alive;
+}
+
+// static
+bool Processes::killProcess(qint64 pid)
+{
+    qDebug() << "going to kill process of pid:" << pid;
+
+    HANDLE hProcess;
+
+    hProcess = OpenProcess(PROCESS_ALL_ACCESS | PROCESS_TERMINATE, FALSE, DWORD(pid));
+
+    if (hProcess == NULL) {
+        qDebug() << "OpenProcess() failed, ecode:" << GetLastError();
+        return false;
+    }
+
+    BOOL result = TerminateProcess(hProcess, 0); // 137 = SIGKILL
+
+    CloseHandle(hProcess);
+
+    invalidateSnapshot();
+
+    if (result == 0) {
+        qDebug() << "Error. Could not TerminateProcess with PID:" << pid;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Windows has no SIGTERM for console processes without a window
+ * (nginx, php-cgi, ...), so only the forced termination is supported.
+ */
+// static
+bool Processes::signalProcess(qint64 pid, bool force)
+{
+    if (pid <= 0 || !force) {
+        return false;
+    }
+
+    HANDLE hProcess = OpenProcess(PROCESS_TERMINATE, FALSE, DWORD(pid));
+
+    if (!hProcess) {
+        return false;
+    }
+
+    BOOL result = TerminateProcess(hProcess, 1);
+
+    CloseHandle(hProcess);
+
+    return result != 0;
+}
+
+/**
+ * Waits until all processes exited or the timeout expired.
+ *
+ * The process handles are waited for with WaitForMultipleObjects
+ * (in chunks of MAXIMUM_WAIT_OBJECTS), so the wait ends the moment the last
+ * process is gone. Blocks, no events are processed: for the CLI and the
+ * startup, the GUI waits with a ProcessWaiter.
+ * Returns true, if all processes exited.
+ * The optional exitedAfterMs receives the time of each exit, relative to the call.
+ */
+// static
+bool Processes::waitForExit(const QList<qint64> &pids, int timeoutMs, QList<qint64> *stillRunning,
+                            QHash<qint64, qint64> *exitedAfterMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<HANDLE> handles;
+    QVector<qint64> handlePids; // parallel to handles
+    QList<qint64> running;
+
+    foreach (qint64 pid, pids) {
+        HANDLE hProcess = OpenProcess(SYNCHRONIZE, FALSE, DWORD(pid));
+        if (hProcess) {
+            handles.append(hProcess);
+            handlePids.append(pid);
+        } else if (GetLastError() != ERROR_INVALID_PARAMETER) {
+            // not accessible, but running (ERROR_INVALID_PARAMETER: no such process)
+            running.append(pid);
+        } else if (exitedAfterMs) {
+            exitedAfterMs->insert(pid, timer.elapsed());
+        }
+    }
+
+    while (!handles.isEmpty()) {
+        // a timeout of 0 checks the handles once
+        qint64 remaining = qMax<qint64>(timeoutMs - timer.elapsed(), 0);
+
+        // more handles than one wait takes: the chunks take turns
+        DWORD slice = DWORD(handles.size() > MAXIMUM_WAIT_OBJECTS ? qMin<qint64>(remaining, 50) : remaining);
+
+        for (int offset = 0; offset < handles.size();) {
+            DWORD count = DWORD(qMin(handles.size() - offset, int(MAXIMUM_WAIT_OBJECTS)));
+            DWORD result = WaitForMultipleObjects(count, handles.constData() + offset, FALSE,
+                                                  offset == 0 ? slice : 0);
+
+            if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + count) {
+                int index = offset + int(result - WAIT_OBJECT_0);
+                if (exitedAfterMs) {
+                    exitedAfterMs->insert(handlePids.at(index), timer.elapsed());
+                }
+                CloseHandle(handles.at(index));
+                handles.remove(index);
+                handlePids.remove(index);
+                continue; // the same chunk again, more processes might have exited
+            }
+
+            offset += int(count);
+        }
+
+        if (timer.elapsed() >= timeoutMs) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < handles.size(); ++i) {
+        CloseHandle(handles.at(i));
+        running.append(handlePids.at(i));
+    }
+
+    if (stillRunning) {
+        *stillRunning = running;
+    }
+
+    invalidateSnapshot();
+
+    return running.isEmpty();
+}
+
+// needed for Processes::startDetached.
+// can be removed, when we compile with Qt5.8 where startDetached() is fixed.
+// whenever that happens.
+QString Processes::qt_create_commandline(const QString &program,
+                                         const QStringList &arguments)
+{
+    QString cmd;
+
+    cmd = "C:\\windows\\system32\\cmd.exe /c " + program + QLatin1Char(' ');
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        cmd += QLatin1Char(' ') + arguments.at(i);
+    }
+
+    return cmd;
+}
+
+// can be removed, when we compile with Qt5.8 where startDetached() is fixed.
+bool Processes::startDetached(const QString &program,
+                              const QStringList &arguments,
+                              const QString &workingDir)
+{
+    bool success = false;
+    static const DWORD errorElevationRequired = 740;
+    PROCESS_INFORMATION pinfo;
+
+    // the goal is to create a new process, which is able to survive, if the
+    // parent (wpn-xm.exe) is killed
+    // we need DETACHED_PROCESS or CREATE_NEW_PROCESS_GROUP for this.
+
+    // changed to parent-> runs cmd.exe with no window -> runs child -> parent
+    // kills cmd.exe (child gets parentless)
+
+    DWORD dwCreationFlags =
+        CREATE_UNICODE_ENVIRONMENT | CREATE_DEFAULT_ERROR_MODE | CREATE_NO_WINDOW;
+    STARTUPINFOW startupInfo = {sizeof(STARTUPINFO),
+                                0,
+                                0,
+                                0,
+                                (ulong)CW_USEDEFAULT,
+                                (ulong)CW_USEDEFAULT,
+                                (ulong)CW_USEDEFAULT,
+                                (ulong)CW_USEDEFAULT,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0};
+
+    QString cmd =
+        "C:\\windows\\system32\\cmd.exe /c " + program + QLatin1Char(' ');
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        cmd += QLatin1Char(' ') + arguments.at(i);
+    }
+
+    qDebug("[Process::startDetached] \"%s\"", cmd.toLatin1().constData());
+
+    success =
+        CreateProcess(0, (wchar_t *)cmd.utf16(), 0, 0, FALSE, dwCreationFlags, 0,
+                      workingDir.isEmpty() ? 0 : (wchar_t *)workingDir.utf16(),
+                      &startupInfo, &pinfo);
+
+    if (success) {
+        CloseHandle(pinfo.hThread);
+        CloseHandle(pinfo.hProcess);
+
+        invalidateSnapshot();
+
+        // if we have a cmd.exe parent, kill it, so that it's child gets
+        // independent/parentless
+        if (cmd.contains("cmd.exe")) {
+            delay(500);
+            killProcess(pinfo.dwProcessId);
+        }
+
+    } else if (GetLastError() == errorElevationRequired) {
+        // startDetachedUacPrompt
+        qDebug() << "[Process::startDetached] errorElevationRequired";
+        success = false;
+    }
+
+    return success;
+}
+
+bool Processes::start(const QString &program, const QStringList &arguments, const QString &workingDir)
+{
+    bool success = false;
+
+    static const DWORD errorElevationRequired = 740;
+    PROCESS_INFORMATION pinfo;
+    DWORD dwCreationFlags =
+        CREATE_UNICODE_ENVIRONMENT | CREATE_DEFAULT_ERROR_MODE | CREATE_NO_WINDOW;
+    STARTUPINFOW startupInfo = {sizeof(STARTUPINFO),
+                                0,
+                                0,
+                                0,
+                                (ulong)CW_USEDEFAULT,
+                                (ulong)CW_USEDEFAULT,
+                                (ulong)CW_USEDEFAULT,
+                                (ulong)CW_USEDEFAULT,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                0};
+
+    QString cmd = program + QLatin1Char(' ');
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        cmd += QLatin1Char(' ') + arguments.at(i);
+    }
+
+    qDebug("[Process::start] \"%s\"", cmd.toLatin1().constData());
+
+    success =
+        CreateProcess(0, (wchar_t *)cmd.utf16(), 0, 0, FALSE, dwCreationFlags, 0,
+                      workingDir.isEmpty() ? 0 : (wchar_t *)workingDir.utf16(),
+                      &startupInfo, &pinfo);
+
+    if (success) {
+        CloseHandle(pinfo.hThread);
+        CloseHandle(pinfo.hProcess);
+
+        invalidateSnapshot();
+
+    } else if (GetLastError() == errorElevationRequired) {
+        qDebug() << "[Process::start] errorElevationRequired";
+        success = false;
+    }
+
+    return success;
+}
@@ -0,0 +1,129 @@
+#include "processfilterproxymodel.h"
+#include "processmodel.h"
+
+#include <QDir>
+
+ProcessFilterProxyModel::ProcessFilterProxyModel(QObject *parent)
+    : QSortFilterProxyModel(parent), excludeSystemProcesses(false)
+{
+    setSortRole(ProcessModel::SortRole);
+    setDynamicSortFilter(true);
+}
+
+void ProcessFilterProxyModel::setNameFilter(const QString &query)
+{
+    nameFilter = query;
+    invalidateFilter();
+}
+
+void ProcessFilterProxyModel::setPidFilter(const QString &query)
+{
+    pidFilter = query;
+    invalidateFilter();
+}
+
+void ProcessFilterProxyModel::setPortFilter(const QString &query)
+{
+    portFilter = query;
+    invalidateFilter();
+}
+
+/**
+ * Hides Windows system processes (svchost.exe, dwm.exe, everything in C:\Windows).
+ */
+void ProcessFilterProxyModel::setExcludeSystemProcesses(bool exclude)
+{
+    excludeSystemProcesses = exclude;
+    invalidateFilter();
+}
+
+/**
+ * Shows only processes with an executable below the folder (empty: all).
+ */
+void ProcessFilterProxyModel::setOnlyProcessesBelow(const QString &folder)
+{
+    onlyBelowFolder = QDir::toNativeSeparators(folder);
+    invalidateFilter();
+}
+
+/**
+ * Re-evaluates an active filter after the source model changed.
+ * A new matching child is only shown, if its parent is re-evaluated, too.
+ */
+void ProcessFilterProxyModel::refilter()
+{
+    if (isFiltered()) {
+        invalidateFilter();
+    }
+}
+
+bool ProcessFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+
+    if (!isFiltered() || matches(index)) {
+        return true;
+    }
+
+    // keep the parents of matching processes
+    int children = sourceModel()->rowCount(index);
+    for (int i = 0; i < children; ++i) {
+        if (filterAcceptsRow(i, index)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ProcessFilterProxyModel::matches(const QModelIndex &sourceIndex) const
+{
+    QAbstractItemModel *model = sourceModel();
+    int row = sourceIndex.row();
+    QModelIndex parent = sourceIndex.parent();
+
+    if (!nameFilter.isEmpty()) {
+        QString name = model->index(row, ProcessModel::COLUMN_NAME, parent).data().toString();
+        if (!name.contains(nameFilter, Qt::CaseInsensitive)) {
+            return false;
+        }
+    }
+
+    if (!pidFilter.isEmpty()) {
+        QString pid = model->index(row, ProcessModel::COLUMN_PID, parent).data().toString();
+        if (!pid.contains(pidFilter)) {
+            return false;
+        }
+    }
+
+    if (!portFilter.isEmpty()) {
+        QString ports = model->index(row, ProcessModel::COLUMN_PORT, parent).data().toString();
+        if (!ports.contains(portFilter)) {
+            return false;
+        }
+    }
+
+    if (excludeSystemProcesses || !onlyBelowFolder.isEmpty()) {
+        QString path = QDir::toNativeSeparators(sourceIndex.data(ProcessModel::PathRole).toString());
+
+        if (excludeSystemProcesses) {
+            QString name = sourceIndex.data().toString();
+            if (path.contains("C:\\Windows", Qt::CaseInsensitive) || name == "svchost.exe" ||
+                name == "fontdrvhost.exe" || name == "dwm.exe" || name == "upeksvr.exe") {
+                return false;
+            }
+        }
+
+        if (!onlyBelowFolder.isEmpty() && !path.startsWith(onlyBelowFolder, Qt::CaseInsensitive)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ProcessFilterProxyModel::isFiltered() const
+{
+    return !nameFilter.isEmpty() || !pidFilter.isEmpty() || !portFilter.isEmpty() ||
+           excludeSystemProcesses || !onlyBelowFolder.isEmpty();
+}
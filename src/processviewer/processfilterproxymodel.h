@@ -0,0 +1,42 @@
+#ifndef PROCESSFILTERPROXYMODEL_H
+#define PROCESSFILTERPROXYMODEL_H
+
+#include <QSortFilterProxyModel>
+
+/// Filters the process tree by name, pid and port.
+/*!
+    The filter is recursive: a process is shown, if it matches or if one of
+    its descendants matches, so matches keep their parents.
+    (QSortFilterProxyModel::setRecursiveFilteringEnabled() needs Qt 5.10.)
+*/
+class ProcessFilterProxyModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit ProcessFilterProxyModel(QObject *parent = 0);
+
+    void setNameFilter(const QString &query);
+    void setPidFilter(const QString &query);
+    void setPortFilter(const QString &query);
+
+    void setExcludeSystemProcesses(bool exclude);
+    void setOnlyProcessesBelow(const QString &folder);
+
+    void refilter();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+
+private:
+    QString nameFilter;
+    QString pidFilter;
+    QString portFilter;
+    bool excludeSystemProcesses;
+    QString onlyBelowFolder;
+
+    bool matches(const QModelIndex &sourceIndex) const;
+    bool isFiltered() const;
+};
+
+#endif // PROCESSFILTERPROXYMODEL_H
@@ -0,0 +1,62 @@
+#include "processiconcache.h"
+
+#include <QFileInfo>
+
+// initialize static members
+QCache<QString, ProcessIconCache::Entry> ProcessIconCache::cache(512);
+QElapsedTimer ProcessIconCache::clock;
+QFileIconProvider *ProcessIconCache::provider = 0;
+
+/**
+ * Returns the icon of the executable.
+ * The least recently used icon is dropped, when the cache is full.
+ */
+// static
+QIcon ProcessIconCache::icon(const QString &path)
+{
+    if (path.isEmpty()) {
+        return QIcon();
+    }
+
+    if (!clock.isValid()) {
+        clock.start();
+    }
+
+    qint64 now = clock.elapsed();
+
+    // object() marks the entry as most recently used
+    Entry *entry = cache.object(path);
+
+    if (entry && now - entry->checkedAt < revalidateAfter) {
+        return entry->icon;
+    }
+
+    QFileInfo fileInfo(path);
+    QDateTime lastModified = fileInfo.lastModified();
+
+    if (entry && entry->lastModified == lastModified) {
+        entry->checkedAt = now;
+        return entry->icon;
+    }
+
+    // new executable or the executable was replaced (e.g. by an update)
+    if (!provider) {
+        provider = new QFileIconProvider;
+    }
+
+    entry = new Entry;
+    entry->icon = provider->icon(fileInfo);
+    entry->lastModified = lastModified;
+    entry->checkedAt = now;
+
+    QIcon icon = entry->icon;
+    cache.insert(path, entry);
+
+    return icon;
+}
+
+// static
+void ProcessIconCache::setMaxEntries(int entries) { cache.setMaxCost(entries); }
+
+// static
+void ProcessIconCache::clear() { cache.clear(); }
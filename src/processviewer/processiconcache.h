@@ -0,0 +1,45 @@
+#ifndef PROCESSICONCACHE_H
+#define PROCESSICONCACHE_H
+
+#include <QCache>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileIconProvider>
+#include <QIcon>
+#include <QString>
+
+/// Process-wide LRU cache of executable icons.
+/*!
+    Resolving an icon with QFileIconProvider touches the filesystem and the
+    shell, it is one of the slowest operations of the process viewer.
+    Icons are cached by executable path and last modification time.
+    The modification time of a cached executable is re-checked at most once
+    per revalidateAfter, so a refresh does not touch the filesystem for
+    executables already seen.
+
+    The icon provider is not thread-safe: use the cache from the GUI thread.
+*/
+class ProcessIconCache
+{
+public:
+    static QIcon icon(const QString &path);
+
+    static void setMaxEntries(int entries);
+    static void clear();
+
+private:
+    struct Entry
+    {
+        QIcon icon;
+        QDateTime lastModified;
+        qint64 checkedAt; // ms, see clock
+    };
+
+    static QCache<QString, Entry> cache;
+    static QElapsedTimer clock;
+    static QFileIconProvider *provider;
+
+    static const qint64 revalidateAfter = 60 * 1000; // ms
+};
+
+#endif // PROCESSICONCACHE_H
@@ -0,0 +1,326 @@
+#include "processmodel.h"
+#include "processiconcache.h"
+
+#include <algorithm>
+
+ProcessModel::ProcessModel(QObject *parent) : QAbstractItemModel(parent) {}
+
+/**
+ * Applies a new snapshot to the model.
+ *
+ * Processes which exited, were re-parented or whose pid was re-used are
+ * removed (with their subtree), then values of the remaining processes are
+ * compared, finally new processes are inserted top-down.
+ * The first update resets the model.
+ */
+void ProcessModel::update(const ProcessSnapshot &snapshot, const PortTable &portTable)
+{
+    const QVector<Process> &list = snapshot.processes();
+
+    QMultiHash<qint64, int> childIndexes;
+    childIndexes.reserve(list.size());
+    for (int i = 0; i < list.size(); ++i) {
+        if (list.at(i).ppid != list.at(i).pid) {
+            childIndexes.insert(list.at(i).ppid, i);
+        }
+    }
+
+    // the new tree: the parent of every process and a top-down order
+    QHash<qint64, qint64> parentOf;
+    parentOf.reserve(list.size());
+    QVector<int> order;
+    order.reserve(list.size());
+
+    // a process is top level, if its parent is not running (anymore),
+    // processes in a ppid cycle (pids are re-used on Windows) become top level, too
+    int next = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < list.size(); ++i) {
+            const Process &p = list.at(i);
+
+            if (parentOf.contains(p.pid)) {
+                continue;
+            }
+            if (pass == 0 && p.ppid != p.pid && snapshot.containsPid(p.ppid)) {
+                continue;
+            }
+
+            parentOf.insert(p.pid, -1);
+            order.append(i);
+
+            // breadth first over the descendants
+            for (; next < order.size(); ++next) {
+                qint64 pid = list.at(order.at(next)).pid;
+
+                QMultiHash<qint64, int>::const_iterator it = childIndexes.constFind(pid);
+                for (; it != childIndexes.constEnd() && it.key() == pid; ++it) {
+                    qint64 childPid = list.at(it.value()).pid;
+                    if (!parentOf.contains(childPid)) {
+                        parentOf.insert(childPid, pid);
+                        order.append(it.value());
+                    }
+                }
+            }
+        }
+    }
+
+    bool reset = nodes.isEmpty();
+
+    if (reset) {
+        beginResetModel();
+    } else {
+        // removals
+        QVector<qint64> removed;
+        for (QHash<qint64, Node>::const_iterator it = nodes.constBegin(); it != nodes.constEnd(); ++it) {
+            QHash<qint64, qint64>::const_iterator parent = parentOf.constFind(it.key());
+
+            if (parent == parentOf.constEnd() || parent.value() != it.value().parentPid ||
+                snapshot.findByPid(it.key()).nameId != it.value().process.nameId) {
+                removed.append(it.key());
+            }
+        }
+
+        foreach (qint64 pid, removed) {
+            // might be gone already, as part of the subtree of a removed parent
+            if (nodes.contains(pid)) {
+                removeNode(pid);
+            }
+        }
+    }
+
+    foreach (int i, order) {
+        Process p = list.at(i);
+        foreach (quint16 port, portTable.listeningPorts(p.pid)) {
+            p.ports.append(port);
+        }
+
+        QHash<qint64, Node>::iterator it = nodes.find(p.pid);
+
+        if (it == nodes.end()) {
+            insertNode(p, parentOf.value(p.pid), !reset);
+            continue;
+        }
+
+        // changed values
+        Process &current = it.value().process;
+        bool portsChanged = current.ports.size() != p.ports.size() ||
+                            !std::equal(p.ports.constBegin(), p.ports.constEnd(), current.ports.constBegin());
+
+        if (portsChanged || current.rssBytes != p.rssBytes) {
+            current = p;
+            int row = it.value().row;
+            emit dataChanged(createIndex(row, COLUMN_PORT, quintptr(p.pid)),
+                             createIndex(row, COLUMN_MEM, quintptr(p.pid)));
+        }
+    }
+
+    if (reset) {
+        endResetModel();
+    }
+}
+
+/**
+ * Returns the process of the index or an invalid process.
+ */
+Process ProcessModel::process(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Process();
+    }
+    return nodes.value(qint64(index.internalId())).process;
+}
+
+QModelIndex ProcessModel::indexOfPid(qint64 pid, int column) const
+{
+    QHash<qint64, Node>::const_iterator it = nodes.constFind(pid);
+    if (it == nodes.constEnd()) {
+        return QModelIndex();
+    }
+    return createIndex(it.value().row, column, quintptr(pid));
+}
+
+QModelIndex ProcessModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (row < 0 || column < 0 || column >= COLUMN_COUNT) {
+        return QModelIndex();
+    }
+
+    const QVector<qint64> *children = &roots;
+
+    if (parent.isValid()) {
+        QHash<qint64, Node>::const_iterator it = nodes.constFind(qint64(parent.internalId()));
+        if (it == nodes.constEnd()) {
+            return QModelIndex();
+        }
+        children = &it.value().children;
+    }
+
+    if (row >= children->size()) {
+        return QModelIndex();
+    }
+
+    return createIndex(row, column, quintptr(children->at(row)));
+}
+
+QModelIndex ProcessModel::parent(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return QModelIndex();
+    }
+
+    QHash<qint64, Node>::const_iterator it = nodes.constFind(qint64(index.internalId()));
+    if (it == nodes.constEnd() || it.value().parentPid < 0) {
+        return QModelIndex();
+    }
+
+    return indexOfPid(it.value().parentPid);
+}
+
+int ProcessModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return roots.size();
+    }
+    if (parent.column() > 0) {
+        return 0;
+    }
+
+    QHash<qint64, Node>::const_iterator it = nodes.constFind(qint64(parent.internalId()));
+    return (it == nodes.constEnd()) ? 0 : it.value().children.size();
+}
+
+int ProcessModel::columnCount(const QModelIndex &) const { return COLUMN_COUNT; }
+
+QVariant ProcessModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    QHash<qint64, Node>::const_iterator it = nodes.constFind(qint64(index.internalId()));
+    if (it == nodes.constEnd()) {
+        return QVariant();
+    }
+
+    const Process &p = it.value().process;
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case COLUMN_NAME:
+            return p.name();
+        case COLUMN_PID:
+            return p.pid;
+        case COLUMN_PORT:
+            return p.portsText();
+        case COLUMN_MEM:
+            return p.memoryUsage();
+        }
+        break;
+
+    case SortRole:
+        switch (index.column()) {
+        case COLUMN_NAME:
+            return p.name().toLower();
+        case COLUMN_PID:
+            return p.pid;
+        case COLUMN_PORT:
+            return p.ports.isEmpty() ? 0 : int(p.ports.at(0));
+        case COLUMN_MEM:
+            return p.rssBytes;
+        }
+        break;
+
+    case Qt::DecorationRole:
+        // resolved only for rows the view paints
+        if (index.column() == COLUMN_NAME) {
+            return ProcessIconCache::icon(p.path());
+        }
+        break;
+
+    case Qt::ToolTipRole:
+        if (index.column() == COLUMN_NAME) {
+            return p.path();
+        }
+        break;
+
+    case PathRole:
+        return p.path();
+    }
+
+    return QVariant();
+}
+
+QVariant ProcessModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case COLUMN_NAME:
+        return tr("Process Name");
+    case COLUMN_PID:
+        return tr("Process Identifier");
+    case COLUMN_PORT:
+        return tr("Port");
+    case COLUMN_MEM:
+        return tr("Memory Usage");
+    }
+
+    return QVariant();
+}
+
+QVector<qint64> &ProcessModel::childrenOf(qint64 parentPid)
+{
+    return (parentPid < 0) ? roots : nodes[parentPid].children;
+}
+
+void ProcessModel::removeNode(qint64 pid)
+{
+    const Node &node = nodes[pid];
+    qint64 parentPid = node.parentPid;
+    int row = node.row;
+
+    beginRemoveRows(indexOfPid(parentPid), row, row);
+
+    QVector<qint64> &siblings = childrenOf(parentPid);
+    siblings.remove(row);
+    for (int i = row; i < siblings.size(); ++i) {
+        nodes[siblings.at(i)].row = i;
+    }
+
+    removeSubtree(pid);
+
+    endRemoveRows();
+}
+
+void ProcessModel::removeSubtree(qint64 pid)
+{
+    QVector<qint64> children = nodes.value(pid).children;
+    foreach (qint64 child, children) {
+        removeSubtree(child);
+    }
+    nodes.remove(pid);
+}
+
+void ProcessModel::insertNode(const Process &process, qint64 parentPid, bool notify)
+{
+    int row = childrenOf(parentPid).size();
+
+    if (notify) {
+        beginInsertRows(indexOfPid(parentPid), row, row);
+    }
+
+    Node node;
+    node.process = process;
+    node.parentPid = parentPid;
+    node.row = row;
+    nodes.insert(process.pid, node);
+
+    childrenOf(parentPid).append(process.pid);
+
+    if (notify) {
+        endInsertRows();
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef PROCESSMODEL_H
+#define PROCESSMODEL_H
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QVector>
+
+#include "porttable.h"
+#include "processsnapshot.h"
+
+/// Tree model of the running processes (parent -> children).
+/*!
+    The model is updated from a process snapshot and a port table.
+    An update computes the difference to the current state and applies it as
+    row removals, row insertions and dataChanged() for changed values, so
+    views keep their selection, expansion and scroll position.
+
+    The internal id of an index is the pid of the process.
+*/
+class ProcessModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Columns
+    {
+        COLUMN_NAME = 0,
+        COLUMN_PID = 1,
+        COLUMN_PORT = 2,
+        COLUMN_MEM = 3,
+        COLUMN_COUNT
+    };
+
+    // raw values for sorting (pid, bytes, ...) instead of display texts
+    static const int SortRole = Qt::UserRole;
+    static const int PathRole = Qt::UserRole + 1;
+
+    explicit ProcessModel(QObject *parent = 0);
+
+    void update(const ProcessSnapshot &snapshot, const PortTable &portTable);
+
+    Process process(const QModelIndex &index) const;
+    QModelIndex indexOfPid(qint64 pid, int column = 0) const;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    QModelIndex parent(const QModelIndex &index) const;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+private:
+    struct Node
+    {
+        Process process;
+        qint64 parentPid; // -1 for top level processes
+        int row; // row within the children of the parent
+        QVector<qint64> children;
+    };
+
+    QHash<qint64, Node> nodes;
+    QVector<qint64> roots;
+
+    QVector<qint64> &childrenOf(qint64 parentPid);
+    void removeNode(qint64 pid);
+    void removeSubtree(qint64 pid);
+    void insertNode(const Process &process, qint64 parentPid, bool notify);
+};
+
+#endif // PROCESSMODEL_H
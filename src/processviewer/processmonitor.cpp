@@ -0,0 +1,289 @@
+#include "processmonitor.h"
+#include "processes.h"
+
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <QWinEventNotifier>
+#else
+#include <QSocketNotifier>
+
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#endif
+
+ProcessMonitor::ProcessMonitor(QObject *parent) : QObject(parent), initialized(false)
+{
+    timer.setInterval(1000);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+ProcessMonitor::~ProcessMonitor()
+{
+    foreach (qint64 pid, watchers.keys()) {
+        unwatch(pid);
+    }
+}
+
+void ProcessMonitor::setInterval(int milliseconds) { timer.setInterval(milliseconds); }
+
+/**
+ * Processes with these executable names get an exit watcher.
+ */
+void ProcessMonitor::setWatchedNames(const QStringList &names)
+{
+    watchedNames.clear();
+    foreach (const QString &name, names) {
+        watchedNames.insert(ProcessStrings::intern(ProcessSnapshot::normalizeName(name)));
+    }
+}
+
+void ProcessMonitor::start()
+{
+    poll();
+    timer.start();
+}
+
+void ProcessMonitor::stop() { timer.stop(); }
+
+/**
+ * Diffs the current snapshot against the last known state.
+ * The first poll only establishes the baseline and emits nothing.
+ */
+void ProcessMonitor::poll()
+{
+    // an exited child stays in the snapshot (zombie), until it is reaped:
+    // the exits of children are collected first (kernels without pidfd)
+    QHash<qint64, int> exitCodes;
+    foreach (qint64 pid, children) {
+        int exitCode = reap(pid);
+        if (!children.contains(pid)) {
+            exitCodes.insert(pid, exitCode);
+        }
+    }
+
+    if (!exitCodes.isEmpty()) {
+        Processes::invalidateSnapshot();
+    }
+
+    ProcessSnapshot snapshot = Processes::snapshot();
+
+    QSet<qint64> seen;
+    seen.reserve(snapshot.size());
+
+    foreach (const Process &p, snapshot.processes()) {
+        seen.insert(p.pid);
+
+        QHash<qint64, quint32>::const_iterator it = live.constFind(p.pid);
+
+        if (it == live.constEnd()) {
+            addLive(p.pid, p.nameId, p.startTime);
+        } else if (isReused(p, it.value())) {
+            removeLive(p.pid, -1);
+            addLive(p.pid, p.nameId, p.startTime);
+        }
+    }
+
+    QList<qint64> exited;
+    for (QHash<qint64, quint32>::const_iterator it = live.constBegin(); it != live.constEnd(); ++it) {
+        if (!seen.contains(it.key())) {
+            exited.append(it.key());
+        }
+    }
+
+    foreach (qint64 pid, exited) {
+        removeLive(pid, exitCodes.value(pid, -1));
+    }
+
+    initialized = true;
+}
+
+bool ProcessMonitor::isRunning(const QString &name) const
+{
+    quint32 key = ProcessStrings::find(ProcessSnapshot::normalizeName(name));
+    return key != 0 && liveCountByName.value(key) > 0;
+}
+
+/**
+ * Returns the exe name of a live process.
+ * Inside a slot connected to processExited() the exe of the exited process
+ * is still available.
+ */
+QString ProcessMonitor::exeOf(qint64 pid) const
+{
+    return ProcessStrings::string(live.value(pid));
+}
+
+/**
+ * The pid was re-used by a new process, if the start time differs.
+ * A new name with the same start time is an exec(), reported as a new
+ * process as well, unless the exe link is unreadable: the name of a zombie
+ * falls back to the truncated "comm".
+ */
+bool ProcessMonitor::isReused(const Process &p, quint32 knownNameId) const
+{
+    quint64 knownStartTime = startTimes.value(p.pid);
+    if (p.startTime != 0 && knownStartTime != 0 && p.startTime != knownStartTime) {
+        return true;
+    }
+    if (p.nameId == knownNameId) {
+        return false;
+    }
+    return p.startTime == 0 || p.pathId != 0;
+}
+
+void ProcessMonitor::addLive(qint64 pid, quint32 nameId, quint64 startTime)
+{
+    live.insert(pid, nameId);
+    if (startTime != 0) {
+        startTimes.insert(pid, startTime);
+    }
+
+    quint32 key = ProcessStrings::nameKey(nameId);
+    liveCountByName[key]++;
+
+    if (watchedNames.contains(key)) {
+        watch(pid);
+    }
+
+    if (initialized) {
+        emit processStarted(pid, ProcessStrings::string(nameId));
+    }
+}
+
+void ProcessMonitor::removeLive(qint64 pid, int exitCode)
+{
+    unwatch(pid);
+
+    QHash<qint64, quint32>::iterator it = live.find(pid);
+    if (it == live.end()) {
+        return;
+    }
+
+    quint32 key = ProcessStrings::nameKey(it.value());
+    if (--liveCountByName[key] <= 0) {
+        liveCountByName.remove(key);
+    }
+
+    emit processExited(pid, exitCode);
+
+    live.remove(pid);
+    startTimes.remove(pid);
+}
+
+/**
+ * Hands over a child process: the monitor reaps it, when it exits.
+ */
+void ProcessMonitor::adopt(qint64 pid)
+{
+#ifdef Q_OS_WIN
+    Q_UNUSED(pid) // there are no zombies, the exit code is read from the process handle
+#else
+    children.insert(pid);
+#endif
+}
+
+/**
+ * Reaps an adopted child, which exited. Returns its exit code or -1.
+ * Children of others (QProcess) are never reaped, it would steal their
+ * exit status.
+ */
+int ProcessMonitor::reap(qint64 pid)
+{
+#ifndef Q_OS_WIN
+    int status;
+    if (children.contains(pid) && waitpid(pid_t(pid), &status, WNOHANG) == pid_t(pid)) {
+        children.remove(pid);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    }
+#else
+    Q_UNUSED(pid)
+#endif
+    return -1;
+}
+
+/**
+ * Registers an exit watcher for a process.
+ * Returns false, if the platform does not support it (then the exit is
+ * detected on the next poll).
+ */
+bool ProcessMonitor::watch(qint64 pid)
+{
+    if (watchers.contains(pid) || pid <= 0) {
+        return watchers.contains(pid);
+    }
+
+#ifdef Q_OS_WIN
+    HANDLE hProcess = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, DWORD(pid));
+    if (hProcess == NULL) {
+        return false;
+    }
+
+    QWinEventNotifier *notifier = new QWinEventNotifier(hProcess, this);
+    connect(notifier, SIGNAL(activated(HANDLE)), this, SLOT(watcherActivated()));
+#else
+    int pidFd = int(syscall(SYS_pidfd_open, pid_t(pid), 0));
+    if (pidFd < 0) {
+        return false; // kernel < 5.3
+    }
+
+    // a pidfd becomes readable, when the process exits
+    QSocketNotifier *notifier = new QSocketNotifier(pidFd, QSocketNotifier::Read, this);
+    connect(notifier, SIGNAL(activated(int)), this, SLOT(watcherActivated()));
+#endif
+
+    notifier->setProperty("pid", pid);
+    watchers.insert(pid, notifier);
+
+    return true;
+}
+
+void ProcessMonitor::unwatch(qint64 pid)
+{
+    QObject *watcher = watchers.take(pid);
+    if (!watcher) {
+        return;
+    }
+
+#ifdef Q_OS_WIN
+    QWinEventNotifier *notifier = static_cast<QWinEventNotifier *>(watcher);
+    notifier->setEnabled(false);
+    CloseHandle(notifier->handle());
+#else
+    QSocketNotifier *notifier = static_cast<QSocketNotifier *>(watcher);
+    notifier->setEnabled(false);
+    close(int(notifier->socket()));
+#endif
+
+    notifier->deleteLater();
+}
+
+void ProcessMonitor::watcherActivated()
+{
+    qint64 pid = sender()->property("pid").toLongLong();
+    int exitCode = -1;
+
+#ifdef Q_OS_WIN
+    QWinEventNotifier *notifier = static_cast<QWinEventNotifier *>(sender());
+    DWORD code;
+    if (GetExitCodeProcess(notifier->handle(), &code)) {
+        exitCode = int(code);
+    }
+#else
+    // the exit code is only available for our adopted children
+    exitCode = reap(pid);
+#endif
+
+    qDebug() << "[ProcessMonitor] Process exited:" << pid << exeOf(pid) << "exit code" << exitCode;
+
+    // the shared snapshot might still list the process
+    Processes::invalidateSnapshot();
+
+    removeLive(pid, exitCode);
+}
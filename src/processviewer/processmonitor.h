@@ -0,0 +1,76 @@
+#ifndef PROCESSMONITOR_H
+#define PROCESSMONITOR_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+#include "processsnapshot.h"
+
+/// Emits process lifecycle events (started/exited).
+/*!
+    The monitor diffs consecutive process snapshots to detect started and
+    exited processes. Processes with a watched executable name get an
+    additional exit watcher (pidfd on Linux, process handle on Windows),
+    so their exit is reported the moment it happens, not on the next tick.
+
+    Only the children handed over by adopt() are reaped (waitpid), so their
+    exit code is reported. Other children, like those of a QProcess, are
+    left to their owner, their exit code is reported as -1.
+
+    Clients connect to the signals instead of re-enumerating all processes.
+*/
+class ProcessMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProcessMonitor(QObject *parent = 0);
+    ~ProcessMonitor();
+
+    void setInterval(int milliseconds);
+    void setWatchedNames(const QStringList &names);
+
+    bool watch(qint64 pid);
+    void unwatch(qint64 pid);
+    void adopt(qint64 pid);
+
+    bool isRunning(const QString &name) const;
+    QString exeOf(qint64 pid) const;
+
+public slots:
+    void start();
+    void stop();
+    void poll();
+
+signals:
+    void processStarted(qint64 pid, const QString &exe);
+    void processExited(qint64 pid, int exitCode);
+
+private slots:
+    void watcherActivated();
+
+private:
+    QTimer timer;
+    bool initialized;
+
+    // pid => exe name id of all processes known alive
+    QHash<qint64, quint32> live;
+    // pid => start time, where the platform reports it
+    QHash<qint64, quint64> startTimes;
+    // normalized exe name id => number of live processes
+    QHash<quint32, int> liveCountByName;
+
+    QSet<quint32> watchedNames;
+    QHash<qint64, QObject *> watchers;
+    // forked by us (FastCgiPool), reaped when they exit
+    QSet<qint64> children;
+
+    bool isReused(const Process &p, quint32 knownNameId) const;
+    void addLive(qint64 pid, quint32 nameId, quint64 startTime);
+    void removeLive(qint64 pid, int exitCode);
+    int reap(qint64 pid);
+};
+
+#endif // PROCESSMONITOR_H
@@ -0,0 +1,318 @@
+#include "processsnapshot.h"
+
+#include <QSet>
+#include <QStringList>
+
+#include <algorithm>
+
+// initialize static members
+QReadWriteLock ProcessStrings::lock;
+QVector<QString> ProcessStrings::strings(1); // id 0 is the empty string
+QHash<QString, quint32> ProcessStrings::ids;
+QHash<quint32, quint32> ProcessStrings::nameKeys;
+QHash<quint32, quint32> ProcessStrings::pathKeys;
+
+/**
+ * Returns the id of the string, adding it to the pool, if needed.
+ */
+// static
+quint32 ProcessStrings::intern(const QString &string)
+{
+    if (string.isEmpty()) {
+        return 0;
+    }
+
+    {
+        QReadLocker locker(&lock);
+        QHash<QString, quint32>::const_iterator it = ids.constFind(string);
+        if (it != ids.constEnd()) {
+            return it.value();
+        }
+    }
+
+    QWriteLocker locker(&lock);
+
+    // another thread might have added it in the meantime
+    QHash<QString, quint32>::const_iterator it = ids.constFind(string);
+    if (it != ids.constEnd()) {
+        return it.value();
+    }
+
+    quint32 id = quint32(strings.size());
+    strings.append(string);
+    ids.insert(string, id);
+    return id;
+}
+
+/**
+ * Returns the id of the string or 0, if the string is not in the pool.
+ */
+// static
+quint32 ProcessStrings::find(const QString &string)
+{
+    QReadLocker locker(&lock);
+    return ids.value(string, 0);
+}
+
+// static
+QString ProcessStrings::string(quint32 id)
+{
+    QReadLocker locker(&lock);
+    return (id < quint32(strings.size())) ? strings.at(int(id)) : QString();
+}
+
+// static
+quint32 ProcessStrings::nameKey(quint32 nameId)
+{
+    {
+        QReadLocker locker(&lock);
+        QHash<quint32, quint32>::const_iterator it = nameKeys.constFind(nameId);
+        if (it != nameKeys.constEnd()) {
+            return it.value();
+        }
+    }
+
+    quint32 key = intern(ProcessSnapshot::normalizeName(string(nameId)));
+
+    QWriteLocker locker(&lock);
+    nameKeys.insert(nameId, key);
+    return key;
+}
+
+// static
+quint32 ProcessStrings::pathKey(quint32 pathId)
+{
+    {
+        QReadLocker locker(&lock);
+        QHash<quint32, quint32>::const_iterator it = pathKeys.constFind(pathId);
+        if (it != pathKeys.constEnd()) {
+            return it.value();
+        }
+    }
+
+    quint32 key = intern(ProcessSnapshot::normalizePath(string(pathId)));
+
+    QWriteLocker locker(&lock);
+    pathKeys.insert(pathId, key);
+    return key;
+}
+
+QString Process::memoryUsage() const
+{
+    return (rssBytes > 0) ? ProcessSnapshot::formatBytes(rssBytes) : QString();
+}
+
+QString Process::portsText() const
+{
+    QStringList list;
+    for (int i = 0; i < ports.size(); ++i) {
+        list << QString::number(ports.at(i));
+    }
+    return list.join(QLatin1String(", "));
+}
+
+ProcessSnapshot::ProcessSnapshot() {}
+
+ProcessSnapshot::ProcessSnapshot(const QVector<Process> &processes) : list(processes)
+{
+    byPid.reserve(list.size());
+    byName.reserve(list.size());
+    byPath.reserve(list.size());
+
+    for (int index = 0; index < list.size(); ++index) {
+        const Process &p = list.at(index);
+
+        byPid.insert(p.pid, index);
+        byName.insert(ProcessStrings::nameKey(p.nameId), index);
+
+        // the first process of a path, like findByName() (the nginx master, not a worker)
+        if (p.pathId != 0 && !byPath.contains(ProcessStrings::pathKey(p.pathId))) {
+            byPath.insert(ProcessStrings::pathKey(p.pathId), index);
+        }
+
+        // a process is never its own child (pid 0 on Windows is its own parent)
+        if (p.ppid != p.pid) {
+            childrenByPpid.insert(p.ppid, index);
+        }
+    }
+}
+
+const QVector<Process> &ProcessSnapshot::processes() const { return list; }
+
+int ProcessSnapshot::size() const { return list.size(); }
+
+bool ProcessSnapshot::isEmpty() const { return list.isEmpty(); }
+
+bool ProcessSnapshot::containsPid(qint64 pid) const
+{
+    return byPid.contains(pid);
+}
+
+bool ProcessSnapshot::containsName(const QString &name) const
+{
+    quint32 key = ProcessStrings::find(normalizeName(name));
+    return key != 0 && byName.contains(key);
+}
+
+/**
+ * Returns the process with the given pid.
+ * If there is no such process, an invalid process is returned.
+ */
+Process ProcessSnapshot::findByPid(qint64 pid) const
+{
+    QHash<qint64, int>::const_iterator it = byPid.constFind(pid);
+    if (it != byPid.constEnd()) {
+        return list.at(it.value());
+    }
+
+    return Process();
+}
+
+/**
+ * Returns the first process matching the executable name.
+ *
+ * The name might be given as "nginx", "nginx.exe" or as full path to the
+ * executable. A full path is matched against the executable path first,
+ * then we fall back to matching the basename (the path of a process
+ * might not be readable, because of missing rights).
+ */
+Process ProcessSnapshot::findByName(const QString &name) const
+{
+    if (name.contains(QLatin1Char('/')) || name.contains(QLatin1Char('\\'))) {
+        Process p = findByPath(name);
+        if (p.isValid()) {
+            return p;
+        }
+    }
+
+    QList<Process> matches = findAllByName(name);
+    if (!matches.isEmpty()) {
+        return matches.first();
+    }
+
+    return Process();
+}
+
+Process ProcessSnapshot::findByPath(const QString &path) const
+{
+    quint32 key = ProcessStrings::find(normalizePath(path));
+
+    QHash<quint32, int>::const_iterator it = byPath.constFind(key);
+    if (key != 0 && it != byPath.constEnd()) {
+        return list.at(it.value());
+    }
+
+    return Process();
+}
+
+QList<Process> ProcessSnapshot::findAllByName(const QString &name) const
+{
+    QList<Process> processes;
+
+    quint32 key = ProcessStrings::find(normalizeName(name));
+    if (key == 0) {
+        return processes;
+    }
+
+    QList<int> indexes = byName.values(key);
+
+    // keep the order of the system process list
+    std::sort(indexes.begin(), indexes.end());
+
+    foreach (int index, indexes) {
+        processes.append(list.at(index));
+    }
+    return processes;
+}
+
+QList<Process> ProcessSnapshot::children(qint64 pid) const
+{
+    QList<int> indexes = childrenByPpid.values(pid);
+    std::sort(indexes.begin(), indexes.end());
+
+    QList<Process> processes;
+    foreach (int index, indexes) {
+        processes.append(list.at(index));
+    }
+    return processes;
+}
+
+/**
+ * Returns all children, grandchildren, etc. of a process (breadth first).
+ * Pids are re-used on Windows, so the ppid relation might contain cycles.
+ * Every process is returned only once.
+ */
+QList<Process> ProcessSnapshot::descendants(qint64 pid) const
+{
+    QList<Process> processes;
+    QSet<qint64> visited;
+    visited.insert(pid);
+
+    QList<qint64> queue;
+    queue.append(pid);
+
+    while (!queue.isEmpty()) {
+        foreach (const Process &child, children(queue.takeFirst())) {
+            if (visited.contains(child.pid)) {
+                continue;
+            }
+            visited.insert(child.pid);
+            processes.append(child);
+            queue.append(child.pid);
+        }
+    }
+
+    return processes;
+}
+
+/**
+ * "C:\bin\nginx\nginx.exe", "nginx.exe", "Nginx" => "nginx"
+ */
+// static
+QString ProcessSnapshot::normalizeName(const QString &nameOrPath)
+{
+    int separator = qMax(nameOrPath.lastIndexOf(QLatin1Char('/')),
+                         nameOrPath.lastIndexOf(QLatin1Char('\\')));
+
+    QString name = nameOrPath.mid(separator + 1).toLower();
+
+    if (name.endsWith(QLatin1String(".exe"))) {
+        name.chop(4);
+    }
+
+    return name;
+}
+
+// static
+QString ProcessSnapshot::normalizePath(const QString &path)
+{
+    QString normalized = path;
+    normalized.replace(QLatin1Char('\\'), QLatin1Char('/'));
+#ifdef Q_OS_WIN
+    // the Windows filesystem is case-insensitive
+    normalized = normalized.toLower();
+#endif
+    return normalized;
+}
+
+/**
+ * 1536 => "1.5 KB"
+ */
+// static
+QString ProcessSnapshot::formatBytes(quint64 bytes)
+{
+    QStringList list;
+    list << "KB"
+         << "MB";
+
+    QStringListIterator i(list);
+    QString unit("bytes");
+
+    double size = double(bytes);
+
+    while (size >= 1024.0 && i.hasNext()) {
+        unit = i.next();
+        size /= 1024.0;
+    }
+    return QString::fromLatin1("%1 %2").arg(size, 3, 'f', 1).arg(unit);
+}
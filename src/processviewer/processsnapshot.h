@@ -0,0 +1,105 @@
+#ifndef PROCESSSNAPSHOT_H
+#define PROCESSSNAPSHOT_H
+
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVarLengthArray>
+#include <QVector>
+
+/// Process-wide pool of interned strings (executable names and paths).
+/*!
+    A machine runs only a few hundred distinct executables, but every snapshot
+    lists them again. Records store a 32-bit id instead of the string, so
+    taking a snapshot does not allocate strings for names and paths.
+    Id 0 is the empty string. The pool is thread-safe.
+*/
+class ProcessStrings
+{
+public:
+    static quint32 intern(const QString &string);
+    static quint32 find(const QString &string);
+    static QString string(quint32 id);
+
+    // ids of the normalized forms, see ProcessSnapshot::normalizeName()
+    static quint32 nameKey(quint32 nameId);
+    static quint32 pathKey(quint32 pathId);
+
+private:
+    static QReadWriteLock lock;
+    static QVector<QString> strings;
+    static QHash<QString, quint32> ids;
+    static QHash<quint32, quint32> nameKeys;
+    static QHash<quint32, quint32> pathKeys;
+};
+
+/// A running process.
+/*!
+    Compact record with numeric fields only. Human-readable strings are
+    produced on demand by the accessors, icons are resolved by the views.
+    A default constructed record (pid -1) is returned for "process not found".
+*/
+struct Process
+{
+    Process() : pid(-1), ppid(-1), rssBytes(0), startTime(0), nameId(0), pathId(0) {}
+
+    qint64 pid;
+    qint64 ppid;
+    quint64 rssBytes; // resident set size (working set on Windows)
+    quint64 startTime; // in clock ticks after boot, 0 if unknown (Windows)
+    quint32 nameId; // interned executable name
+    quint32 pathId; // interned executable path, 0 if not readable
+    QVarLengthArray<quint16, 2> ports; // listening ports, if resolved
+
+    bool isValid() const { return pid >= 0; }
+
+    QString name() const { return ProcessStrings::string(nameId); }
+    QString path() const { return ProcessStrings::string(pathId); }
+    QString memoryUsage() const;
+    QString portsText() const;
+};
+
+/// Immutable, indexed view of all processes at one point in time.
+/*!
+    A snapshot is taken once and then queried many times.
+    Lookups by pid, by executable name and by executable path are hash lookups,
+    the parent->children relation is kept as an adjacency list.
+    Copies are cheap, because all members are implicitly shared.
+*/
+class ProcessSnapshot
+{
+public:
+    ProcessSnapshot();
+    explicit ProcessSnapshot(const QVector<Process> &processes);
+
+    const QVector<Process> &processes() const;
+    int size() const;
+    bool isEmpty() const;
+
+    bool containsPid(qint64 pid) const;
+    bool containsName(const QString &name) const;
+
+    Process findByPid(qint64 pid) const;
+    Process findByName(const QString &name) const;
+    Process findByPath(const QString &path) const;
+    QList<Process> findAllByName(const QString &name) const;
+
+    QList<Process> children(qint64 pid) const;
+    QList<Process> descendants(qint64 pid) const;
+
+    static QString normalizeName(const QString &nameOrPath);
+    static QString normalizePath(const QString &path);
+
+    static QString formatBytes(quint64 bytes);
+
+private:
+    QVector<Process> list;
+
+    QHash<qint64, int> byPid;
+    QMultiHash<quint32, int> byName; // key: ProcessStrings::nameKey()
+    QHash<quint32, int> byPath; // key: ProcessStrings::pathKey(), the first process of each path
+    QMultiHash<qint64, int> childrenByPpid;
+};
+
+#endif // PROCESSSNAPSHOT_H
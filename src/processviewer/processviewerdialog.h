@@ -3,12 +3,14 @@
 
 #include "src/csv.h"
 #include "src/processviewer/processes.h"
+#include "src/processviewer/processfilterproxymodel.h"
+#include "src/processviewer/processmodel.h"
 
 #include <QDesktopWidget>
 #include <QDialog>
 #include <QProcess>
 #include <QThread>
-#include <QTreeWidgetItem>
+#include <QTimer>
 
 namespace Ui
 {
@@ -23,9 +25,6 @@ public:
     explicit ProcessViewerDialog(QWidget *parent = false);
     ~ProcessViewerDialog();
 
-    QTreeWidgetItem *addRoot(Process process);
-    void addChild(QTreeWidgetItem *parent, Process process);
-
     void setChecked_ShowOnlyWpnxmProcesses();
     void setProcessesInstance(Processes *p);
 
@@ -33,25 +32,24 @@ private:
     Ui::ProcessViewerDialog *ui;
     Processes *processes;
 
-    QList<Process> runningProcesses;
-    QList<PidAndPort> ports;
-
-    void renderProcesses();
-    void refreshProcesses();
+    ProcessModel *model;
+    ProcessFilterProxyModel *proxy;
 
-    QList<PidAndPort> getPorts();
+    // live view, refreshes once per second
+    QTimer refreshTimer;
 
-    enum Columns
-    {
-        COLUMN_NAME = 0,
-        COLUMN_PID = 1,
-        COLUMN_PORT = 2,
-        COLUMN_MEM = 3,
-    };
+    // the port table walks the fds of all processes: it is refreshed
+    // every "portRefreshTicks" refreshes, or on demand
+    static const int portRefreshTicks = 10;
+    PortTable portTable;
+    int portTableAge;
 
-    void filter(QString filterByItem, const QString &query);
+    void refreshPorts();
 
 private slots:
+    void refreshProcesses();
+    void expandInsertedRows(const QModelIndex &parent, int first, int last);
+
     void on_lineEdit_searchProcessByName_textChanged(const QString &query);
     void on_lineEdit_searchProcessByPid_textChanged(const QString &query);
     void on_lineEdit_searchProcessByPort_textChanged(const QString &query);
@@ -0,0 +1,176 @@
+#include "processwaiter.h"
+#include "processes.h"
+
+#ifdef Q_OS_WIN
+#include <QWinEventNotifier>
+#else
+#include <QSocketNotifier>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#endif
+
+ProcessWaiter::ProcessWaiter(QObject *parent) : QObject(parent), running(false)
+{
+    timeout.setSingleShot(true);
+    connect(&timeout, SIGNAL(timeout()), this, SLOT(finish()));
+
+    probeTimer.setInterval(100);
+    connect(&probeTimer, SIGNAL(timeout()), this, SLOT(probe()));
+}
+
+ProcessWaiter::~ProcessWaiter() { cancel(); }
+
+/**
+ * Starts waiting for the processes, a running wait is cancelled.
+ */
+void ProcessWaiter::start(const QList<qint64> &pids, int timeoutMs)
+{
+    cancel();
+
+    running = true;
+
+    foreach (qint64 pid, pids) {
+        if (pid <= 0 || watchers.contains(pid) || probed.contains(pid)) {
+            continue;
+        }
+
+        // a process, which is already gone, is found by the first probe
+        if (!watch(pid)) {
+            probed.insert(pid);
+        }
+    }
+
+    if (!probed.isEmpty()) {
+        probeTimer.start();
+    }
+
+    timeout.start(qMax(timeoutMs, 0));
+
+    // the first probe finishes a wait for processes, which are all gone
+    QMetaObject::invokeMethod(this, "probe", Qt::QueuedConnection);
+}
+
+/**
+ * Stops waiting, without finished().
+ */
+void ProcessWaiter::cancel()
+{
+    foreach (qint64 pid, watchers.keys()) {
+        unwatch(pid);
+    }
+    probed.clear();
+
+    timeout.stop();
+    probeTimer.stop();
+
+    running = false;
+}
+
+bool ProcessWaiter::isRunning() const { return running; }
+
+bool ProcessWaiter::watch(qint64 pid)
+{
+#ifdef Q_OS_WIN
+    HANDLE hProcess = OpenProcess(SYNCHRONIZE, FALSE, DWORD(pid));
+    if (hProcess == NULL) {
+        return false;
+    }
+
+    QWinEventNotifier *notifier = new QWinEventNotifier(hProcess, this);
+    connect(notifier, SIGNAL(activated(HANDLE)), this, SLOT(watcherActivated()));
+#else
+    int pidFd = int(syscall(SYS_pidfd_open, pid_t(pid), 0));
+    if (pidFd < 0) {
+        return false; // gone or kernel < 5.3
+    }
+
+    // a pidfd becomes readable, when the process exits
+    QSocketNotifier *notifier = new QSocketNotifier(pidFd, QSocketNotifier::Read, this);
+    connect(notifier, SIGNAL(activated(int)), this, SLOT(watcherActivated()));
+#endif
+
+    notifier->setProperty("pid", pid);
+    watchers.insert(pid, notifier);
+
+    return true;
+}
+
+void ProcessWaiter::unwatch(qint64 pid)
+{
+    QObject *watcher = watchers.take(pid);
+    if (!watcher) {
+        return;
+    }
+
+#ifdef Q_OS_WIN
+    QWinEventNotifier *notifier = static_cast<QWinEventNotifier *>(watcher);
+    notifier->setEnabled(false);
+    CloseHandle(notifier->handle());
+#else
+    QSocketNotifier *notifier = static_cast<QSocketNotifier *>(watcher);
+    notifier->setEnabled(false);
+    close(int(notifier->socket()));
+#endif
+
+    notifier->deleteLater();
+}
+
+void ProcessWaiter::watcherActivated()
+{
+    qint64 pid = sender()->property("pid").toLongLong();
+
+    unwatch(pid);
+    processExited(pid);
+}
+
+void ProcessWaiter::probe()
+{
+    if (!running) {
+        return;
+    }
+
+    foreach (qint64 pid, probed) {
+        if (!Processes::isAlive(pid)) {
+            probed.remove(pid);
+            processExited(pid);
+        }
+    }
+
+    if (probed.isEmpty()) {
+        probeTimer.stop();
+    }
+
+    if (watchers.isEmpty() && probed.isEmpty()) {
+        finish();
+    }
+}
+
+void ProcessWaiter::processExited(qint64 pid)
+{
+    // the shared snapshot might still list the process
+    Processes::invalidateSnapshot();
+
+    emit exited(pid);
+
+    if (running && watchers.isEmpty() && probed.isEmpty()) {
+        finish();
+    }
+}
+
+void ProcessWaiter::finish()
+{
+    if (!running) {
+        return;
+    }
+
+    QList<qint64> stillRunning = watchers.keys() + probed.toList();
+
+    cancel();
+
+    emit finished(stillRunning);
+}
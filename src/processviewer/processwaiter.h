@@ -0,0 +1,55 @@
+#ifndef PROCESSWAITER_H
+#define PROCESSWAITER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+/// Waits for the exit of processes, without blocking the event loop.
+/*!
+    Every process is watched with a notifier on a pidfd (Linux) or on its
+    process handle (Windows), so exited() is emitted the moment a process
+    is gone. Processes without a watcher (kernels < 5.3, no access) are
+    probed every 100 ms.
+
+    finished() is emitted once, when all processes exited or the timeout
+    expired, never from within start(). Processes::waitForExit() is the
+    blocking counterpart, for the CLI.
+*/
+class ProcessWaiter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProcessWaiter(QObject *parent = 0);
+    ~ProcessWaiter();
+
+    void start(const QList<qint64> &pids, int timeoutMs);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void exited(qint64 pid);
+    void finished(const QList<qint64> &stillRunning);
+
+private slots:
+    void watcherActivated();
+    void probe();
+    void finish();
+
+private:
+    bool running;
+    QHash<qint64, QObject *> watchers;
+    QSet<qint64> probed; // no watcher available
+
+    QTimer timeout;
+    QTimer probeTimer;
+
+    bool watch(qint64 pid);
+    void unwatch(qint64 pid);
+    void processExited(qint64 pid);
+};
+
+#endif // PROCESSWAITER_H
@@ -0,0 +1,292 @@
+#include "resourcesampler.h"
+
+#include <QDateTime>
+
+namespace
+{
+    // the usage between two counter readings
+    ResourceSample makeSample(const ResourceCounters &previous, qint64 previousAt,
+                              const ResourceCounters &current, qint64 currentAt)
+    {
+        ResourceSample sample;
+        sample.timestamp = QDateTime::currentMSecsSinceEpoch();
+        sample.rssBytes = current.rssBytes;
+        sample.fdCount = current.fdCount;
+        sample.threadCount = current.threadCount;
+
+        qint64 elapsed = qMax<qint64>(currentAt - previousAt, 1);
+
+        if (current.cpuTimeMs > previous.cpuTimeMs) {
+            sample.cpuPercent = 100.0 * double(current.cpuTimeMs - previous.cpuTimeMs) / double(elapsed);
+        }
+        if (current.readBytes > previous.readBytes) {
+            sample.readBytesPerSecond = (current.readBytes - previous.readBytes) * 1000 / quint64(elapsed);
+        }
+        if (current.writeBytes > previous.writeBytes) {
+            sample.writeBytesPerSecond = (current.writeBytes - previous.writeBytes) * 1000 / quint64(elapsed);
+        }
+
+        return sample;
+    }
+}
+
+ResourceSampler::ResourceSampler(QObject *parent)
+    : QObject(parent), fineInterval(1000), coarseInterval(10000), fineCapacity(300), coarseCapacity(360),
+      ticks(0), ticksPerCoarse(10), sampleTimer(new QTimer)
+{
+    // the sample timer fires in the sampling thread, sample() runs there
+    sampleTimer->moveToThread(&thread);
+    connect(sampleTimer, &QTimer::timeout, this, &ResourceSampler::sample, Qt::DirectConnection);
+
+    connect(&discoveryTimer, SIGNAL(timeout()), this, SLOT(updatePids()));
+}
+
+ResourceSampler::~ResourceSampler()
+{
+    stop();
+    delete sampleTimer;
+}
+
+/**
+ * Processes with these executable names are sampled.
+ */
+void ResourceSampler::setWatchedNames(const QStringList &names)
+{
+    watchedNames.clear();
+    foreach (const QString &name, names) {
+        watchedNames.insert(ProcessStrings::intern(ProcessSnapshot::normalizeName(name)));
+    }
+}
+
+void ResourceSampler::setIntervals(int fineMs, int coarseMs)
+{
+    fineInterval = qMax(fineMs, 100);
+    coarseInterval = qMax(coarseMs, fineInterval);
+}
+
+void ResourceSampler::setHistorySize(int fineSamples, int coarseSamples)
+{
+    fineCapacity = qMax(fineSamples, 1);
+    coarseCapacity = qMax(coarseSamples, 1);
+}
+
+QList<qint64> ResourceSampler::pids() const
+{
+    QReadLocker locker(&lock);
+    return series.keys();
+}
+
+/**
+ * Returns the newest fine sample of the process or an invalid sample.
+ */
+ResourceSample ResourceSampler::latest(qint64 pid) const
+{
+    QReadLocker locker(&lock);
+
+    QHash<qint64, Series>::const_iterator it = series.constFind(pid);
+    if (it == series.constEnd() || it.value().fine.isEmpty()) {
+        return ResourceSample();
+    }
+
+    return it.value().fine.last();
+}
+
+/**
+ * Returns the samples of the process, oldest first.
+ */
+QVector<ResourceSample> ResourceSampler::history(qint64 pid, Resolution resolution) const
+{
+    QReadLocker locker(&lock);
+
+    QHash<qint64, Series>::const_iterator it = series.constFind(pid);
+    if (it == series.constEnd()) {
+        return QVector<ResourceSample>();
+    }
+
+    return (resolution == Fine) ? it.value().fine.toVector() : it.value().coarse.toVector();
+}
+
+/**
+ * Returns the port table of the last coarse sample, empty before the first one.
+ */
+PortTable ResourceSampler::portTable() const
+{
+    QReadLocker locker(&lock);
+    return ports;
+}
+
+void ResourceSampler::start()
+{
+    if (thread.isRunning()) {
+        return;
+    }
+
+    ticks = 0;
+    ticksPerCoarse = qMax(1, coarseInterval / fineInterval);
+    states.clear();
+
+    {
+        QWriteLocker locker(&lock);
+        series.clear();
+        ports = PortTable();
+    }
+
+    updatePids();
+    discoveryTimer.start(fineInterval);
+
+    clock.start();
+    sampleTimer->setInterval(fineInterval);
+
+    thread.start(QThread::LowPriority);
+    QMetaObject::invokeMethod(sampleTimer, "start", Qt::QueuedConnection);
+}
+
+void ResourceSampler::stop()
+{
+    discoveryTimer.stop();
+
+    if (!thread.isRunning()) {
+        return;
+    }
+
+    // timers have to be stopped from their own thread
+    QMetaObject::invokeMethod(sampleTimer, "stop", Qt::BlockingQueuedConnection);
+
+    thread.quit();
+    thread.wait();
+}
+
+/**
+ * Selects the processes to sample from the shared snapshot (GUI thread).
+ */
+void ResourceSampler::updatePids()
+{
+    ProcessSnapshot snapshot = Processes::snapshot();
+
+    QList<qint64> pids;
+    foreach (const Process &p, snapshot.processes()) {
+        if (watchedNames.contains(ProcessStrings::nameKey(p.nameId))) {
+            pids << p.pid;
+        }
+    }
+
+    QWriteLocker locker(&lock);
+    targets = pids;
+}
+
+/**
+ * Reads the counters of all selected processes (sampling thread).
+ *
+ * Every tick appends a fine sample, every n-th tick a coarse one.
+ * The PSS is read on coarse ticks and once for new processes, the port
+ * table (a walk of the fds of all processes) on coarse ticks only.
+ */
+void ResourceSampler::sample()
+{
+    bool coarse = (ticks++ % ticksPerCoarse) == 0;
+
+    QList<qint64> pids;
+    {
+        QReadLocker locker(&lock);
+        pids = targets;
+    }
+
+    QHash<qint64, ResourceSample> fineSamples;
+    QHash<qint64, ResourceSample> coarseSamples;
+    QSet<qint64> alive;
+
+    foreach (qint64 pid, pids) {
+        QHash<qint64, State>::iterator it = states.find(pid);
+        bool isNew = (it == states.end());
+
+        ResourceCounters counters;
+        if (!Processes::getResourceCounters(pid, counters, coarse || isNew)) {
+            continue; // gone
+        }
+
+        alive.insert(pid);
+        qint64 now = clock.elapsed();
+
+        // the first reading is the baseline of the deltas
+        if (isNew) {
+            State state;
+            state.fine = counters;
+            state.coarse = counters;
+            state.fineAt = now;
+            state.coarseAt = now;
+            state.pssBytes = counters.pssBytes;
+            states.insert(pid, state);
+            continue;
+        }
+
+        State &state = it.value();
+
+        if (coarse) {
+            state.pssBytes = counters.pssBytes;
+
+            ResourceSample sample = makeSample(state.coarse, state.coarseAt, counters, now);
+            sample.pssBytes = state.pssBytes;
+            coarseSamples.insert(pid, sample);
+
+            state.coarse = counters;
+            state.coarseAt = now;
+        }
+
+        ResourceSample sample = makeSample(state.fine, state.fineAt, counters, now);
+        sample.pssBytes = state.pssBytes;
+        fineSamples.insert(pid, sample);
+
+        state.fine = counters;
+        state.fineAt = now;
+    }
+
+    // forget processes which are gone or no longer selected
+    for (QHash<qint64, State>::iterator it = states.begin(); it != states.end();) {
+        if (!alive.contains(it.key())) {
+            it = states.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    PortTable portTable;
+    if (coarse) {
+        portTable = Processes::getPortTable();
+    }
+
+    {
+        QWriteLocker locker(&lock);
+
+        if (coarse) {
+            ports = portTable;
+        }
+
+        for (QHash<qint64, Series>::iterator it = series.begin(); it != series.end();) {
+            if (!states.contains(it.key())) {
+                it = series.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (QHash<qint64, ResourceSample>::const_iterator it = fineSamples.constBegin(); it != fineSamples.constEnd();
+             ++it) {
+            QHash<qint64, Series>::iterator s = series.find(it.key());
+            if (s == series.end()) {
+                Series newSeries;
+                newSeries.fine = RingBuffer<ResourceSample>(fineCapacity);
+                newSeries.coarse = RingBuffer<ResourceSample>(coarseCapacity);
+                s = series.insert(it.key(), newSeries);
+            }
+
+            s.value().fine.append(it.value());
+
+            QHash<qint64, ResourceSample>::const_iterator c = coarseSamples.constFind(it.key());
+            if (c != coarseSamples.constEnd()) {
+                s.value().coarse.append(c.value());
+            }
+        }
+    }
+
+    emit sampled();
+}
@@ -0,0 +1,129 @@
+#ifndef RESOURCESAMPLER_H
+#define RESOURCESAMPLER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+
+#include "processes.h"
+#include "ringbuffer.h"
+
+/// Resource usage of one process over one sampling interval.
+struct ResourceSample
+{
+    ResourceSample()
+        : timestamp(0), cpuPercent(0), rssBytes(0), pssBytes(0), readBytesPerSecond(0),
+          writeBytesPerSecond(0), fdCount(0), threadCount(0)
+    {
+    }
+
+    qint64 timestamp; // ms since epoch, 0 for "no sample"
+    double cpuPercent; // 100 = one core busy
+    quint64 rssBytes;
+    quint64 pssBytes; // refreshed at the coarse resolution only
+    quint64 readBytesPerSecond;
+    quint64 writeBytesPerSecond;
+    quint32 fdCount;
+    quint32 threadCount;
+
+    bool isValid() const { return timestamp != 0; }
+};
+
+/// Samples the resource usage of the server processes in the background.
+/*!
+    The processes to sample are selected by executable name from the shared
+    process snapshot. Their counters (see Processes::getResourceCounters())
+    are read on a separate thread, so the UI never waits for /proc.
+
+    Every process has two ring buffers: a fine one (default: every second,
+    5 minutes) and a coarse one (default: every 10 seconds, 1 hour).
+    The coarse samples average CPU and I/O over their interval and are the
+    only ones which read the (expensive) PSS. The port table of all
+    processes is taken at the coarse resolution as well.
+
+    All getters are thread-safe.
+*/
+class ResourceSampler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Resolution
+    {
+        Fine,
+        Coarse
+    };
+
+    explicit ResourceSampler(QObject *parent = 0);
+    ~ResourceSampler();
+
+    // the configuration is applied on start()
+    void setWatchedNames(const QStringList &names);
+    void setIntervals(int fineMs, int coarseMs);
+    void setHistorySize(int fineSamples, int coarseSamples);
+
+    QList<qint64> pids() const;
+    ResourceSample latest(qint64 pid) const;
+    QVector<ResourceSample> history(qint64 pid, Resolution resolution = Fine) const;
+    PortTable portTable() const;
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    // emitted from the sampling thread, after every fine sample
+    void sampled();
+
+private slots:
+    void updatePids();
+
+private:
+    struct Series
+    {
+        RingBuffer<ResourceSample> fine;
+        RingBuffer<ResourceSample> coarse;
+    };
+
+    // counters of the last fine and coarse sample
+    struct State
+    {
+        ResourceCounters fine;
+        ResourceCounters coarse;
+        qint64 fineAt;
+        qint64 coarseAt;
+        quint64 pssBytes;
+    };
+
+    int fineInterval;
+    int coarseInterval;
+    int fineCapacity;
+    int coarseCapacity;
+
+    QSet<quint32> watchedNames;
+
+    // shared between the threads
+    mutable QReadWriteLock lock;
+    QList<qint64> targets;
+    QHash<qint64, Series> series;
+    PortTable ports; // of the last coarse tick
+
+    // used by the sampling thread only
+    QHash<qint64, State> states;
+    QElapsedTimer clock;
+    int ticks;
+    int ticksPerCoarse;
+
+    QThread thread;
+    QTimer *sampleTimer;
+    QTimer discoveryTimer;
+
+    void sample();
+};
+
+#endif // RESOURCESAMPLER_H
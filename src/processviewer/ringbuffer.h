@@ -0,0 +1,62 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QVector>
+
+/// Fixed-size buffer keeping the newest values.
+/*!
+    Appending to a full buffer overwrites the oldest value.
+    The storage is allocated once, appending never allocates.
+    Index 0 is the oldest value.
+*/
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(int capacity = 0) : buffer(capacity), first(0), count(0) {}
+
+    int capacity() const { return buffer.size(); }
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+    void append(const T &value)
+    {
+        if (buffer.isEmpty()) {
+            return;
+        }
+
+        buffer[(first + count) % buffer.size()] = value;
+
+        if (count < buffer.size()) {
+            ++count;
+        } else {
+            first = (first + 1) % buffer.size();
+        }
+    }
+
+    const T &at(int i) const { return buffer.at((first + i) % buffer.size()); }
+    const T &last() const { return at(count - 1); }
+
+    QVector<T> toVector() const
+    {
+        QVector<T> values;
+        values.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            values.append(at(i));
+        }
+        return values;
+    }
+
+    void clear()
+    {
+        first = 0;
+        count = 0;
+    }
+
+private:
+    QVector<T> buffer;
+    int first;
+    int count;
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,254 @@
+#include "readinessprobe.h"
+
+#include <QDebug>
+#include <QSignalBlocker>
+
+namespace Servers
+{
+    namespace
+    {
+        // a management record (request id 0) asking for "FCGI_MPXS_CONNS"
+        const char fastCgiGetValues[] = {1, 9, 0, 0, 0, 17, 0, 0, 15, 0, 'F', 'C', 'G', 'I', '_', 'M', 'P',
+                                         'X', 'S', '_', 'C', 'O', 'N', 'N', 'S'};
+        const char fastCgiGetValuesResult = 10;
+        const int fastCgiHeaderLength = 8;
+    }
+
+    QString ProbeEndpoint::toString() const
+    {
+        return socketPath.isEmpty() ? host + ":" + QString::number(port) : socketPath;
+    }
+
+    ReadinessProbe::ReadinessProbe(const QString &serverName, QObject *parent)
+        : QObject(parent), serverName(serverName), current(-1), timeout(15000), initialBackoff(50),
+          maximumBackoff(1000), backoff(50), attempts(0)
+    {
+        retryTimer.setSingleShot(true);
+        attemptTimer.setSingleShot(true);
+
+        connect(&retryTimer, SIGNAL(timeout()), this, SLOT(attempt()));
+        connect(&attemptTimer, &QTimer::timeout, this, [this]() { retry(tr("timed out")); });
+
+        connect(&tcpSocket, SIGNAL(connected()), this, SLOT(connected()));
+        connect(&tcpSocket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(connectFailed()));
+        connect(&tcpSocket, SIGNAL(readyRead()), this, SLOT(readReply()));
+
+        connect(&localSocket, SIGNAL(connected()), this, SLOT(connected()));
+        connect(&localSocket, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(connectFailed()));
+        connect(&localSocket, SIGNAL(readyRead()), this, SLOT(readReply()));
+    }
+
+    void ReadinessProbe::setEndpoints(const QList<ProbeEndpoint> &endpoints)
+    {
+        this->endpoints = endpoints;
+    }
+
+    void ReadinessProbe::setTimeout(int timeoutMs) { timeout = timeoutMs; }
+
+    void ReadinessProbe::setBackoff(int initialMs, int maximumMs)
+    {
+        initialBackoff = qMax(initialMs, 1);
+        maximumBackoff = qMax(maximumMs, initialBackoff);
+    }
+
+    bool ReadinessProbe::isRunning() const { return current >= 0; }
+
+    void ReadinessProbe::start()
+    {
+        cancel();
+
+        current = 0;
+        attempts = 0;
+        backoff = initialBackoff;
+        lastError.clear();
+        elapsed.start();
+
+        if (endpoints.isEmpty()) {
+            finish(true);
+            return;
+        }
+
+        attempt();
+    }
+
+    void ReadinessProbe::cancel()
+    {
+        retryTimer.stop();
+        attemptTimer.stop();
+        closeSockets();
+        current = -1;
+    }
+
+    void ReadinessProbe::attempt()
+    {
+        if (!isRunning()) {
+            return;
+        }
+
+        const ProbeEndpoint &endpoint = endpoints.at(current);
+
+        closeSockets();
+        reply.clear();
+        ++attempts;
+
+        // a single connect never takes longer than the maximum backoff
+        attemptTimer.start(qMax<qint64>(qMin<qint64>(maximumBackoff, timeout - elapsed.elapsed()), 1));
+
+        if (endpoint.socketPath.isEmpty()) {
+            tcpSocket.connectToHost(endpoint.host, endpoint.port);
+        } else {
+            localSocket.connectToServer(endpoint.socketPath);
+        }
+    }
+
+    void ReadinessProbe::connected()
+    {
+        if (!isRunning()) {
+            return;
+        }
+
+        switch (endpoints.at(current).protocol) {
+        case ProbeEndpoint::Connect:
+            endpointReady();
+            break;
+        case ProbeEndpoint::RedisPing:
+            device()->write("PING\r\n");
+            break;
+        case ProbeEndpoint::MemcachedVersion:
+            device()->write("version\r\n");
+            break;
+        case ProbeEndpoint::FastCgiGetValues:
+            device()->write(fastCgiGetValues, sizeof(fastCgiGetValues));
+            break;
+        }
+    }
+
+    void ReadinessProbe::connectFailed()
+    {
+        if (!isRunning()) {
+            return;
+        }
+
+        retry(device()->errorString());
+    }
+
+    /**
+     * The Redis and memcached pings are answered by a single line, the
+     * FastCGI request by a record.
+     */
+    void ReadinessProbe::readReply()
+    {
+        if (!isRunning()) {
+            return;
+        }
+
+        reply += device()->readAll();
+
+        // a listen socket accepts the connection, a worker answers the record
+        if (endpoints.at(current).protocol == ProbeEndpoint::FastCgiGetValues) {
+            if (reply.size() < fastCgiHeaderLength) {
+                return;
+            }
+            if (reply.at(0) == 1 && reply.at(1) == fastCgiGetValuesResult) {
+                endpointReady();
+                return;
+            }
+            retry(tr("unexpected FastCGI record type %1").arg(int(reply.at(1))));
+            return;
+        }
+
+        if (!reply.contains('\n')) {
+            return;
+        }
+
+        if (endpoints.at(current).protocol == ProbeEndpoint::RedisPing) {
+            // Redis refuses commands, while loading the dataset from disk.
+            // Any other reply (e.g. "-NOAUTH") means it processes commands.
+            if (reply.startsWith("-LOADING")) {
+                retry(tr("still loading the dataset"));
+                return;
+            }
+            if (reply.startsWith('+') || reply.startsWith('-')) {
+                endpointReady();
+                return;
+            }
+        } else if (reply.startsWith("VERSION ")) {
+            endpointReady();
+            return;
+        }
+
+        retry(tr("unexpected reply \"%1\"").arg(QString::fromLatin1(reply.trimmed())));
+    }
+
+    void ReadinessProbe::retry(const QString &error)
+    {
+        lastError = error;
+
+        attemptTimer.stop();
+        closeSockets();
+
+        qint64 remaining = timeout - elapsed.elapsed();
+
+        if (remaining <= 0) {
+            finish(false, tr("%1 did not accept connections on %2 within %3 seconds (%4).")
+                              .arg(serverName)
+                              .arg(endpoints.at(current).toString())
+                              .arg(timeout / 1000)
+                              .arg(lastError));
+            return;
+        }
+
+        retryTimer.start(int(qMin<qint64>(backoff, remaining)));
+        backoff = qMin(backoff * 2, maximumBackoff);
+    }
+
+    void ReadinessProbe::endpointReady()
+    {
+        attemptTimer.stop();
+        closeSockets();
+
+        qDebug() << "[" + serverName + "] Accepting connections on" << endpoints.at(current).toString()
+                 << "after" << elapsed.elapsed() << "ms";
+
+        if (++current >= endpoints.size()) {
+            finish(true);
+            return;
+        }
+
+        backoff = initialBackoff;
+        attempt();
+    }
+
+    void ReadinessProbe::finish(bool success, const QString &reason)
+    {
+        qint64 ms = elapsed.elapsed();
+
+        cancel();
+
+        if (success) {
+            qDebug() << "[" + serverName + "] Ready after" << ms << "ms," << attempts << "connects";
+            emit ready(serverName, ms);
+        } else {
+            qDebug() << "[" + serverName + "] Readiness probe failed:" << reason;
+            emit failed(serverName, reason);
+        }
+    }
+
+    void ReadinessProbe::closeSockets()
+    {
+        // aborting a pending connect must not count as a failed attempt
+        QSignalBlocker tcpBlocker(tcpSocket);
+        QSignalBlocker localBlocker(localSocket);
+
+        tcpSocket.abort();
+        localSocket.abort();
+    }
+
+    QIODevice *ReadinessProbe::device()
+    {
+        if (endpoints.at(current).socketPath.isEmpty()) {
+            return &tcpSocket;
+        }
+        return &localSocket;
+    }
+}
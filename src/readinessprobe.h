@@ -0,0 +1,95 @@
+#ifndef READINESSPROBE_H
+#define READINESSPROBE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QLocalSocket>
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace Servers
+{
+    /// An address, where a server accepts connections when it is ready.
+    struct ProbeEndpoint
+    {
+        enum Protocol
+        {
+            Connect, // accepting the connection is enough
+            RedisPing, // "PING" => "+PONG"
+            MemcachedVersion, // "version" => "VERSION x.y.z"
+            FastCgiGetValues // FCGI_GET_VALUES => FCGI_GET_VALUES_RESULT
+        };
+
+        ProbeEndpoint() : port(0), protocol(Connect) {}
+
+        QString host;
+        quint16 port;
+        QString socketPath; // unix socket or named pipe, used instead of host:port
+        Protocol protocol;
+
+        QString toString() const;
+    };
+
+    /// Waits until a server accepts connections on all its endpoints.
+    /*!
+        The endpoints are connected to one after another, without blocking.
+        A refused or timed out connect is retried with exponential backoff
+        (50 ms, 100 ms, 200 ms, ... up to 1 s), until the overall timeout.
+        A protocol endpoint is ready, when the server answers the ping.
+    */
+    class ReadinessProbe : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ReadinessProbe(const QString &serverName, QObject *parent = 0);
+
+        void setEndpoints(const QList<ProbeEndpoint> &endpoints);
+        void setTimeout(int timeoutMs);
+        void setBackoff(int initialMs, int maximumMs);
+
+        bool isRunning() const;
+
+    public slots:
+        void start();
+        void cancel();
+
+    signals:
+        void ready(const QString &serverName, qint64 elapsedMs);
+        void failed(const QString &serverName, const QString &reason);
+
+    private slots:
+        void attempt();
+        void connected();
+        void connectFailed();
+        void readReply();
+
+    private:
+        QString serverName;
+        QList<ProbeEndpoint> endpoints;
+        int current;
+
+        int timeout;
+        int initialBackoff;
+        int maximumBackoff;
+        int backoff;
+        int attempts;
+
+        QTcpSocket tcpSocket;
+        QLocalSocket localSocket;
+        QTimer retryTimer;
+        QTimer attemptTimer; // of a single connect or ping
+        QElapsedTimer elapsed;
+        QString lastError;
+        QByteArray reply;
+
+        void retry(const QString &error);
+        void endpointReady();
+        void finish(bool success, const QString &reason = QString());
+        void closeSockets();
+        QIODevice *device();
+    };
+}
+
+#endif // READINESSPROBE_H
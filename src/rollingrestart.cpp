@@ -0,0 +1,256 @@
+#include "rollingrestart.h"
+#include "fastcgipool.h"
+#include "json.h"
+#include "servers.h"
+
+#include <QDebug>
+#include <QJsonObject>
+
+namespace Servers
+{
+    RollingRestart::RollingRestart(Servers *servers, QObject *parent)
+        : QObject(parent), servers(servers), probe("PHP"), phase(Idle), upstreamsMoved(false)
+    {
+        connect(&probe, SIGNAL(ready(QString, qint64)), this, SLOT(poolsReady()));
+        connect(&probe, SIGNAL(failed(QString, QString)), this, SLOT(poolsFailed(QString, QString)));
+
+        drainTimer.setSingleShot(true);
+        connect(&drainTimer, SIGNAL(timeout()), this, SLOT(drain()));
+    }
+
+    bool RollingRestart::isRunning() const { return phase != Idle; }
+
+    /**
+     * Points the upstream files back to the ports of the upstream
+     * configuration, after an incomplete restart.
+     * Returns true, if the files changed (nginx needs a reload).
+     */
+    bool RollingRestart::restoreUpstreams()
+    {
+        if (!upstreamsMoved) {
+            return false;
+        }
+
+        Servers::writeNginxUpstreamConfigs(File::JSON::load("./bin/wpnxm-scp/nginx-upstreams.json"));
+        upstreamsMoved = false;
+
+        return true;
+    }
+
+    void RollingRestart::start()
+    {
+        if (isRunning()) {
+            return;
+        }
+
+        upstreamPorts.clear();
+        foreach (FastCgiPool *pool, servers->getPHPPools()) {
+            upstreamPorts << pool->config().port;
+        }
+
+        if (upstreamPorts.isEmpty()) {
+            finish(false, tr("No PHP pool is running."));
+            return;
+        }
+
+        qDebug() << "[PHP] Rolling restart of the pools on" << upstreamPorts;
+
+        phase = ToShadowPorts;
+        startPools();
+    }
+
+    /**
+     * Stops the pools, which are not (or no longer) the PHP server.
+     */
+    void RollingRestart::cancel()
+    {
+        if (!isRunning()) {
+            return;
+        }
+
+        probe.cancel();
+        drainTimer.stop();
+
+        QList<FastCgiPool *> current = servers->getPHPPools();
+        QList<FastCgiPool *> others;
+        foreach (FastCgiPool *pool, oldPools + newPools) {
+            if (!current.contains(pool)) {
+                others << pool;
+            }
+        }
+        stopPools(others);
+        oldPools.clear();
+        newPools.clear();
+
+        finish(false, tr("The restart was cancelled."));
+    }
+
+    /**
+     * Starts a new pool next to each running pool and probes them.
+     */
+    void RollingRestart::startPools()
+    {
+        oldPools = servers->getPHPPools();
+        newPools.clear();
+
+        QList<ProbeEndpoint> endpoints;
+
+        for (int i = 0; i < oldPools.size(); ++i) {
+            FastCgiPoolConfig config = oldPools.at(i)->config();
+            config.port = (phase == ToShadowPorts) ? 0 : upstreamPorts.at(i);
+
+            FastCgiPool *pool = new FastCgiPool(config, servers->processMonitor, servers);
+
+            QString error;
+            if (!pool->start(&error)) {
+                delete pool;
+                poolsFailed("PHP", tr("The new pool failed to listen on port %1: %2").arg(config.port).arg(error));
+                return;
+            }
+
+            newPools << pool;
+
+            ProbeEndpoint endpoint;
+            endpoint.host = "127.0.0.1";
+            endpoint.port = pool->config().port;
+            endpoint.protocol = ProbeEndpoint::FastCgiGetValues;
+            endpoints << endpoint;
+        }
+
+        probe.setEndpoints(endpoints);
+        probe.setTimeout(servers->settings->get("servers/starttimeout", 15000).toInt());
+        probe.start();
+    }
+
+    /**
+     * The new pools serve: nginx is switched over to them.
+     */
+    void RollingRestart::poolsReady()
+    {
+        QList<quint16> ports;
+        foreach (FastCgiPool *pool, newPools) {
+            ports << pool->config().port;
+        }
+
+        writeUpstreams(ports);
+        upstreamsMoved = (phase == ToShadowPorts);
+
+        // from now on the new pools are the PHP server
+        for (int i = 0; i < oldPools.size(); ++i) {
+            servers->replacePHPPool(oldPools.at(i), newPools.at(i));
+        }
+
+        servers->reloadNginx();
+
+        // the old nginx workers finish their requests with the old upstreams
+        drainTimer.start(servers->settings->get("php/draindelay", 2000).toInt());
+    }
+
+    void RollingRestart::poolsFailed(const QString &serverName, const QString &reason)
+    {
+        Q_UNUSED(serverName)
+
+        probe.cancel();
+
+        stopPools(newPools);
+        newPools.clear();
+
+        finish(false, reason);
+    }
+
+    /**
+     * Stops the old pools gracefully, then swaps back to the upstream ports.
+     */
+    void RollingRestart::drain()
+    {
+        stopPools(oldPools);
+        oldPools.clear();
+        newPools.clear();
+
+        if (phase == ToShadowPorts) {
+            phase = ToUpstreamPorts;
+            startPools();
+            return;
+        }
+
+        finish(true);
+    }
+
+    /**
+     * Stops the pools without waiting, their workers finish their requests.
+     * The pools are deleted from the event loop: a caller up the stack might
+     * still use them.
+     */
+    void RollingRestart::stopPools(const QList<FastCgiPool *> &pools)
+    {
+        foreach (FastCgiPool *pool, pools) {
+            pool->stop();
+            pool->deleteLater();
+        }
+    }
+
+    void RollingRestart::writeUpstreams(const QList<quint16> &ports)
+    {
+        QJsonDocument upstreams = File::JSON::load("./bin/wpnxm-scp/nginx-upstreams.json");
+
+        Servers::writeNginxUpstreamConfigs(withPorts(upstreams, upstreamPorts, ports));
+    }
+
+    void RollingRestart::finish(bool success, const QString &reason)
+    {
+        phase = Idle;
+
+        if (success) {
+            qDebug() << "[PHP] Rolling restart finished";
+            emit finished(true, reason);
+            return;
+        }
+
+        // the pools on the shadow ports keep serving, until PHP is stopped
+        QString message = reason;
+        if (upstreamsMoved) {
+            message += " " + tr("nginx uses the PHP pools on temporary ports, until PHP is restarted.");
+        }
+
+        qDebug() << "[PHP] Rolling restart failed:" << message;
+
+        emit finished(false, message);
+    }
+
+    /**
+     * Returns the upstream configuration with the ports of the local servers
+     * replaced.
+     */
+    QJsonDocument RollingRestart::withPorts(const QJsonDocument &upstreams, const QList<quint16> &from,
+                                            const QList<quint16> &to)
+    {
+        QJsonObject json = upstreams.object();
+        QJsonObject jsonPools = json["pools"].toObject();
+
+        for (QJsonObject::Iterator pool = jsonPools.begin(); pool != jsonPools.end(); ++pool) {
+            QJsonObject jsonPool = pool.value().toObject();
+            QJsonObject jsonServers = jsonPool["servers"].toObject();
+
+            for (QJsonObject::Iterator server = jsonServers.begin(); server != jsonServers.end(); ++server) {
+                QJsonObject s = server.value().toObject();
+
+                if (s["address"].toString() != "localhost" && s["address"].toString() != "127.0.0.1") {
+                    continue;
+                }
+
+                int i = from.indexOf(s["port"].toString().toUShort());
+                if (i >= 0) {
+                    s["port"] = QString::number(to.at(i));
+                    server.value() = s;
+                }
+            }
+
+            jsonPool["servers"] = jsonServers;
+            pool.value() = jsonPool;
+        }
+
+        json["pools"] = jsonPools;
+
+        return QJsonDocument(json);
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef ROLLINGRESTART_H
+#define ROLLINGRESTART_H
+
+#include <QJsonDocument>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+#include "readinessprobe.h"
+
+namespace Servers
+{
+    class FastCgiPool;
+    class Servers;
+
+    /// Restarts the PHP pools without dropping a request.
+    /*!
+        A new pool is started next to each running pool, on a free "shadow"
+        port. When all new pools answer a FastCGI request, the nginx upstreams
+        are pointed to them and nginx is reloaded. After "php/draindelay" ms
+        (nginx starts its new workers) the old pools are stopped gracefully:
+        their workers finish the requests in flight.
+
+        The same swap is then done back to the ports of the upstream
+        configuration, so the upstream files and "nginx-upstreams.json" agree
+        again. If the new pools don't become ready, they are stopped and the
+        old pools keep serving.
+    */
+    class RollingRestart : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit RollingRestart(Servers *servers, QObject *parent = 0);
+
+        bool isRunning() const;
+        bool restoreUpstreams();
+
+    public slots:
+        void start();
+        void cancel();
+
+    signals:
+        void finished(bool success, const QString &reason);
+
+    private slots:
+        void poolsReady();
+        void poolsFailed(const QString &serverName, const QString &reason);
+        void drain();
+
+    private:
+        enum Phase
+        {
+            Idle,
+            ToShadowPorts,
+            ToUpstreamPorts
+        };
+
+        Servers *servers;
+        ReadinessProbe probe;
+        QTimer drainTimer;
+        Phase phase;
+
+        QList<FastCgiPool *> oldPools;
+        QList<FastCgiPool *> newPools;
+        QList<quint16> upstreamPorts; // of the pools, in "nginx-upstreams.json"
+        bool upstreamsMoved; // the upstream files point to shadow ports
+
+        void startPools();
+        void stopPools(const QList<FastCgiPool *> &pools);
+        void writeUpstreams(const QList<quint16> &ports);
+        void finish(bool success, const QString &reason = QString());
+
+        static QJsonDocument withPorts(const QJsonDocument &upstreams, const QList<quint16> &from,
+                                       const QList<quint16> &to);
+    };
+}
+
+#endif // ROLLINGRESTART_H
@@ -0,0 +1,53 @@
+#include "serverdescriptors.h"
+
+#include <QHash>
+
+namespace Servers
+{
+    namespace
+    {
+        // the table is ordered by id, descriptor() indexes it directly
+        constexpr bool isOrderedById(int i)
+        {
+            return i == serverCount || (int(serverDescriptors[i].id) == i && isOrderedById(i + 1));
+        }
+        static_assert(isOrderedById(0), "serverDescriptors must be ordered by ServerId");
+
+        QHash<QString, const ServerDescriptor *> buildNameIndex()
+        {
+            QHash<QString, const ServerDescriptor *> index;
+
+            for (int i = 0; i < serverCount; ++i) {
+                const ServerDescriptor *d = &serverDescriptors[i];
+
+                QStringList names = QStringList() << d->name << d->key;
+                names << splitList(d->aliases) << splitList(d->processNames);
+
+                foreach (const QString &name, names) {
+                    index.insert(name.toLower(), d);
+                }
+            }
+
+            return index;
+        }
+    }
+
+    /**
+     * Returns the descriptor of a server by name, key, alias or process name
+     * (case-insensitive) or 0.
+     */
+    const ServerDescriptor *findDescriptor(const QString &name)
+    {
+        static const QHash<QString, const ServerDescriptor *> index = buildNameIndex();
+
+        return index.value(name.toLower(), 0);
+    }
+
+    QStringList splitList(const char *list)
+    {
+        if (!list) {
+            return QStringList();
+        }
+        return QString::fromLatin1(list).split(' ', QString::SkipEmptyParts);
+    }
+}
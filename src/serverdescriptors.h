@@ -0,0 +1,105 @@
+#ifndef SERVERDESCRIPTORS_H
+#define SERVERDESCRIPTORS_H
+
+#include <QString>
+#include <QStringList>
+
+namespace Servers
+{
+    enum class ServerId
+    {
+        Nginx,
+        PHP,
+        MariaDb,
+        MongoDb,
+        Memcached,
+        PostgreSQL,
+        Redis
+    };
+
+    /// Everything the control panel knows about a server, as data.
+    /*!
+        Lists are space separated. Command arguments are templates:
+        "${root}" is the current path, "${exe}" the server executable,
+        "${group/key}" or "${group/key=default}" a setting.
+        A server without stop program is stopped by killing its processes.
+    */
+    struct ServerDescriptor
+    {
+        ServerId id;
+        const char *name; // label and object names, e.g. "MariaDb"
+        const char *key; // settings group, CLI and autostart name, e.g. "mariadb"
+        const char *aliases; // other names of the server
+        const char *processNames; // executable names of its processes, the first is the main process
+        const char *exe; // in "paths/<key>"
+        const char *logFiles; // in "paths/logs"
+        const char *configKey; // setting of the config file
+        const char *portKey; // setting of the port, 0 for none
+        quint16 defaultPort;
+        bool baseInstall; // part of the base package, always considered installed
+        bool detached; // start with Processes::startDetached()
+        const char *startArguments;
+        const char *stopProgram;
+        const char *stopArguments;
+        const char *versionProgram;
+        const char *versionArguments;
+    };
+
+    // clang-format off
+    constexpr ServerDescriptor serverDescriptors[] = {
+        {ServerId::Nginx, "Nginx", "nginx", "", "nginx", "nginx.exe", "error.log access.log",
+         "nginx/config", "nginx/port", 80, true, false,
+         "-p ${root} -c ${root}/bin/nginx/conf/nginx.conf",
+         "${exe}", "-p ${root} -c ${root}/bin/nginx/conf/nginx.conf -s stop",
+         "./bin/nginx/nginx.exe", "-v"},
+        // the pools are started from the nginx upstream configuration, see Servers::startPHP()
+        {ServerId::PHP, "PHP", "php", "php-cgi-spawner", "spawn php-cgi", "php-cgi.exe", "php_error.log",
+         "php/config", 0, 0, true, true,
+         0, 0, 0,
+         "./bin/php/php.exe", "-v"},
+        {ServerId::MariaDb, "MariaDb", "mariadb", "mysql", "mysqld", "mysqld.exe", "mariadb_error.log",
+         "mariadb/config", "mariadb/port", 3306, true, true,
+         // --standalone is important! else maria is started as service and won't detach
+         "--defaults-file=${root}/bin/mariadb/my.ini --standalone",
+         "${root}/bin/mariadb/bin/mysqladmin.exe", "-u root shutdown",
+         "./bin/mariadb/bin/mysqlcheck.exe", "-V"},
+        // mongodb is stopped via "mongo.exe --eval", not "mongod.exe"
+        {ServerId::MongoDb, "MongoDb", "mongodb", "mongo", "mongod", "mongod.exe", "mongodb.log",
+         "mongodb/config", "mongodb/port", 27015, false, true,
+         "--config ${root}/bin/mongodb/mongodb.conf --dbpath ${root}/bin/mongodb/data/db "
+         "--logpath ${root}/logs/mongodb.log --storageEngine=${mongodb/storageengine=wiredTiger} "
+         "--journal --httpinterface --rest",
+         "${root}/bin/mongodb/bin/mongo.exe", "--eval \"db.getSiblingDB('admin').shutdownServer()\"",
+         "./bin/mongodb/bin/mongod.exe", "--version"},
+        // memcached doesn't provide a shutdown command, its process is killed
+        // https://github.com/memcached/memcached/wiki/ConfiguringServer#commandline-arguments
+        {ServerId::Memcached, "Memcached", "memcached", "", "memcached", "memcached.exe", "",
+         "memcached/config", "memcached/tcpport", 11211, false, true,
+         "-p ${memcached/tcpport} -U ${memcached/udpport} -t ${memcached/threads} "
+         "-c ${memcached/maxconnections} -m ${memcached/maxmemory}",
+         0, 0,
+         "./bin/memcached/memcached.exe", "-h"},
+        // "pg_ctl" is only a launcher for "postgres"
+        {ServerId::PostgreSQL, "PostgreSQL", "postgresql", "pgsql", "postgres", "pg_ctl.exe", "postgresql.log",
+         "postgresql/config", "postgresql/port", 5432, false, false,
+         "--pgdata ${root}/bin/pgsql/data --log ${root}/logs/postgresql.log start",
+         "${exe}", "stop --pgdata ${root}/bin/pgsql/data --log ${root}/logs/postgresql.log --mode=fast -W",
+         "./bin/pgsql/bin/pg_ctl.exe", "-V"},
+        // "-a password" is not supported, yet
+        {ServerId::Redis, "Redis", "redis", "", "redis-server", "redis-server.exe", "redis.log",
+         "redis/config", "redis/port", 6379, false, true,
+         "redis.windows.conf",
+         "${root}/bin/redis/redis-cli.exe", "-h ${redis/bind=127.0.0.1} -p ${redis/port} shutdown",
+         "./bin/redis/redis-server.exe", "-v"},
+    };
+    // clang-format on
+
+    constexpr int serverCount = sizeof(serverDescriptors) / sizeof(serverDescriptors[0]);
+
+    constexpr const ServerDescriptor &descriptor(ServerId id) { return serverDescriptors[int(id)]; }
+
+    const ServerDescriptor *findDescriptor(const QString &name);
+    QStringList splitList(const char *list);
+}
+
+#endif // SERVERDESCRIPTORS_H
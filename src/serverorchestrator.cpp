@@ -0,0 +1,189 @@
+#include "serverorchestrator.h"
+#include "servers.h"
+
+#include <QDebug>
+#include <QEventLoop>
+#include <QTimer>
+
+namespace Servers
+{
+    ServerOrchestrator::ServerOrchestrator(Servers *servers)
+        : QObject(servers), servers(servers), mode(Idle), advancing(false), advanceAgain(false)
+    {
+        connect(servers, &Servers::serverStateChanged, this, &ServerOrchestrator::serverStateChanged);
+    }
+
+    /**
+     * Declares, that a server needs another server (e.g. Nginx needs the PHP
+     * upstream pools).
+     */
+    void ServerOrchestrator::addDependency(const QString &serverName, const QString &dependsOn)
+    {
+        dependencies.insert(serverName, dependsOn);
+    }
+
+    bool ServerOrchestrator::isBusy() const { return mode != Idle; }
+
+    /**
+     * Runs a local event loop, until the current start or stop is finished.
+     * Used on quit, where no event loop runs anymore.
+     * Returns false on timeout.
+     */
+    bool ServerOrchestrator::waitForFinished(int timeoutMs)
+    {
+        if (mode == Idle) {
+            return true;
+        }
+
+        QEventLoop loop;
+        connect(this, SIGNAL(serversStarted()), &loop, SLOT(quit()));
+        connect(this, SIGNAL(serversStopped()), &loop, SLOT(quit()));
+        QTimer::singleShot(timeoutMs, &loop, SLOT(quit()));
+        loop.exec();
+
+        return mode == Idle;
+    }
+
+    void ServerOrchestrator::startServers(const QStringList &serverNames)
+    {
+        qDebug() << "[Servers] Starting" << serverNames;
+
+        mode = Starting;
+        requested = QSet<QString>::fromList(serverNames);
+        pending = requested;
+        inProgress.clear();
+        elapsed.start();
+
+        advance();
+    }
+
+    void ServerOrchestrator::stopServers(const QStringList &serverNames)
+    {
+        qDebug() << "[Servers] Stopping" << serverNames;
+
+        mode = Stopping;
+        requested = QSet<QString>::fromList(serverNames);
+        pending = requested;
+        inProgress.clear();
+        elapsed.start();
+
+        advance();
+    }
+
+    void ServerOrchestrator::serverStateChanged(const QString &serverName)
+    {
+        if (mode != Idle && (inProgress.contains(serverName) || !pending.isEmpty())) {
+            advance();
+        }
+    }
+
+    /**
+     * A server is blocked, while a server it depends on is still starting
+     * (start), or while a server which depends on it is still running (stop).
+     */
+    bool ServerOrchestrator::isBlocked(const QString &serverName) const
+    {
+        if (mode == Starting) {
+            foreach (const QString &dependency, dependencies.values(serverName)) {
+                Server::State state = servers->getServerState(dependency);
+                if (state == Server::Starting || (requested.contains(dependency) && !isDone(dependency))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        for (QMultiHash<QString, QString>::const_iterator it = dependencies.constBegin();
+             it != dependencies.constEnd(); ++it) {
+            if (it.value() != serverName) {
+                continue;
+            }
+            Server::State state = servers->getServerState(it.key());
+            if (state == Server::Stopping || (requested.contains(it.key()) && !isDone(it.key()))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ServerOrchestrator::isDone(const QString &serverName) const
+    {
+        Server::State state = servers->getServerState(serverName);
+
+        if (mode == Starting) {
+            return state == Server::Ready || state == Server::Failed;
+        }
+        return state == Server::Stopped || state == Server::Failed;
+    }
+
+    /**
+     * Issues the commands for all unblocked servers and finishes, when all
+     * requested servers reached their target state.
+     * Commands change states synchronously, so advance() is re-entered by
+     * serverStateChanged(). The re-entry is turned into another iteration.
+     */
+    void ServerOrchestrator::advance()
+    {
+        if (advancing) {
+            advanceAgain = true;
+            return;
+        }
+        advancing = true;
+
+        do {
+            advanceAgain = false;
+
+            foreach (const QString &serverName, inProgress) {
+                if (isDone(serverName)) {
+                    inProgress.remove(serverName);
+                    qDebug() << "[Servers]" << serverName << "done after" << elapsed.elapsed() << "ms";
+                }
+            }
+
+            QStringList ready;
+            foreach (const QString &serverName, pending) {
+                if (!isBlocked(serverName)) {
+                    ready << serverName;
+                }
+            }
+
+            // a dependency cycle: nothing can proceed, ignore the dependencies
+            if (ready.isEmpty() && inProgress.isEmpty() && !pending.isEmpty()) {
+                qDebug() << "[Servers] Dependency cycle between" << pending.toList();
+                ready = pending.toList();
+            }
+
+            foreach (const QString &serverName, ready) {
+                pending.remove(serverName);
+                inProgress.insert(serverName);
+
+                if (mode == Starting) {
+                    servers->startServer(serverName);
+                } else {
+                    servers->stopServer(serverName);
+                }
+            }
+
+            // servers already in their target state do not change state
+            if (!ready.isEmpty()) {
+                advanceAgain = true;
+            }
+        } while (advanceAgain);
+
+        advancing = false;
+
+        if (mode != Idle && pending.isEmpty() && inProgress.isEmpty()) {
+            Mode finished = mode;
+            mode = Idle;
+
+            qDebug() << "[Servers]" << (finished == Starting ? "Started" : "Stopped") << requested.toList() << "in"
+                     << elapsed.elapsed() << "ms";
+
+            if (finished == Starting) {
+                emit serversStarted();
+            } else {
+                emit serversStopped();
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SERVERORCHESTRATOR_H
+#define SERVERORCHESTRATOR_H
+
+#include <QElapsedTimer>
+#include <QMultiHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+namespace Servers
+{
+    class Servers;
+
+    /// Starts and stops groups of servers, honouring their dependencies.
+    /*!
+        Servers without (pending) dependencies are started together, a server
+        is started as soon as all servers it depends on are ready (or failed).
+        Stopping runs in reverse: a server is stopped after all servers which
+        depend on it are stopped.
+        Everything is driven by the state changes of the servers, nothing
+        blocks the event loop. So starting all servers takes about as long as
+        the slowest dependency chain, not the sum of all start times.
+    */
+    class ServerOrchestrator : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ServerOrchestrator(Servers *servers);
+
+        void addDependency(const QString &serverName, const QString &dependsOn);
+
+        bool isBusy() const;
+        bool waitForFinished(int timeoutMs);
+
+    public slots:
+        void startServers(const QStringList &serverNames);
+        void stopServers(const QStringList &serverNames);
+
+    signals:
+        void serversStarted();
+        void serversStopped();
+
+    private slots:
+        void serverStateChanged(const QString &serverName);
+
+    private:
+        enum Mode
+        {
+            Idle,
+            Starting,
+            Stopping
+        };
+
+        Servers *servers;
+
+        // server => servers it depends on
+        QMultiHash<QString, QString> dependencies;
+
+        Mode mode;
+        QSet<QString> requested;
+        QSet<QString> pending; // waiting for dependencies
+        QSet<QString> inProgress; // start or stop command issued
+        QElapsedTimer elapsed;
+
+        bool advancing;
+        bool advanceAgain;
+
+        bool isBlocked(const QString &serverName) const;
+        bool isDone(const QString &serverName) const;
+        void advance();
+    };
+}
+
+#endif // SERVERORCHESTRATOR_H
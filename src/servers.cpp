@@ -1,12 +1,37 @@
 #include "servers.h"
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+
+#include <algorithm>
 
 namespace Servers
 {
     Servers::Servers(QObject *parent)
-        : QObject(parent), settings(new Settings::SettingsManager)
+        : QObject(parent), processes(Processes::getInstance()),
+          processMonitor(new ProcessMonitor(this)), resourceSampler(new ResourceSampler(this)),
+          orchestrator(new ServerOrchestrator(this)), versions(new ServerVersions(this)),
+          logRotator(new LogRotator(this)), settings(new Settings::SettingsManager),
+          phpRestart(new RollingRestart(this, this))
     {
+        QStringList serverProcessNames;
+        for (const ServerDescriptor &d : serverDescriptors) {
+            serverProcessNames << splitList(d.processNames);
+        }
+
+        // exits of server processes are reported immediately
+        processMonitor->setWatchedNames(serverProcessNames);
+
+        versions->setTimeout(settings->get("servers/versiontimeout", 5000).toInt());
+
+        // CPU, memory, I/O and fds of the server processes (1s / 10s resolution)
+        resourceSampler->setWatchedNames(serverProcessNames);
+        resourceSampler->setIntervals(settings->get("monitoring/sampleinterval", 1000).toInt(),
+                                      settings->get("monitoring/coarsesampleinterval", 10000).toInt());
+
         QStringList installedServers = getListOfServerNamesInstalled();
 
         qDebug() << "[Servers] Create Server objects and tray submenus for installed servers.";
@@ -47,657 +72,894 @@ namespace Servers
 
             server->trayMenu = menu;
 
+            connect(&server->deadline, &QTimer::timeout, this, [this, server]() { deadlineExpired(server); });
+
+            // servers which are already running
+            if (isServerRunning(server->name)) {
+                server->state = Server::Ready;
+            }
+
             serverList << server;
 
             qDebug() << "[Servers] Server object added to serverList:\t" << serverName;
         }
-    }
 
-    void Servers::mapAction(QAction *action)
-    {
-        QMetaObject::invokeMethod(this,
-                                  action->objectName().toLocal8Bit().constData());
-    }
+        // the state machines are driven by process start and exit events
+        connect(processMonitor, SIGNAL(processStarted(qint64, QString)), this,
+                SLOT(processStarted(qint64, QString)));
+        connect(processMonitor, SIGNAL(processExited(qint64, int)), this,
+                SLOT(processExited(qint64, int)));
 
-    /**
- * @brief Servers::getCamelCasedServerName
- * translates lowercase server and process names to internally used camel-cased
- * label names
- * @param serverName
- * @return
- */
-    QString Servers::getCamelCasedServerName(QString &serverName) const
-    {
-        if (serverName == "nginx") {
-            return "Nginx";
-        }
-        if (serverName == "mariadb" || serverName == "mysqld") {
-            return "MariaDb";
-        }
-        if (serverName == "php" || serverName == "php-cgi") {
-            return "PHP";
+        // a failed rolling restart is reported, PHP keeps running
+        connect(phpRestart, SIGNAL(finished(bool, QString)), this, SLOT(phpRestartFinished(bool, QString)));
+
+        // Nginx passes requests to the PHP upstream pools
+        orchestrator->addDependency("Nginx", "PHP");
+
+        // nginx reopens its logs, PHP opens its log per write,
+        // the other servers hold their logs open
+        QString logs = QDir(settings->get("paths/logs").toString()).absolutePath();
+        for (const ServerDescriptor &d : serverDescriptors) {
+            LogRotator::Method method =
+                (d.id == ServerId::Nginx || d.id == ServerId::PHP) ? LogRotator::Rename : LogRotator::CopyTruncate;
+            foreach (const QString &logFile, splitList(d.logFiles)) {
+                logRotator->addLog(d.name, logs + "/" + logFile, method);
+            }
         }
-        if (serverName == "spawn" || serverName == "php-cgi-spawner") {
-            return "Spawn";
+
+        LogRotator::Policy policy;
+        policy.maxBytes = settings->get("logs/maxsize", 10).toLongLong() * 1024 * 1024;
+        policy.maxAgeDays = settings->get("logs/maxage", 7).toInt();
+        policy.keep = settings->get("logs/keep", 5).toInt();
+        policy.compressionLevel = settings->get("logs/compressionlevel", 6).toInt();
+        logRotator->setPolicy(policy);
+        logRotator->setCheckInterval(settings->get("logs/checkinterval", 60000).toInt());
+
+        connect(logRotator, SIGNAL(logsRenamed(QString)), this, SLOT(reopenLogs(QString)));
+
+        if (settings->get("logs/rotate", true).toBool()) {
+            logRotator->start();
         }
-        if (serverName == "memcached") {
-            return "Memcached";
+
+        // request statistics of the nginx access logs, see "nginx/logformat"
+        AccessLogFormat format(settings->get("nginx/logformat", AccessLogFormat::combined).toString());
+        if (!format.isValid()) {
+            qDebug() << "[Nginx] Invalid \"nginx/logformat\", using the combined format.";
+            format = AccessLogFormat();
         }
-        if (serverName == "mongodb" || serverName == "mongod") {
-            return "MongoDb";
+
+        QString nginx("nginx");
+        QStringList accessLogs;
+        foreach (const QString &logFile, getLogFiles(nginx)) {
+            if (!QFileInfo(logFile).fileName().contains("error")) {
+                accessLogs << logFile;
+            }
         }
-        if (serverName == "postgresql" || serverName == "postgres") {
-            return "PostgreSQL";
+
+        accessLog = new AccessLogAnalyzer(accessLogs, format, this);
+        accessLog->setInterval(settings->get("nginx/statsinterval", 1000).toInt());
+
+        connect(logRotator, &LogRotator::logsRenamed, accessLog, [this](const QString &serverName) {
+            if (serverName == "Nginx") {
+                accessLog->restart();
+            }
+        });
+
+        // the log is followed, while nginx runs
+        connect(this, &Servers::serverStateChanged, accessLog, [this](const QString &serverName, Server::State state) {
+            if (serverName == "Nginx" && state == Server::Ready) {
+                accessLog->start();
+            } else if (serverName == "Nginx" && (state == Server::Stopped || state == Server::Failed)) {
+                accessLog->stop();
+            }
+        });
+
+        // the error logs, grouped by fingerprint, see "errorlogs/backlog"
+        errorLogs = new ErrorLogAggregator(settings->get("errorlogs/backlog", 1024 * 1024).toLongLong(), 10000, this);
+        errorLogs->setInterval(settings->get("errorlogs/interval", 1000).toInt());
+
+        for (const ServerDescriptor &d : serverDescriptors) {
+            if (d.id != ServerId::Nginx && d.id != ServerId::PHP && d.id != ServerId::MariaDb &&
+                d.id != ServerId::Redis) {
+                continue;
+            }
+            QString serverName(d.name);
+            foreach (const QString &logFile, getLogFiles(serverName)) {
+                if (!QFileInfo(logFile).fileName().contains("access")) {
+                    errorLogs->addLog(serverName, logFile);
+                }
+            }
         }
-        if (serverName == "redis" || serverName == "redis-server") {
-            return "Redis";
+
+        connect(logRotator, SIGNAL(logsRenamed(QString)), errorLogs, SLOT(restart(QString)));
+
+        if (settings->get("errorlogs/aggregate", true).toBool()) {
+            errorLogs->start();
         }
+    }
 
-        return QString("Unknown");
+    Server::Server() : trayMenu(0), state(Stopped), restartPending(false), probe(0)
+    {
+        deadline.setSingleShot(true);
     }
 
-    QStringList Servers::getLogFiles(QString &serverName) const
+    void Servers::mapAction(QAction *action)
     {
-        QString s = serverName.toLower();
-        QString logs = QDir(settings->get("paths/logs").toString()).absolutePath();
+        // the object names are "<command><ServerName>", e.g. "startNginx"
+        QString name = action->objectName();
+
+        if (name.startsWith("restart")) {
+            restartServer(name.mid(7));
+        } else if (name.startsWith("start")) {
+            startServer(name.mid(5));
+        } else if (name.startsWith("stop")) {
+            stopServer(name.mid(4));
+        }
+    }
 
-        QStringList logfiles;
+    /**
+     * Starts a server: Stopped -> Starting -> Ready (or Failed).
+     *
+     * The server specific start command is issued and returns immediately.
+     * The server is Ready, when it accepts connections on its ports (see
+     * startReadinessProbe()) or, for servers without ports, when its process
+     * shows up (see processStarted()). It failed, when the process exits or
+     * the server is not ready before "servers/starttimeout".
+     */
+    void Servers::startServer(const QString &serverName)
+    {
+        Server *server = findServer(serverName);
 
-        if (s == "nginx") {
-            logfiles << logs + "/error.log" << logs + "/access.log";
-        }
-        if (s == "memcached") {
-            logfiles << "";
-        }
-        if (s == "mongodb") {
-            logfiles << logs + "/mongodb.log";
-        }
-        if (s == "mariadb") {
-            logfiles << logs + "/mariadb_error.log";
+        if (!server) {
+            qDebug() << "[" + serverName + "] Is not installed. Skipping start command.";
+            return;
         }
-        if (s == "php") {
-            logfiles << logs + "/php_error.log";
+
+        switch (server->state) {
+        case Server::Starting:
+        case Server::Ready:
+            return;
+        case Server::Stopping:
+            server->restartPending = true;
+            return;
+        default:
+            break;
         }
-        if (s == "postgresql") {
-            logfiles << logs + "/postgresql.log";
+
+        if (isServerRunning(server->name)) {
+            setServerState(server, Server::Ready);
+            return;
         }
-        if (s == "redis") {
-            logfiles << logs + "/redis.log";
+
+        setServerState(server, Server::Starting);
+
+        runStartCommand(findDescriptor(server->name)->id);
+
+        // the probe has its own timeout and a better failure reason
+        if (!startReadinessProbe(server)) {
+            server->deadline.start(settings->get("servers/starttimeout", 15000).toInt());
         }
 
-        return logfiles;
+        // picks up the new processes right away
+        processMonitor->poll();
     }
 
-    QString Servers::getExecutable(QString &serverName) const
+    /**
+     * Stops a server: Ready -> Stopping -> Stopped (or Failed).
+     */
+    void Servers::stopServer(const QString &serverName)
     {
-        QString s = serverName.toLower();
-        QString exe;
-        if (s == "nginx") {
-            exe = "nginx.exe";
-        }
-        if (s == "memcached") {
-            exe = "memcached.exe";
-        }
-        if (s == "mongodb") {
-            exe = "mongod.exe";
-        }
-        if (s == "mariadb") {
-            exe = "mysqld.exe";
-        }
-        if (s == "php") {
-            exe = "php-cgi.exe";
-        }
-        if (s == "postgresql") {
-            exe = "pg_ctl.exe";
-        }
-        if (s == "redis") {
-            exe = "redis-server.exe";
+        Server *server = findServer(serverName);
+
+        if (!server) {
+            return;
         }
 
-        QDir path(settings->get("paths/" + serverName).toString() + "/");
+        if (!isServerRunning(server->name)) {
+            setServerState(server, Server::Stopped);
+            return;
+        }
 
-        QString filepath = path.absolutePath() + "/" + exe;
+        setServerState(server, Server::Stopping);
+        server->deadline.start(settings->get("servers/stoptimeout", 15000).toInt());
 
-        return QDir::toNativeSeparators(filepath);
-    }
+        runStopCommand(findDescriptor(server->name)->id);
 
-    QStringList Servers::getListOfServerNames() const
-    {
-        QStringList list;
-        list << "nginx"
-             << "php"
-             << "mariadb"
-             << "mongodb"
-             << "memcached"
-             << "postgresql"
-             << "redis";
-        return list;
+        // picks up the exits right away
+        processMonitor->poll();
     }
 
-    QStringList Servers::getListOfServerNamesInstalled()
+    /**
+     * Stops a server and starts it again, as soon as it is stopped.
+     */
+    void Servers::restartServer(const QString &serverName)
     {
-        qDebug() << "[Servers] Check, which servers are installed.";
+        Server *server = findServer(serverName);
 
-        QStringList list;
-        foreach (QString serverName, getListOfServerNames()) {
+        if (!server) {
+            return;
+        }
 
-            // these three servers are the base package.
-            // we assume that they are always installed.
-            // this is also for testing, because they appear installed, even if they are
-            // not.
-            if (serverName == "nginx" || serverName == "php" ||
-                serverName == "mariadb" || QFile().exists(getExecutable(serverName))) {
-                qDebug() << "Installed:\t" << serverName;
-                list << serverName;
-            } else {
-                qDebug() << "Not Installed:\t" << serverName;
-            }
+        // PHP config changes don't drop requests, while nginx uses the pools
+        if (findDescriptor(server->name)->id == ServerId::PHP && server->state == Server::Ready &&
+            isPHPPoolRunning() && isServerRunning("Nginx")) {
+            phpRestart->start();
+            return;
         }
-        return list;
-    }
 
-    QList<Server *> Servers::servers() const { return serverList; }
+        server->restartPending = true;
 
-    Server *Servers::getServer(const QString &serverName) const
-    {
-        foreach (Server *server, serverList) {
-            if (server->name == serverName)
-                return server;
-        }
+        stopServer(serverName);
 
-        // anti "control reaches end of non-void function" faked return
-        Server *server = new Server();
-        server->name = QString("Not Installed");
-        return server;
+        // already stopped, there will be no state change
+        if (server->restartPending && server->state != Server::Stopping) {
+            server->restartPending = false;
+            startServer(serverName);
+        }
     }
 
-    void Servers::clearLogFile(const QString &serverName) const
+    Server::State Servers::getServerState(const QString &serverName) const
     {
-        if (settings->get("global/clearlogsonstart").toBool()) {
+        Server *server = findServer(serverName);
+        return server ? server->state : Server::Stopped;
+    }
 
-            QString dirLogs = settings->get("paths/logs").toString();
-            QString logfile = "";
+    /**
+     * Returns true, if any process of the server is running.
+     */
+    bool Servers::isServerRunning(const QString &serverName) const
+    {
+        ProcessSnapshot snapshot = Processes::snapshot();
 
-            if (serverName == "Nginx") {
-                File::truncate(dirLogs + "/access.log");
-                File::truncate(dirLogs + "/error.log");
+        foreach (const QString &processName, getProcessNames(serverName)) {
+            if (snapshot.containsName(processName)) {
+                return true;
             }
+        }
 
-            if (serverName == "PHP") {
-                logfile = dirLogs + "/php_error.log";
-            }
-            if (serverName == "MariaDb") {
-                logfile = dirLogs + "/mariadb_error.log";
-            }
-            if (serverName == "MongoDb") {
-                logfile = dirLogs + "/mongodb.log";
-            }
-            if (serverName == "PostgreSQL") {
-                logfile = dirLogs + "/postgresql.log";
-            }
-            if (serverName == "Redis") {
-                logfile = dirLogs + "/redis.log";
-            }
+        return false;
+    }
 
-            File::truncate(logfile);
+    void Servers::setServerState(Server *server, Server::State state, const QString &reason)
+    {
+        if (state != Server::Starting && state != Server::Stopping) {
+            server->deadline.stop();
+        }
 
-            qDebug() << ("[" + serverName + "] Log was cleared.\n");
+        if (state != Server::Starting && server->probe) {
+            server->probe->cancel();
         }
-    }
 
-    // Server "Start - Stop - Restart" Methods
+        server->stateReason = reason;
 
-    /*
- * Nginx - Actions: run, stop, restart
- */
-    void Servers::startNginx()
-    {
-        // already running
-        if (processes->getProcessState(getServer("Nginx")->exe) ==
-            Processes::ProcessState::Running) {
-            QMessageBox::warning(0, tr("Nginx"), tr("Nginx already running."));
+        if (server->state == state) {
             return;
         }
 
-        clearLogFile("Nginx");
-        emit signalMainWindow_updateVersion("Nginx");
-        emit signalMainWindow_updatePort("Nginx");
+        server->state = state;
+
+        qDebug() << "[" + server->name + "]" << state << reason;
 
-        // http://wiki.nginx.org/CommandLine - start Nginx
-        QString program = getServer("Nginx")->exe;
+        emit serverStateChanged(server->name, state);
+
+        if (state == Server::Ready || state == Server::Stopped || state == Server::Failed) {
+            emit signalMainWindow_ServerStatusChange(server->name, state == Server::Ready);
+        }
 
-        QStringList arguments;
-        arguments << "-p " + QDir::currentPath();
-        arguments << "-c " + QDir::currentPath() + "/bin/nginx/conf/nginx.conf";
+        if (state == Server::Failed) {
+            server->restartPending = false;
+        }
 
-        qDebug() << "[Nginx] Starting...\n";
+        if (state == Server::Stopped && findDescriptor(server->name)->id == ServerId::PostgreSQL) {
+            cleanupPostgreSQL();
+        }
 
-        Processes::start(program, arguments, getServer("Nginx")->workingDirectory);
+        if (state == Server::Stopped && server->restartPending) {
+            server->restartPending = false;
+            startServer(server->name);
+        }
+    }
 
-        Processes::delay(250);
+    void Servers::deadlineExpired(Server *server)
+    {
+        int seconds = server->deadline.interval() / 1000;
 
-        Process p = Processes::findByName(program);
-        if(p.name != "process not found") {
-            emit signalMainWindow_ServerStatusChange("Nginx", true);
-        } else {
-            emit signalMainWindow_ServerStatusChange("Nginx", false);
+        if (server->state == Server::Starting) {
+            setServerState(server, Server::Failed, tr("%1 did not start within %2 seconds.").arg(server->name).arg(seconds));
+        } else if (server->state == Server::Stopping) {
+            setServerState(server, Server::Failed, tr("%1 is still running after %2 seconds.").arg(server->name).arg(seconds));
         }
     }
 
-    void Servers::stopNginx()
+    void Servers::processStarted(qint64 pid, const QString &exe)
     {
-        // if not running, skip
-        if (processes->getProcessState(getServer("Nginx")->exe) ==
-            Processes::ProcessState::NotRunning) {
-            qDebug() << "[Nginx] Not running... Skipping stop command.";
+        Server *server = findServerOfProcess(exe);
+
+        if (!server) {
             return;
         }
 
-        // http://wiki.nginx.org/CommandLine - stop nginx
-        const QString stopNginx = getServer("Nginx")->exe;
-
-        QStringList args;
-        args << "-p " + QDir::currentPath();
-        args << "-c " + QDir::currentPath() + "/bin/nginx/conf/nginx.conf";
-        args << "-s stop";
+        // a server started outside of the control panel
+        if (server->state == Server::Stopped || server->state == Server::Failed) {
+            // our own children are no server, e.g. the version probes ("nginx -v")
+            if (Processes::snapshot().findByPid(pid).ppid == QCoreApplication::applicationPid()) {
+                return;
+            }
 
-        qDebug() << "[Nginx] Stopping...\n";
+            setServerState(server, Server::Starting);
 
-        Processes::start(stopNginx, args, getServer("Nginx")->workingDirectory);
+            if (startReadinessProbe(server)) {
+                return;
+            }
+        }
 
-        emit signalMainWindow_ServerStatusChange("Nginx", false);
+        // servers without ports are ready, when their process runs
+        if (server->state == Server::Starting && !(server->probe && server->probe->isRunning())) {
+            setServerState(server, Server::Ready);
+        }
     }
 
-    void Servers::reloadNginx()
+    /**
+     * Probes the ports of the server, until it accepts connections.
+     * Returns false, if the server has no ports to probe.
+     */
+    bool Servers::startReadinessProbe(Server *server)
     {
-        QString const reloadNginx = getServer("Nginx")->exe;
+        QList<ProbeEndpoint> endpoints = getProbeEndpoints(server->name);
 
-        QStringList args;
-        args << "-p " + QDir::currentPath();
-        args << "-c " + QDir::currentPath() + "/bin/nginx/conf/nginx.conf";
-        args << "-s reload";
+        if (endpoints.isEmpty()) {
+            return false;
+        }
 
-        qDebug() << "[Nginx] Reloading...\n"
-                 << reloadNginx;
+        if (!server->probe) {
+            server->probe = new ReadinessProbe(server->name, this);
+            connect(server->probe, SIGNAL(ready(QString, qint64)), this, SLOT(probeReady(QString, qint64)));
+            connect(server->probe, SIGNAL(failed(QString, QString)), this, SLOT(probeFailed(QString, QString)));
+        }
 
-        Processes::startDetached(reloadNginx, args,
-                                 getServer("Nginx")->workingDirectory);
-    }
+        server->probe->setEndpoints(endpoints);
+        server->probe->setTimeout(settings->get("servers/starttimeout", 15000).toInt());
+        server->probe->start();
 
-    void Servers::restartNginx()
-    {
-        stopNginx();
-        startNginx();
+        return true;
     }
 
-    /*
- * PostgreSQL Actions: run, stop, restart
- */
-    void Servers::startPostgreSQL()
+    void Servers::probeReady(const QString &serverName, qint64 elapsedMs)
     {
-        // if not installed, skip
-        if (!QFile().exists(QDir::currentPath() + "/bin/pgsql/bin/pg_ctl.exe")) {
-            qDebug() << "Not found: " + QDir::currentPath() +
-                            "/bin/pgsql/bin/pg_ctl.exe";
-            qDebug() << "[PostgreSQL] Is not installed. Skipping start command.";
-            return;
-        }
+        Q_UNUSED(elapsedMs)
 
-        // already running
-        if (processes->getProcessState("postgres.exe") ==
-            Processes::ProcessState::Running) {
-            // if(QFile().exists(QDir::currentPath() +
-            // "/bin/pgsql/data/postmaster.pid")) {
-            QMessageBox::warning(0, tr("PostgreSQL"),
-                                 tr("PostgreSQL is already running."));
-            return;
+        Server *server = findServer(serverName);
+
+        if (server && server->state == Server::Starting) {
+            setServerState(server, Server::Ready);
         }
+    }
 
-        clearLogFile("PostgreSQL");
-        emit signalMainWindow_updateVersion("PostgreSQL");
-        emit signalMainWindow_updatePort("PostgreSQL");
+    void Servers::probeFailed(const QString &serverName, const QString &reason)
+    {
+        Server *server = findServer(serverName);
 
-        QString const startCmd = QDir::toNativeSeparators(
-            QDir::currentPath() + "/bin/pgsql/bin/pg_ctl.exe");
+        if (server && server->state == Server::Starting) {
+            setServerState(server, Server::Failed, reason);
+        }
+    }
 
-        QStringList args;
-        args << "--pgdata " +
-                    QDir::toNativeSeparators(QDir::currentPath() + "/bin/pgsql/data");
-        args << "--log " + QDir::toNativeSeparators(QDir::currentPath() +
-                                                    "/logs/postgresql.log");
-        args << "start";
+    /**
+     * A failed rolling restart leaves the PHP server running, with the old
+     * or the new pools. A cancelled one is part of stopping PHP.
+     */
+    void Servers::phpRestartFinished(bool success, const QString &reason)
+    {
+        Server *server = findServer("PHP");
 
-        qDebug() << "[PostgreSQL] Starting...\n"
-                 << startCmd;
+        if (success || !server || server->state != Server::Ready) {
+            return;
+        }
 
-        Processes::start(startCmd, args, getServer("PostgreSQL")->workingDirectory);
+        server->stateReason = tr("The restart failed: %1").arg(reason);
 
-        emit signalMainWindow_ServerStatusChange("PostgreSQL", true);
+        emit serverWarning(server->name, server->stateReason);
     }
 
-    void Servers::stopPostgreSQL()
+    /**
+     * The addresses, where the server accepts connections when it is ready.
+     *
+     * The ports are the ones shown in the status panel (see
+     * getPort()), PHP is probed on all local upstream pools.
+     * A "<server>/socket" setting probes a unix socket (or named pipe) instead.
+     * The Redis PING, memcached "version" and FastCGI pings can be disabled by
+     * "servers/protocolprobes".
+     */
+    QList<ProbeEndpoint> Servers::getProbeEndpoints(const QString &serverName)
     {
-        Server *server = getServer("PostgreSQL");
+        QString s = serverName.toLower();
+        bool protocolProbes = settings->get("servers/protocolprobes", true).toBool();
 
-        // if not installed, skip
-        if (!QFile().exists(server->exe)) {
-            qDebug() << "[PostgreSQL] Is not installed. Skipping stop command.";
-            return;
-        }
+        ProbeEndpoint endpoint;
+        endpoint.host = "127.0.0.1";
 
-        // if not running, skip
-        QString file = QDir::toNativeSeparators(QDir::currentPath() +
-                                                "/bin/pgsql/data/postmaster.pid");
-        if (processes->getProcessState("postgres.exe") ==
-            Processes::ProcessState::NotRunning) {
-            // if(!QFile().exists(file)) {
-            qDebug() << "[PostgreSQL] Not running.. Skipping stop command.";
-            server->trayMenu->setIcon(QIcon(":/status_stop"));
-            emit signalMainWindow_ServerStatusChange("postgresql", false);
-            return;
+        QList<ProbeEndpoint> endpoints;
+
+        if (s == "php") {
+            // a php-cgi worker answers, not only the listen socket of the pool
+            if (protocolProbes) {
+                endpoint.protocol = ProbeEndpoint::FastCgiGetValues;
+            }
+            foreach (const QString &port, getPHPServersFromNginxUpstreamConfig().keys()) {
+                endpoint.port = port.toUShort();
+                endpoints << endpoint;
+            }
+            return endpoints;
         }
 
-        QString stopCommand = QDir::toNativeSeparators(QDir::currentPath() +
-                                                       "/bin/pgsql/bin/pg_ctl.exe");
+        const ServerDescriptor *d = findDescriptor(s);
 
-        QStringList args;
-        args << "stop";
-        args << "--pgdata " +
-                    QDir::toNativeSeparators(QDir::currentPath() + "/bin/pgsql/data");
-        args << "--log " + QDir::toNativeSeparators(QDir::currentPath() +
-                                                    "/logs/postgresql.log");
-        args << "--mode=fast";
-        args << "-W";
+        if (!d || !d->portKey) {
+            return endpoints;
+        }
 
-        qDebug() << "[PostgreSQL] Stopping...";
+        endpoint.port = settings->get(d->portKey, d->defaultPort).toUInt();
 
-        Processes::start(stopCommand, args,
-                         getServer("PostgreSQL")->workingDirectory);
+        if (protocolProbes && d->id == ServerId::Memcached) {
+            endpoint.protocol = ProbeEndpoint::MemcachedVersion;
+        }
+        if (protocolProbes && d->id == ServerId::Redis) {
+            endpoint.protocol = ProbeEndpoint::RedisPing;
+        }
 
-        Processes::delay(
-            1250); // delay PID file check, PostgreSQL must shutdown first
+        endpoint.socketPath = settings->get(QString(d->key) + "/socket").toString();
 
-        // do we have a failed shutdown? if so, delete PID file, to allow a restart
-        if (QFile().exists(file)) {
-            qDebug() << "[PostgreSQL] PID file exists. Removing PID file to allow a "
-                        "restart.";
-            QFile().remove(file);
+        if (endpoint.port != 0 || !endpoint.socketPath.isEmpty()) {
+            endpoints << endpoint;
         }
 
-        // server->trayMenu->setIcon(QIcon(":/status_stop"));
-
-        emit signalMainWindow_ServerStatusChange("PostgreSQL", false);
+        return endpoints;
     }
 
-    void Servers::restartPostgreSQL()
+    void Servers::processExited(qint64 pid, int exitCode)
     {
-        stopPostgreSQL();
-        startPostgreSQL();
-    }
+        Server *server = findServerOfProcess(processMonitor->exeOf(pid));
 
-    /*
- * PHP - Actions: run, stop, restart
- */
-    void Servers::startPHP()
-    {
-        // already running
-        if (processes->getProcessState("php-cgi.exe") ==
-                Processes::ProcessState::Running ||
-            processes->getProcessState("spawn.exe") ==
-                Processes::ProcessState::Running) {
-            QMessageBox::warning(0, tr("PHP"), tr("PHP is already running."));
+        if (!server) {
             return;
         }
 
-        clearLogFile("PHP");
-        emit signalMainWindow_updateVersion("PHP");
-        // emit signalMainWindow_updatePort("PHP");
-
-        // disable PHP_FCGI_MAX_REQUESTS to go beyond the default request limit of 500
-        // requests
-        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-        env.insert("PHP_FCGI_MAX_REQUESTS", "0");
-        qDebug() << "[PHP] Set PHP_FCGI_MAX_REQUESTS \"0\" (disabled).";
-
-        // get the PHP version
-        QProcess process;
-        process.start("./bin/php/php.exe -r \"echo PHP_VERSION_ID;\"");
-        process.waitForFinished();
-        int phpVersion = process.readAllStandardOutput().toInt();
-        qDebug() << "[PHP] Version " << phpVersion;
-
-        // check that the tool "php-cgi-spawner" is present
-        QString spawnUtilFile =
-            QDir::toNativeSeparators(QDir::currentPath() + "/bin/tools/spawn.exe");
-        if (!QFile().exists(spawnUtilFile)) {
-            qDebug() << "[PHP] Starting PHP failed. Tool \"spawn.exe\" missing.";
+        // the pool replaces an exited worker
+        if (findDescriptor(server->name)->id == ServerId::PHP && isPHPPoolRunning()) {
             return;
         }
 
-        // if PHP version below 7.1, use "spawn.exe" to spawn multiple processes
-        QString startCmdWithPlaceholders(spawnUtilFile +
-                                         " ./bin/php/php-cgi.exe %1 %2");
-
-        // get the nginx upstream configuration and read the defined PHP pools
-        QMapIterator<QString, QString> PHPServersToStart(
-            getPHPServersFromNginxUpstreamConfig());
-
-        while (PHPServersToStart.hasNext()) {
-            PHPServersToStart.next();
-            QString port = PHPServersToStart.key();
-            QString phpchildren = PHPServersToStart.value();
+        // a server might run several processes (php-cgi pool, nginx workers)
+        foreach (const QString &processName, getProcessNames(server->name)) {
+            if (processMonitor->isRunning(processName)) {
+                return;
+            }
+        }
 
-            // if PHP version 7.1+, then use env var PHP_FCGI_CHILDREN to allow PHP
-            // spawning childs
-            if (phpVersion >= 71000) {
-                env.insert("PHP_FCGI_CHILDREN", phpchildren);
-                qDebug() << "[PHP] Set PHP_FCGI_CHILDREN " << phpchildren;
+        if (server->state == Server::Stopping || server->state == Server::Stopped) {
+            setServerState(server, Server::Stopped);
+        } else {
+            setServerState(server, Server::Failed, tr("%1 exited with code %2.").arg(server->name).arg(exitCode));
+        }
+    }
 
-                startCmdWithPlaceholders.clear();
-                startCmdWithPlaceholders.append(QDir::currentPath() +
-                                                "/bin/php/php-cgi.exe");
-            }
+    /**
+ * @brief Servers::getCamelCasedServerName
+ * translates lowercase server and process names to internally used camel-cased
+ * label names
+ * @param serverName
+ * @return
+ */
+    QString Servers::getCamelCasedServerName(QString &serverName) const
+    {
+        const ServerDescriptor *d = findDescriptor(serverName);
+        return d ? QString(d->name) : QString("Unknown");
+    }
 
-            QString startPHPCGI =
-                QString(startCmdWithPlaceholders).arg(port, phpchildren);
+    QStringList Servers::getLogFiles(QString &serverName) const
+    {
+        const ServerDescriptor *d = findDescriptor(serverName);
+        QString logs = QDir(settings->get("paths/logs").toString()).absolutePath();
 
-            qDebug() << "[PHP] Starting...\n"
-                     << startPHPCGI;
+        QStringList logfiles;
 
-            QProcess *process = new QProcess;
-            process->setEnvironment(env.toStringList());
-            process->startDetached(startPHPCGI);
-            qDebug() << "[PHP] Process PID" << process->pid();
+        if (d) {
+            foreach (const QString &file, splitList(d->logFiles)) {
+                logfiles << logs + "/" + file;
+            }
         }
 
-        emit signalMainWindow_ServerStatusChange("PHP", true);
+        return logfiles;
     }
 
-    QMap<QString, QString> Servers::getPHPServersFromNginxUpstreamConfig()
+    QString Servers::getExecutable(QString &serverName) const
     {
-        QMap<QString, QString> serversToStart;
+        const ServerDescriptor *d = findDescriptor(serverName);
+        QString exe = d ? d->exe : "";
 
-        QFile upstreamConfigFile = "./bin/wpnxm-scp/nginx-upstreams.json";
-        if (!upstreamConfigFile.exists()) {
-            qDebug() << "[PHP] Nginx Upstream Configuration file not found.\n";
-        }
+        QDir path(settings->get("paths/" + serverName).toString() + "/");
 
-        // load JSON
-        QJsonDocument jsonDoc =
-            File::JSON::load("./bin/wpnxm-scp/nginx-upstreams.json");
-        QJsonObject json = jsonDoc.object();
-        QJsonObject jsonPools = json["pools"].toObject();
+        QString filepath = path.absolutePath() + "/" + exe;
 
-        // iterate over 1..n pools
-        for (QJsonObject::Iterator iter = jsonPools.begin(); iter != jsonPools.end();
-             ++iter) {
-            // get values for a "pool", we need the key "servers"
-            QJsonObject jsonPool = iter.value().toObject();
-            QJsonObject jsonServers = jsonPool["servers"].toObject();
+        return QDir::toNativeSeparators(filepath);
+    }
 
-            // iterate over 1..n jsonServers
-            for (int i = 0; i < jsonServers.count(); ++i) {
-                // get values for a "server"
-                QJsonObject s = jsonServers.value(QString::number(i)).toObject();
+    QStringList Servers::getListOfServerNames() const
+    {
+        QStringList list;
+        for (const ServerDescriptor &d : serverDescriptors) {
+            list << d.key;
+        }
+        return list;
+    }
 
-                // we want to start local servers only.
-                // external servers are possible, but the user has to start (and take
-                // care) of them.
-                if ((s["address"].toString() == "localhost") ||
-                    (s["address"].toString() == "127.0.0.1")) {
+    QStringList Servers::getListOfServerNamesInstalled()
+    {
+        qDebug() << "[Servers] Check, which servers are installed.";
 
-                    // for starting local servers, we only need the Port and the number of
-                    // PHP child processes to spawn
-                    serversToStart.insert(s["port"].toString(),
-                                          s["phpchildren"].toString());
+        QStringList list;
+        for (const ServerDescriptor &d : serverDescriptors) {
+            QString serverName = d.key;
+
+            // the servers of the base package are assumed to be always installed.
+            // this is also for testing, because they appear installed, even if they are
+            // not.
+            if (d.baseInstall || QFile().exists(getExecutable(serverName))) {
+                qDebug() << "Installed:\t" << serverName;
+                list << serverName;
+            } else {
+                qDebug() << "Not Installed:\t" << serverName;
+            }
+        }
+        return list;
+    }
+
+    QList<Server *> Servers::servers() const { return serverList; }
+
+    /**
+     * The executable names of the processes a server consists of.
+     */
+    QStringList Servers::getProcessNames(const QString &serverName) const
+    {
+        const ServerDescriptor *d = findDescriptor(serverName);
+        return d ? splitList(d->processNames) : QStringList();
+    }
+
+    /**
+     * The port shown in the status panel.
+     */
+    QString Servers::getPort(const QString &serverName) const
+    {
+        const ServerDescriptor *d = findDescriptor(serverName);
+
+        if (!d) {
+            return ":(";
+        }
+        if (d->id == ServerId::PHP) {
+            return "Pool";
+        }
+        return settings->get(d->portKey, d->defaultPort).toString();
+    }
+
+    /**
+     * Expands a command template of the descriptor, see ServerDescriptor.
+     */
+    QString Servers::expandCommand(const ServerDescriptor &d, const char *command) const
+    {
+        QString result = QString::fromLatin1(command);
+        QRegExp placeholder("\\$\\{([^}]+)\\}");
+
+        int pos = 0;
+        while ((pos = placeholder.indexIn(result, pos)) != -1) {
+            QString name = placeholder.cap(1);
+            QString value;
+
+            if (name == "root") {
+                value = QDir::currentPath();
+            } else if (name == "exe") {
+                value = findServer(d.name) ? findServer(d.name)->exe : QString();
+            } else {
+                // "group/key" or "group/key=default"
+                QString defaultValue = name.section('=', 1);
+                value = settings->get(name.section('=', 0, 0), defaultValue).toString();
+            }
+
+            result.replace(pos, placeholder.matchedLength(), value);
+            pos += value.length();
+        }
+
+        return result;
+    }
+
+    /**
+     * Sums the resource usage of all processes of a server.
+     *
+     * A server is a process tree (nginx master and workers, spawner and
+     * php-cgi pool, postgres and its backends): the processes with the
+     * server's executable names and all of their descendants are counted,
+     * each process once.
+     * CPU, memory and threads are taken from the resource sampler, processes
+     * without a sample yet count with their RSS.
+     */
+    ServerUsage Servers::getServerUsage(const QString &serverName, const ProcessSnapshot &snapshot,
+                                        const PortTable &portTable) const
+    {
+        QList<qint64> pids;
+        QSet<qint64> seen;
+
+        foreach (const QString &name, getProcessNames(serverName)) {
+            foreach (const Process &p, snapshot.findAllByName(name)) {
+                if (seen.contains(p.pid)) {
+                    continue;
+                }
+                seen.insert(p.pid);
+                pids << p.pid;
+
+                foreach (const Process &child, snapshot.descendants(p.pid)) {
+                    if (!seen.contains(child.pid)) {
+                        seen.insert(child.pid);
+                        pids << child.pid;
+                    }
                 }
             }
         }
 
-        if (serversToStart.count() == 0) {
-            qDebug() << "[PHP] Found no servers to start. Check your upstream "
-                        "configuration.";
-            qDebug() << "[PHP] At least one address must be localhost or 127.0.0.1.";
+        ServerUsage usage;
+        usage.processCount = pids.size();
+
+        // workers share the listening socket of their master, count ports once
+        QSet<quint16> ports;
+
+        foreach (qint64 pid, pids) {
+            ResourceSample sample = resourceSampler->latest(pid);
+
+            if (sample.isValid()) {
+                usage.cpuPercent += sample.cpuPercent;
+                usage.memoryBytes += sample.pssBytes ? sample.pssBytes : sample.rssBytes;
+                usage.threadCount += sample.threadCount;
+            } else {
+                usage.memoryBytes += snapshot.findByPid(pid).rssBytes;
+            }
+
+            foreach (quint16 port, portTable.listeningPorts(pid)) {
+                ports.insert(port);
+            }
         }
 
-        return serversToStart;
+        usage.listeningPorts = ports.toList();
+        std::sort(usage.listeningPorts.begin(), usage.listeningPorts.end());
+
+        return usage;
     }
 
-    void Servers::stopPHP()
+    /**
+     * The resource usage of all installed servers, from one snapshot.
+     * The ports are those of the last coarse sample of the resource sampler,
+     * the port table is never taken on the GUI thread.
+     */
+    QMap<QString, ServerUsage> Servers::getServersUsage() const
     {
-        // if not installed, skip
-        if (!QFile().exists(getServer("PHP")->exe)) {
-            qDebug() << "[PHP] Is not installed. Skipping stop command.";
-            return;
+        ProcessSnapshot snapshot = Processes::snapshot();
+        PortTable portTable = resourceSampler->portTable();
+
+        QMap<QString, ServerUsage> usages;
+        foreach (Server *server, serverList) {
+            usages.insert(server->name, getServerUsage(server->name, snapshot, portTable));
         }
 
-        // if not running, skip
-        if (processes->getProcessState(getServer("PHP")->exe) ==
-            Processes::ProcessState::NotRunning) {
-            qDebug() << "[PHP] Not running... Skipping stop command.";
-            return;
+        return usages;
+    }
+
+    QString ServerUsage::toString() const
+    {
+        if (processCount == 0) {
+            return QObject::tr("Not running");
         }
 
-        qDebug() << "[PHP] Stopping...";
+        QStringList parts;
+        parts << QObject::tr("%1 processes").arg(processCount);
+        parts << QObject::tr("CPU %1%").arg(cpuPercent, 0, 'f', 1);
+        parts << QObject::tr("memory %1").arg(ProcessSnapshot::formatBytes(memoryBytes));
 
-        /**
-   * There is only one way stop the PHP server:
-   * By terminating the process. That means we are crashing it!
-   *
-   * WARNING!
-   *
-   * The order is important.
-   * The spawner needs to be killed before we are trying to kill PHP childs.
-   *
-   */
+        // not available on Windows
+        if (threadCount > 0) {
+            parts << QObject::tr("%1 threads").arg(threadCount);
+        }
+
+        if (!listeningPorts.isEmpty()) {
+            QStringList portList;
+            foreach (quint16 port, listeningPorts) {
+                portList << QString::number(port);
+            }
+            parts << QObject::tr("ports %1").arg(portList.join(", "));
+        }
 
-        while (processes->getProcessState("spawn.exe") == Processes::ProcessState::Running) {
-            processes->killProcessTree("spawn.exe");
-            processes->delay(100);
+        return parts.join(", ");
+    }
+
+    /**
+     * Returns the installed server or 0.
+     */
+    Server *Servers::findServer(const QString &serverName) const
+    {
+        foreach (Server *server, serverList) {
+            if (server->name == serverName) {
+                return server;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Returns the installed server, the process belongs to, or 0.
+     */
+    Server *Servers::findServerOfProcess(const QString &processName) const
+    {
+        QString name = ProcessSnapshot::normalizeName(processName);
+
+        foreach (Server *server, serverList) {
+            if (getProcessNames(server->name).contains(name)) {
+                return server;
+            }
         }
+        return 0;
+    }
 
-        while (processes->getProcessState("php-cgi.exe") == Processes::ProcessState::Running) {
-            processes->killProcessTree("php-cgi.exe");
-            processes->delay(100);
+    Server *Servers::getServer(const QString &serverName) const
+    {
+        foreach (Server *server, serverList) {
+            if (server->name == serverName)
+                return server;
         }
 
-        emit signalMainWindow_ServerStatusChange("PHP", false);
+        // anti "control reaches end of non-void function" faked return
+        Server *server = new Server();
+        server->name = QString("Not Installed");
+        return server;
     }
 
-    void Servers::restartPHP()
+    /**
+     * Rotates the logs of a server, before it is started.
+     * The history is kept: the logs are compressed in the background.
+     */
+    void Servers::rotateLogFiles(const QString &serverName)
     {
-        stopPHP();
-        startPHP();
+        if (settings->get("global/clearlogsonstart").toBool()) {
+            logRotator->rotate(serverName, isServerRunning(serverName));
+        }
     }
 
-    /*
- * MariaDb Actions - run, stop, restart
- */
-    void Servers::startMariaDb()
+    // Server "Start - Stop - Restart" Methods
+
+    /**
+     * Runs the start command of a server and returns immediately.
+     * Used by startServer(), which tracks the state, and by the CLI.
+     */
+    void Servers::runStartCommand(ServerId id)
     {
+        const ServerDescriptor &d = descriptor(id);
+        Server *server = findServer(d.name);
+
+        // if not installed, skip
+        if (!server || !QFile().exists(server->exe)) {
+            qDebug() << "[" + QString(d.name) + "] Is not installed. Skipping start command.";
+            return;
+        }
+
         // if already running, skip
-        if (processes->getProcessState(getServer("MariaDb")->exe) ==
-            Processes::ProcessState::Running) {
-            QMessageBox::warning(0, tr("MariaDB"), tr("MariaDB already running."));
+        if (isServerRunning(d.name)) {
+            qDebug() << "[" + QString(d.name) + "] Already running. Skipping start command.";
             return;
         }
 
-        clearLogFile("MariaDb");
-        emit signalMainWindow_updateVersion("MariaDb");
-        emit signalMainWindow_updatePort("MariaDb");
+        if (id == ServerId::MongoDb) {
+            prepareMongoDb();
+        }
+
+        rotateLogFiles(d.name);
+        emit signalMainWindow_updateVersion(d.name);
+        emit signalMainWindow_updatePort(d.name);
 
-        QString const startMariaDb = getServer("MariaDb")->exe;
+        if (id == ServerId::PHP) {
+            startPHP();
+            return;
+        }
 
         QStringList args;
-        args << "--defaults-file=" + QDir::toNativeSeparators(QDir::currentPath() +
-                                                              "/bin/mariadb/my.ini");
-        args << "--standalone"; // important! else maria is started as service and
-        // won't detach
+        args << expandCommand(d, d.startArguments);
 
-        qDebug() << "[MariaDB] Starting...\n";
+        qDebug() << "[" + QString(d.name) + "] Starting...\n" << server->exe << args;
 
-        Processes::startDetached(startMariaDb, args,
-                                 getServer("MariaDb")->workingDirectory);
-
-        emit signalMainWindow_ServerStatusChange("MariaDb", true);
+        if (d.detached) {
+            Processes::startDetached(server->exe, args, server->workingDirectory);
+        } else {
+            Processes::start(server->exe, args, server->workingDirectory);
+        }
     }
 
-    void Servers::stopMariaDb()
+    /**
+     * Runs the stop command of a server or kills its processes.
+     */
+    void Servers::runStopCommand(ServerId id)
     {
+        const ServerDescriptor &d = descriptor(id);
+        Server *server = findServer(d.name);
+
         // if not installed, skip
-        if (!QFile().exists(getServer("MariaDb")->exe)) {
-            qDebug() << "[MariaDb] Is not installed. Skipping stop command.";
+        if (!server || !QFile().exists(server->exe)) {
+            qDebug() << "[" + QString(d.name) + "] Is not installed. Skipping stop command.";
             return;
         }
 
         // if not running, skip
-        if (processes->getProcessState(getServer("MariaDb")->exe) ==
-            Processes::ProcessState::NotRunning) {
-            qDebug() << "[MariaDb] Not running... Skipping stop command.";
+        if (!isServerRunning(d.name)) {
+            qDebug() << "[" + QString(d.name) + "] Not running... Skipping stop command.";
             return;
         }
 
-        QString stopCommand = QDir::toNativeSeparators(
-            QDir::currentPath() + "/bin/mariadb/bin/mysqladmin.exe");
+        qDebug() << "[" + QString(d.name) + "] Stopping...";
 
-        QStringList args;
-        // args << "--defaults-file=" + QDir::toNativeSeparators(QDir::currentPath() +
-        // "/bin/mariadb/my.ini");
-        // args << "-u root -h 127.0.0.1 --protocol=tcp";
-        args << "-u root shutdown";
+        if (id == ServerId::PHP) {
+            stopPHP();
+            return;
+        }
 
-        qDebug() << "[MariaDB] Stopping...";
+        // the processes, which have to exit
+        QList<qint64> pids;
+        foreach (const QString &processName, splitList(d.processNames)) {
+            foreach (const Process &p, Processes::snapshot().findAllByName(processName)) {
+                pids << p.pid;
+            }
+        }
+
+        // the exits are reported by the ProcessMonitor, see processExited()
+        if (!d.stopProgram) {
+            foreach (qint64 pid, pids) {
+                Processes::signalProcess(pid, true);
+            }
+            Processes::invalidateSnapshot();
+            return;
+        }
 
-        Processes::start(stopCommand, args, getServer("MongoDb")->workingDirectory);
+        QStringList args;
+        args << expandCommand(d, d.stopArguments);
 
-        emit signalMainWindow_ServerStatusChange("MariaDb", false);
+        Processes::start(expandCommand(d, d.stopProgram), args, server->workingDirectory);
     }
 
-    void Servers::restartMariaDb()
+    void Servers::reloadNginx() { signalNginx("reload"); }
+
+    /**
+     * The logs of the server were renamed by the log rotation.
+     */
+    void Servers::reopenLogs(const QString &serverName)
     {
-        stopMariaDb();
-        startMariaDb();
+        if (findDescriptor(serverName)->id == ServerId::Nginx && isServerRunning("Nginx")) {
+            signalNginx("reopen");
+        }
     }
 
-    /*
- * MongoDb Actions - start, stop, restart
- */
-    void Servers::startMongoDb()
+    void Servers::signalNginx(const QString &signal)
     {
-        // if not installed, skip
-        if (!QFile().exists(getServer("MongoDb")->exe)) {
-            qDebug() << "[MongoDb] Is not installed. Skipping start command.";
-            return;
-        }
+        QString const nginx = getServer("Nginx")->exe;
 
-        // if already running, skip
-        if (processes->getProcessState(getServer("MongoDb")->exe) ==
-            Processes::ProcessState::Running) {
-            QMessageBox::warning(0, tr("MongoDb"), tr("MongoDb already running."));
-            return;
-        }
+        QStringList args;
+        args << "-p " + QDir::currentPath();
+        args << "-c " + QDir::currentPath() + "/bin/nginx/conf/nginx.conf";
+        args << "-s " + signal;
+
+        qDebug() << "[Nginx] Signal" << signal << "...\n"
+                 << nginx;
+
+        Processes::startDetached(nginx, args,
+                                 getServer("Nginx")->workingDirectory);
+    }
 
-        // MongoDb doesn't start, when data dir is missing...
+    /**
+     * MongoDb doesn't start, when the data dir or the logfile is missing.
+     */
+    void Servers::prepareMongoDb()
+    {
         QString const mongoDbDataDir = QDir::currentPath() + "/bin/mongodb/data/db";
         if (QDir().exists(QDir::currentPath() + "/bin/mongodb") &&
             !QDir().exists(mongoDbDataDir)) {
@@ -706,224 +968,313 @@ namespace Servers
             QDir().mkpath(mongoDbDataDir);
         }
 
-        // MongoDb doesn't start, when logfile is missing...
         QFile f(QDir::currentPath() + "/logs/mongodb.log");
         if (!f.exists()) {
             qDebug() << "[MongoDb] Creating empty logfile...\n"
                      << QDir::currentPath() + "/logs/mongodb.log";
             f.open(QIODevice::ReadWrite);
             f.close();
-        } else {
-            clearLogFile("MongoDb");
         }
-
-        emit signalMainWindow_updateVersion("MongoDb");
-        emit signalMainWindow_updatePort("MongoDb");
-
-        // build mongo start command
-        QString const mongoStartCommand = getServer("MongoDb")->exe;
-
-        QStringList args;
-        args << "--config " + QDir::currentPath() + "/bin/mongodb/mongodb.conf";
-        args << "--dbpath " + QDir::currentPath() + "/bin/mongodb/data/db";
-        args << "--logpath " + QDir::currentPath() + "/logs/mongodb.log";
-        args << "--storageEngine=" +
-                    settings->get("mongodb/storageengine", "wiredTiger").toString();
-        args << "--journal --httpinterface --rest";
-
-        qDebug() << "[MongoDb] Starting...\n";
-
-        Processes::startDetached(mongoStartCommand, args,
-                                 getServer("MongoDb")->workingDirectory);
-
-        emit signalMainWindow_ServerStatusChange("MongoDb", true);
     }
 
-    void Servers::stopMongoDb()
+    /**
+     * The PostgreSQL process monitoring works via a PID file.
+     * A failed shutdown leaves the PID file behind, which prevents a restart.
+     * Called, when PostgreSQL has stopped.
+     */
+    void Servers::cleanupPostgreSQL()
     {
-        // if not installed, skip
-        if (!QFile().exists(getServer("MongoDb")->exe)) {
-            qDebug() << "[MongoDb] Is not installed. Skipping stop command.";
+        if (isServerRunning("PostgreSQL")) {
             return;
         }
 
-        // if not running, skip
-        if (processes->getProcessState(getServer("MongoDb")->exe) ==
-            Processes::ProcessState::NotRunning) {
-            qDebug() << "[MongoDb] Not running... Skipping stop command.";
+        QString file = QDir::toNativeSeparators(QDir::currentPath() +
+                                                "/bin/pgsql/data/postmaster.pid");
+        if (QFile().exists(file)) {
+            qDebug() << "[PostgreSQL] PID file exists. Removing PID file to allow a "
+                        "restart.";
+            QFile().remove(file);
+        }
+    }
+
+    /*
+ * PHP - the pools of the nginx upstream configuration
+ */
+    void Servers::startPHP()
+    {
+        QString php("php");
+        QString program = getExecutable(php);
+
+        if (!QFile().exists(program)) {
+            qDebug() << "[PHP] Starting PHP failed. php-cgi missing:" << program;
             return;
         }
 
-        /**
-   * build mongo stop command based on CLI evaluation
-   * mongodb is stopped via "mongo.exe --eval", not "mongodb.exe"
-   */
+        // get the nginx upstream configuration and read the defined PHP pools
+        QMapIterator<QString, QString> PHPServersToStart(getPHPServersFromNginxUpstreamConfig());
 
-        QString const mongoStopCommand =
-            QDir::currentPath() + "/bin/mongodb/bin/mongo.exe";
+        while (PHPServersToStart.hasNext()) {
+            PHPServersToStart.next();
 
-        QStringList args;
-        args << "--eval \"db.getSiblingDB('admin').shutdownServer()\"";
+            FastCgiPoolConfig config;
+            config.address = "127.0.0.1";
+            config.port = PHPServersToStart.key().toUShort();
+            config.program = program;
+
+            // "phpchildren" is a fixed number of workers or a range "min-max" (adaptive)
+            QStringList children = PHPServersToStart.value().split('-');
+            config.workers = qMax(children.first().trimmed().toInt(), 1);
+            if (children.size() == 2) {
+                config.minWorkers = config.workers;
+                config.maxWorkers = children.last().trimmed().toInt();
+                config.scaleInterval = settings->get("php/scaleinterval", 1000).toInt();
+                config.scaleDownDelay = settings->get("php/scaledowndelay", 10000).toInt();
+            }
+
+            config.backlog = settings->get("php/backlog", 128).toInt();
+            // 0 goes beyond the default request limit of 500 requests
+            config.maxRequests = settings->get("php/maxrequests", 0).toInt();
+            config.maxMemoryBytes = settings->get("php/maxmemory", 0).toULongLong() * 1024 * 1024;
+            config.stopTimeout = settings->get("php/stoptimeout", 3000).toInt();
 
-        qDebug() << "[MongoDb] Stopping...\n";
+            FastCgiPool *pool = new FastCgiPool(config, processMonitor, this);
 
-        Processes::start(mongoStopCommand, args,
-                         getServer("MongoDb")->workingDirectory);
+            QString error;
+            if (!pool->start(&error)) {
+                delete pool;
+                continue;
+            }
 
-        emit signalMainWindow_ServerStatusChange("MongoDb", false);
+            phpPools << pool;
+        }
     }
 
-    void Servers::restartMongoDb()
+    QList<FastCgiPool *> Servers::getPHPPools() const { return phpPools; }
+
+    void Servers::replacePHPPool(FastCgiPool *oldPool, FastCgiPool *newPool)
     {
-        stopMongoDb();
-        startMongoDb();
+        int i = phpPools.indexOf(oldPool);
+        if (i >= 0) {
+            phpPools.replace(i, newPool);
+        }
     }
 
-    /*
- * Memcached Actions - run, stop, restart
- */
-    void Servers::startMemcached()
+    /**
+     * True, if a pool manages the PHP workers. The pools respawn exited workers.
+     */
+    bool Servers::isPHPPoolRunning() const
     {
+        foreach (FastCgiPool *pool, phpPools) {
+            if (pool->isRunning()) {
+                return true;
+            }
+        }
+        return false;
+    }
 
-        // https://github.com/memcached/memcached/wiki/ConfiguringServer#commandline-arguments
+    /**
+     * Writes the nginx upstream definitions ("bin/nginx/conf/upstreams/<pool>.conf")
+     * of the upstream configuration. Used by the configuration dialog and by
+     * the rolling PHP restart, which points the upstreams to the new pools.
+     */
+    void Servers::writeNginxUpstreamConfigs(const QJsonDocument &jsonDoc)
+    {
+        createNginxConfUpstreamFolderIfNotExists_And_clearOldConfigs();
 
-        QString const memcachedStartCommand = getServer("Memcached")->exe;
+        // build servers string by iterating over all pools
 
-        QStringList args;
-        args << "-p " + settings->get("memcached/tcpport").toString();
-        args << " -U " + settings->get("memcached/udpport").toString();
-        args << " -t " + settings->get("memcached/threads").toString();
-        args << " -c " + settings->get("memcached/maxconnections").toString();
-        args << " -m " + settings->get("memcached/maxmemory").toString();
+        QJsonObject json = jsonDoc.object();
+        QJsonObject jsonPools = json["pools"].toObject();
 
-        // if not installed, skip
-        if (!QFile().exists(getServer("Memcached")->exe)) {
-            qDebug() << "[Memcached] Is not installed. Skipping start command.";
-            return;
-        }
+        // iterate over 1..n pools (key)
+        for (QJsonObject::Iterator iter = jsonPools.begin(); iter != jsonPools.end();
+             ++iter) {
+            // the "value" object has the key/value pairs of a pool
+            QJsonObject jsonPool = iter.value().toObject();
 
-        // if already running, skip
-        if (processes->getProcessState(getServer("Memcached")->exe) ==
-            Processes::ProcessState::Running) {
-            QMessageBox::warning(0, tr("Memcached"), tr("Memcached already running."));
-            return;
-        }
+            QString poolName = jsonPool["name"].toString();
+            QString method = jsonPool["method"].toString();
+            QJsonObject jsonServers = jsonPool["servers"].toObject();
 
-        emit signalMainWindow_updateVersion("Memcached");
-        emit signalMainWindow_updatePort("Memcached");
+            // build "servers" block for later insertion into the upstream template
+            // string
+            QString servers;
 
-        qDebug() << "[Memcached] Starting...\n";
+            // iterate over all servers
+            for (int i = 0; i < jsonServers.count(); ++i) {
+                // get values for this server
+                QJsonObject s = jsonServers.value(QString::number(i)).toObject();
 
-        Processes::startDetached(memcachedStartCommand, args,
-                                 getServer("Memcached")->workingDirectory);
+                // use values to build server string
+                QString server =
+                    QString("    server %1:%2 weight=%3 max_fails=%4 fail_timeout=%5;\n")
+                        .arg(s["address"].toString(), s["port"].toString(),
+                             s["weight"].toString(), s["maxfails"].toString(),
+                             s["failtimeout"].toString());
 
-        emit signalMainWindow_ServerStatusChange("Memcached", true);
-    }
+                servers.append(server);
+            }
 
-    void Servers::stopMemcached()
-    {
-        // if not installed, skip
-        if (!QFile().exists(getServer("Memcached")->exe)) {
-            qDebug() << "[Memcached] Is not installed. Skipping stop command.";
-            return;
-        }
+            // upstream template string
+            QString upstream(
+                "#\n"
+                "# Automatically generated Nginx Upstream definition.\n"
+                "# Do not edit manually!\n"
+                "\n"
+                "upstream " +
+                poolName +
+                " {\n"
+                "    " +
+                method +
+                ";\n"
+                "\n" +
+                servers + "}\n");
+
+            QString filename("./bin/nginx/conf/upstreams/" + poolName + ".conf");
+
+            QFile file(filename);
+            if (file.open(QIODevice::ReadWrite | QFile::Truncate)) {
+                QTextStream stream(&file);
+                stream << upstream << endl;
+            }
+            file.close();
 
-        // if not running, skip
-        if (processes->getProcessState(getServer("Memcached")->exe) ==
-            Processes::ProcessState::NotRunning) {
-            qDebug() << "[Memcached] Not running... Skipping stop command.";
-            return;
+            qDebug() << "[Nginx Upstream Config] Saved: " << filename;
         }
+    }
 
-        // Memcached is a fucked up application.
-        // It doesn't provide a shutdown command.
-        // And needs to be process killed...
-
-        qDebug() << "[Memcached] Stopping...\n";
+    void Servers::createNginxConfUpstreamFolderIfNotExists_And_clearOldConfigs()
+    {
+        QDir dir("./bin/nginx/conf/upstreams");
 
-        Processes::killProcess("memcached");
+        // create Nginx Conf Upstream Folder If Not Exists
+        if (!dir.exists()) {
+            dir.mkpath(".");
+        }
 
-        emit signalMainWindow_ServerStatusChange("Memcached", false);
+        // delete old upstream configs
+        dir.setNameFilters(QStringList() << "*.conf");
+        dir.setFilter(QDir::Files);
+        foreach (QString dirFile, dir.entryList()) {
+            dir.remove(dirFile);
+        }
     }
 
-    void Servers::restartMemcached()
+    QMap<QString, QString> Servers::getPHPServersFromNginxUpstreamConfig()
     {
-        stopMemcached();
-        startMemcached();
-    }
+        QMap<QString, QString> serversToStart;
 
-    void Servers::startRedis()
-    {
-        QString const redisStartCommand = getServer("Redis")->exe;
+        QFile upstreamConfigFile = "./bin/wpnxm-scp/nginx-upstreams.json";
+        if (!upstreamConfigFile.exists()) {
+            qDebug() << "[PHP] Nginx Upstream Configuration file not found.\n";
+        }
 
-        QStringList args;
-        args << "redis.windows.conf";
+        // load JSON
+        QJsonDocument jsonDoc =
+            File::JSON::load("./bin/wpnxm-scp/nginx-upstreams.json");
+        QJsonObject json = jsonDoc.object();
+        QJsonObject jsonPools = json["pools"].toObject();
 
-        // if not installed, skip
-        if (!QFile().exists(getServer("Redis")->exe)) {
-            qDebug() << "[Redis] Is not installed. Skipping start command.";
-            return;
-        }
+        // iterate over 1..n pools
+        for (QJsonObject::Iterator iter = jsonPools.begin(); iter != jsonPools.end();
+             ++iter) {
+            // get values for a "pool", we need the key "servers"
+            QJsonObject jsonPool = iter.value().toObject();
+            QJsonObject jsonServers = jsonPool["servers"].toObject();
 
-        // if already running, skip
-        if (processes->getProcessState(getServer("Redis")->exe) ==
-            Processes::ProcessState::Running) {
-            QMessageBox::warning(0, tr("Redis"), tr("Redis already running."));
-            return;
-        }
+            // iterate over 1..n jsonServers
+            for (int i = 0; i < jsonServers.count(); ++i) {
+                // get values for a "server"
+                QJsonObject s = jsonServers.value(QString::number(i)).toObject();
 
-        clearLogFile("Redis");
-        emit signalMainWindow_updateVersion("Redis");
-        emit signalMainWindow_updatePort("Redis");
+                // we want to start local servers only.
+                // external servers are possible, but the user has to start (and take
+                // care) of them.
+                if ((s["address"].toString() == "localhost") ||
+                    (s["address"].toString() == "127.0.0.1")) {
 
-        qDebug() << "[Redis] Starting...\n"
-                 << redisStartCommand;
+                    // for starting local servers, we only need the Port and the number of
+                    // PHP child processes to spawn
+                    serversToStart.insert(s["port"].toString(),
+                                          s["phpchildren"].toString());
+                }
+            }
+        }
 
-        Processes::startDetached(redisStartCommand, args,
-                                 getServer("Redis")->workingDirectory);
+        if (serversToStart.count() == 0) {
+            qDebug() << "[PHP] Found no servers to start. Check your upstream "
+                        "configuration.";
+            qDebug() << "[PHP] At least one address must be localhost or 127.0.0.1.";
+        }
 
-        emit signalMainWindow_ServerStatusChange("Redis", true);
+        return serversToStart;
     }
 
-    void Servers::stopRedis()
+    void Servers::stopPHP()
     {
-        // if not installed, skip
-        if (!QFile().exists(getServer("Redis")->exe)) {
-            qDebug() << "[Redis] Is not installed. Skipping stop command.";
-            return;
+        phpRestart->cancel();
+        if (phpRestart->restoreUpstreams() && isServerRunning("Nginx")) {
+            reloadNginx();
         }
 
-        // if not running, skip
-        if (processes->getProcessState(getServer("Redis")->exe) ==
-            Processes::ProcessState::NotRunning) {
-            qDebug() << "[Redis] Not running... Skipping stop command.";
-            return;
+        /**
+   * All PHP processes are signalled first and share one grace period of
+   * "php/stoptimeout" ms to finish their requests, then they are killed.
+   *
+   * The pools ask their workers to exit. Other processes are workers of a
+   * previous session of the control panel or pools of the "spawn.exe" tool.
+   * The order is important: the spawner needs to be stopped before the PHP
+   * childs, otherwise it respawns them.
+   */
+
+        QList<qint64> pids;
+        foreach (FastCgiPool *pool, phpPools) {
+            pids << pool->shutdown();
         }
 
-        // build redis stop command
-        // Note: "-a password" is not supported, yet
-        QString const redisStopCommand =
-            QDir::currentPath() + "/bin/redis/redis-cli.exe";
+        ProcessSnapshot snapshot = Processes::snapshot();
+        QList<qint64> others;
 
-        QStringList args;
-        args << "-h " + settings->get("redis/bind", QVariant("127.0.0.1")).toString();
-        args << "-p " +
-                    settings->get("redis/port")
-                        .toString(); // , QVariant(QString('6379')).toString()
-        args << "shutdown";
+        foreach (const Process &p, snapshot.findAllByName("spawn")) {
+            others << p.pid;
+            foreach (const Process &child, snapshot.descendants(p.pid)) {
+                others << child.pid;
+            }
+        }
 
-        qDebug() << "[Redis] Stopping...\n";
+        foreach (const Process &p, snapshot.findAllByName("php-cgi")) {
+            if (!pids.contains(p.pid) && !others.contains(p.pid)) {
+                others << p.pid;
+            }
+        }
+
+        // without a graceful signal (Windows) the process is killed right away
+        foreach (qint64 pid, others) {
+            if (!Processes::signalProcess(pid, false)) {
+                Processes::signalProcess(pid, true);
+            }
+        }
+        pids << others;
 
-        Processes::start(redisStopCommand, args,
-                         getServer("Redis")->workingDirectory);
+        // the pools are gone: the exits complete the stop, see processExited()
+        foreach (FastCgiPool *pool, phpPools) {
+            pool->release();
+            delete pool;
+        }
+        phpPools.clear();
 
-        emit signalMainWindow_ServerStatusChange("Redis", false);
-    }
+        Processes::invalidateSnapshot();
 
-    void Servers::restartRedis()
-    {
-        stopRedis();
-        startRedis();
+        // the processes still running after the grace period are killed
+        ProcessWaiter *waiter = new ProcessWaiter(this);
+        connect(waiter, &ProcessWaiter::finished, this, [waiter](const QList<qint64> &stillRunning) {
+            foreach (qint64 pid, stillRunning) {
+                qDebug() << "[PHP] Grace period expired, killing pid:" << pid;
+                Processes::signalProcess(pid, true);
+            }
+            waiter->deleteLater();
+        });
+        waiter->start(pids, settings->get("php/stoptimeout", 3000).toInt());
     }
 
     /*
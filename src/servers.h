@@ -12,10 +12,22 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 
+#include "fastcgipool.h"
 #include "filehandling.h"
 #include "json.h"
+#include "logrotator.h"
+#include "readinessprobe.h"
+#include "rollingrestart.h"
+#include "serverdescriptors.h"
+#include "serverorchestrator.h"
+#include "serverversions.h"
 #include "settings.h"
+#include "src/logviewer/accessloganalyzer.h"
+#include "src/logviewer/errorlogaggregator.h"
 #include "src/processviewer/processes.h"
+#include "src/processviewer/processmonitor.h"
+#include "src/processviewer/processwaiter.h"
+#include "src/processviewer/resourcesampler.h"
 
 namespace Servers
 {
@@ -24,6 +36,19 @@ namespace Servers
         Q_OBJECT
 
     public:
+        // lifecycle of a server, see Servers::startServer() and stopServer()
+        enum State
+        {
+            Stopped,
+            Starting,
+            Ready,
+            Stopping,
+            Failed
+        };
+        Q_ENUM(State)
+
+        Server();
+
         QString lowercaseName;
         QString name;
         QIcon icon;
@@ -32,6 +57,26 @@ namespace Servers
         QString exe;
 
         QMenu *trayMenu;
+
+        State state;
+        QString stateReason; // why the server failed
+        bool restartPending;
+        QTimer deadline; // of Starting and Stopping
+        ReadinessProbe *probe; // of Starting, created on first use
+    };
+
+    /// Resource usage of a server, summed over its whole process tree.
+    struct ServerUsage
+    {
+        ServerUsage() : processCount(0), cpuPercent(0), memoryBytes(0), threadCount(0) {}
+
+        int processCount;
+        double cpuPercent; // 100 = one core busy
+        quint64 memoryBytes; // PSS (shared pages counted once), RSS where PSS is not available
+        quint32 threadCount;
+        QList<quint16> listeningPorts;
+
+        QString toString() const;
     };
 
     class Servers : public QObject
@@ -43,6 +88,13 @@ namespace Servers
         Servers(Processes *processes, QObject *parent = 0);
 
         Processes *processes;
+        ProcessMonitor *processMonitor;
+        ResourceSampler *resourceSampler;
+        ServerOrchestrator *orchestrator;
+        ServerVersions *versions;
+        LogRotator *logRotator;
+        AccessLogAnalyzer *accessLog;
+        ErrorLogAggregator *errorLogs;
         Settings::SettingsManager *settings;
 
         QList<Server *> servers() const;
@@ -50,11 +102,32 @@ namespace Servers
         QStringList getListOfServerNamesInstalled();
         QString getCamelCasedServerName(QString &serverName) const;
         Server *getServer(const QString &serverName) const;
+        Server *findServer(const QString &serverName) const;
+        Server *findServerOfProcess(const QString &processName) const;
+        Server::State getServerState(const QString &serverName) const;
+        bool isServerRunning(const QString &serverName) const;
+        QList<ProbeEndpoint> getProbeEndpoints(const QString &serverName);
         QString getExecutable(QString &serverName) const;
+        QString getPort(const QString &serverName) const;
 
         QStringList getLogFiles(QString &serverName) const;
 
-        void clearLogFile(const QString &serverName) const;
+        QStringList getProcessNames(const QString &serverName) const;
+        ServerUsage getServerUsage(const QString &serverName, const ProcessSnapshot &snapshot,
+                                   const PortTable &portTable) const;
+        QMap<QString, ServerUsage> getServersUsage() const;
+
+        void rotateLogFiles(const QString &serverName);
+
+        QList<FastCgiPool *> getPHPPools() const;
+        void replacePHPPool(FastCgiPool *oldPool, FastCgiPool *newPool);
+
+        static void writeNginxUpstreamConfigs(const QJsonDocument &jsonDoc);
+
+        // the commands of a server, without state tracking
+        void runStartCommand(ServerId id);
+        void runStopCommand(ServerId id);
+        void cleanupPostgreSQL();
 
     public slots:
 
@@ -64,41 +137,13 @@ namespace Servers
         // This slot action handles clicks on server commands in the tray menu.
         void mapAction(QAction *action);
 
-        // Nginx Action Slots
-        void startNginx();
-        void stopNginx();
-        void reloadNginx();
-        void restartNginx();
-
-        // PHP Action Slots
-        void startPHP();
-        void stopPHP();
-        void restartPHP();
-
-        // MariaDb Action Slots
-        void startMariaDb();
-        void stopMariaDb();
-        void restartMariaDb();
-
-        // MongoDB Action Slots
-        void startMongoDb();
-        void stopMongoDb();
-        void restartMongoDb();
+        // asynchronous start/stop with state tracking, see Server::State
+        void startServer(const QString &serverName);
+        void stopServer(const QString &serverName);
+        void restartServer(const QString &serverName);
 
-        // Memcached Action Slots
-        void startMemcached();
-        void stopMemcached();
-        void restartMemcached();
-
-        // PostgreSQL Action Slots
-        void startPostgreSQL();
-        void stopPostgreSQL();
-        void restartPostgreSQL();
-
-        // Redis Action Slots
-        void startRedis();
-        void stopRedis();
-        void restartRedis();
+        void reloadNginx();
+        void reopenLogs(const QString &serverName);
 
     signals:
         void signalMainWindow_ServerStatusChange(QString label, bool enabled);
@@ -106,10 +151,35 @@ namespace Servers
         void signalMainWindow_updateVersion(QString server);
         void signalMainWindow_updatePort(QString server);
 
+        void serverStateChanged(const QString &serverName, Server::State state);
+        // a problem of a running server, e.g. a failed rolling restart of PHP
+        void serverWarning(const QString &serverName, const QString &message);
+
+    private slots:
+        void processStarted(qint64 pid, const QString &exe);
+        void processExited(qint64 pid, int exitCode);
+        void probeReady(const QString &serverName, qint64 elapsedMs);
+        void probeFailed(const QString &serverName, const QString &reason);
+        void phpRestartFinished(bool success, const QString &reason);
+
     private:
         QList<Server *> serverList;
+        QList<FastCgiPool *> phpPools;
+        RollingRestart *phpRestart;
+
+        void setServerState(Server *server, Server::State state, const QString &reason = QString());
+        void deadlineExpired(Server *server);
+        bool startReadinessProbe(Server *server);
 
         QMap<QString, QString> getPHPServersFromNginxUpstreamConfig();
+        static void createNginxConfUpstreamFolderIfNotExists_And_clearOldConfigs();
+
+        QString expandCommand(const ServerDescriptor &d, const char *command) const;
+        void signalNginx(const QString &signal);
+        void startPHP();
+        void stopPHP();
+        bool isPHPPoolRunning() const;
+        void prepareMongoDb();
     };
 }
 #endif // SERVERS_H
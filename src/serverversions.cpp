@@ -0,0 +1,272 @@
+#include "serverversions.h"
+#include "json.h"
+#include "serverdescriptors.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QRegExp>
+#include <QTimer>
+
+namespace Servers
+{
+    ServerVersions::ServerVersions(QObject *parent) : QObject(parent), timeout(5000) { load(); }
+
+    /**
+     * The hard timeout of a single version detection.
+     */
+    void ServerVersions::setTimeout(int timeoutMs) { timeout = timeoutMs; }
+
+    /**
+     * Returns the cached version of the server.
+     * If the binary is new or changed, the detection is started and an empty
+     * string is returned. versionDetected() is emitted, when the version is
+     * known. An output without a version is cached as an empty version, so
+     * the binary isn't run again until it changes.
+     */
+    QString ServerVersions::version(const QString &serverName)
+    {
+        QString s = serverName.toLower();
+
+        if (executable(s).isEmpty()) {
+            qDebug() << "The function for fetching the version for " + s + " is not implemented, yet.";
+            return ":(";
+        }
+
+        Entry current = fingerprint(s);
+
+        // this happens only during testing
+        if (current.size < 0) {
+            return "0.0.0";
+        }
+
+        if (isCached(s, current)) {
+            return cache.value(s).version;
+        }
+
+        detect(QStringList() << serverName);
+
+        return QString();
+    }
+
+    /**
+     * Starts the detection of all servers, which are not cached.
+     * The detections run concurrently.
+     */
+    void ServerVersions::detect(const QStringList &serverNames)
+    {
+        foreach (const QString &serverName, serverNames) {
+            QString s = serverName.toLower();
+
+            Entry current = fingerprint(s);
+
+            if (executable(s).isEmpty() || current.size < 0 || running.contains(s) || isCached(s, current)) {
+                continue;
+            }
+
+            QProcess *process = new QProcess(this);
+            running.insert(s, process);
+
+            // nginx, mysqlcheck and php print the version to stderr
+            ServerId id = findDescriptor(s)->id;
+            if (id == ServerId::Nginx || id == ServerId::MariaDb || id == ServerId::PHP) {
+                process->setProcessChannelMode(QProcess::MergedChannels);
+            }
+
+            // the label and object name of the server, e.g. "Nginx"
+            QString name = findDescriptor(s)->name;
+
+            connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this,
+                    [this, s, name, process, current](int, QProcess::ExitStatus exitStatus) {
+                        running.remove(s);
+                        process->deleteLater();
+
+                        if (exitStatus != QProcess::NormalExit) {
+                            qDebug() << "[" + name + "] Version failed: timed out or crashed";
+                            return;
+                        }
+
+                        QString version = parseOutput(s, process->readAll());
+                        if (version.isEmpty()) {
+                            qDebug() << "[" + name + "] Version failed: no version in the output";
+                        }
+
+                        store(s, current, version);
+                        emit versionDetected(name, version);
+                    });
+
+            connect(process, &QProcess::errorOccurred, this,
+                    [this, s, name, process](QProcess::ProcessError error) {
+                        // all other errors are followed by finished()
+                        if (error != QProcess::FailedToStart) {
+                            return;
+                        }
+                        qDebug() << "[" + name + "] Version failed:" << process->errorString();
+                        running.remove(s);
+                        process->deleteLater();
+                    });
+
+            // hard timeout, the default of waitForFinished() would be 30 seconds
+            QTimer::singleShot(timeout, process, SLOT(kill()));
+
+            process->start(executable(s), arguments(s));
+        }
+    }
+
+    /**
+     * Converts a version string to the PHP_VERSION_ID format, e.g. "7.1.3" => 70103.
+     */
+    int ServerVersions::toVersionId(const QString &version)
+    {
+        QRegExp regex("^(\\d+)\\.(\\d+)\\.(\\d+)");
+
+        if (regex.indexIn(version) == -1) {
+            return 0;
+        }
+
+        return regex.cap(1).toInt() * 10000 + regex.cap(2).toInt() * 100 + regex.cap(3).toInt();
+    }
+
+    QString ServerVersions::parseVersionNumber(const QString &stringWithVersion)
+    {
+        // This RegExp matches version numbers: (\d+\.)?(\d+\.)?(\d+\.)?(\*|\d+)
+        // This is the same, but escaped:
+        QRegExp regex("(\\d+\\.)?(\\d+\\.)?(\\d+\\.)?(\\*|\\d+)");
+
+        regex.indexIn(stringWithVersion);
+
+        return regex.cap(0);
+    }
+
+    QString ServerVersions::cacheFile() { return "./bin/wpnxm-scp/version-cache.json"; }
+
+    QString ServerVersions::executable(const QString &serverName)
+    {
+        const ServerDescriptor *d = findDescriptor(serverName);
+        return d ? QString(d->versionProgram) : QString();
+    }
+
+    QStringList ServerVersions::arguments(const QString &serverName)
+    {
+        const ServerDescriptor *d = findDescriptor(serverName);
+        return d ? splitList(d->versionArguments) : QStringList();
+    }
+
+    QString ServerVersions::parseOutput(const QString &serverName, const QByteArray &output)
+    {
+        QString s = serverName.toLower();
+
+        qDebug() << "[" + serverName + "] Version: \n" << output;
+
+        QByteArray firstLine = output.left(output.indexOf('\n') + 1);
+        if (firstLine.isEmpty()) {
+            firstLine = output;
+        }
+
+        switch (findDescriptor(s)->id) {
+        case ServerId::MariaDb:
+            // ".\bin\mariadb\bin\mysqlcheck.exe  Ver 2.7.4-MariaDB Distrib 10.1.6-MariaDB, for Win64 (AMD64)"
+            // scrape second version number
+            return parseVersionNumber(output.mid(output.lastIndexOf("Distrib "), 15));
+        case ServerId::PHP: {
+            // "PHP 5.4.3 (cli) (built: Feb 29 2012 19:06:50)", "PHP 7.0.0alpha2 (cli)"
+            // - grab inside "PHP x (cli)"
+            // - "\\d.\\d.\\d." = grab "1.2.3"
+            // - "(\\w+\\d+)?" = grab optional "alpha2" version
+            QRegExp regex("PHP\\s(\\d.\\d.\\d.(\\w+\\d+)?)\\s\\(cli\\)");
+            regex.indexIn(output);
+            return regex.cap(1);
+        }
+        case ServerId::MongoDb:
+            return parseVersionNumber(firstLine.mid(3));
+        case ServerId::PostgreSQL:
+            return parseVersionNumber(output.mid(2));
+        case ServerId::Memcached:
+            return parseVersionNumber(firstLine.mid(2));
+        case ServerId::Redis:
+            // "Redis server v=2.8.21 sha"
+            return parseVersionNumber(firstLine);
+        case ServerId::Nginx:
+            break;
+        }
+
+        // "nginx version: nginx/1.2.1"
+        return parseVersionNumber(output);
+    }
+
+    ServerVersions::Entry ServerVersions::fingerprint(const QString &serverName) const
+    {
+        QFileInfo file(executable(serverName));
+
+        Entry entry;
+        entry.path = file.absoluteFilePath();
+        if (file.exists()) {
+            entry.size = file.size();
+            entry.modified = file.lastModified();
+        }
+        return entry;
+    }
+
+    bool ServerVersions::isCached(const QString &serverName, const Entry &current) const
+    {
+        QHash<QString, Entry>::const_iterator it = cache.constFind(serverName);
+
+        // an empty version is cached too: the output of this binary has none
+        return it != cache.constEnd() && it.value().path == current.path && it.value().size == current.size &&
+               it.value().modified == current.modified;
+    }
+
+    void ServerVersions::store(const QString &serverName, Entry entry, const QString &version)
+    {
+        entry.version = version;
+        cache.insert(serverName, entry);
+
+        // one write for a whole round of detections
+        if (running.isEmpty()) {
+            save();
+        }
+    }
+
+    void ServerVersions::load()
+    {
+        if (!QFileInfo(cacheFile()).exists()) {
+            return;
+        }
+
+        QJsonObject servers = File::JSON::load(cacheFile()).object()["servers"].toObject();
+
+        for (QJsonObject::const_iterator it = servers.constBegin(); it != servers.constEnd(); ++it) {
+            QJsonObject json = it.value().toObject();
+
+            Entry entry;
+            entry.path = json["path"].toString();
+            entry.size = qint64(json["size"].toDouble(-1));
+            entry.modified = QDateTime::fromMSecsSinceEpoch(qint64(json["mtime"].toDouble()));
+            entry.version = json["version"].toString();
+
+            cache.insert(it.key(), entry);
+        }
+    }
+
+    void ServerVersions::save() const
+    {
+        QJsonObject servers;
+
+        for (QHash<QString, Entry>::const_iterator it = cache.constBegin(); it != cache.constEnd(); ++it) {
+            QJsonObject json;
+            json["path"] = it.value().path;
+            json["size"] = double(it.value().size);
+            json["mtime"] = double(it.value().modified.toMSecsSinceEpoch());
+            json["version"] = it.value().version;
+
+            servers.insert(it.key(), json);
+        }
+
+        QJsonObject json;
+        json["servers"] = servers;
+
+        QDir().mkpath(QFileInfo(cacheFile()).absolutePath());
+        File::JSON::save(QJsonDocument(json), cacheFile());
+    }
+}
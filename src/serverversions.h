@@ -0,0 +1,73 @@
+#ifndef SERVERVERSIONS_H
+#define SERVERVERSIONS_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+namespace Servers
+{
+    /// Detects the versions of the server binaries and caches them.
+    /*!
+        The version of a server is scraped from the output of its binary
+        (e.g. "nginx -v"). The detection runs asynchronously, all servers
+        concurrently, each with a hard timeout.
+
+        The results are cached in "./bin/wpnxm-scp/version-cache.json", keyed
+        by the path, size and modification time of the binary. An unchanged
+        binary is never executed again, not even after a restart of the
+        control panel, not even when its output had no version.
+    */
+    class ServerVersions : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ServerVersions(QObject *parent = 0);
+
+        void setTimeout(int timeoutMs);
+
+        QString version(const QString &serverName);
+
+        static int toVersionId(const QString &version);
+        static QString parseVersionNumber(const QString &stringWithVersion);
+
+    public slots:
+        void detect(const QStringList &serverNames);
+
+    signals:
+        // "serverName" is the label name of the server, e.g. "Nginx"
+        void versionDetected(const QString &serverName, const QString &version);
+
+    private:
+        struct Entry
+        {
+            Entry() : size(-1) {}
+
+            QString path;
+            qint64 size;
+            QDateTime modified;
+            QString version;
+        };
+
+        QHash<QString, Entry> cache;
+        QHash<QString, QProcess *> running;
+        int timeout;
+
+        static QString cacheFile();
+        static QString executable(const QString &serverName);
+        static QStringList arguments(const QString &serverName);
+        static QString parseOutput(const QString &serverName, const QByteArray &output);
+
+        Entry fingerprint(const QString &serverName) const;
+        bool isCached(const QString &serverName, const Entry &current) const;
+        void store(const QString &serverName, Entry entry, const QString &version);
+
+        void load();
+        void save() const;
+    };
+}
+
+#endif // SERVERVERSIONS_H
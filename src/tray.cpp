@@ -66,6 +66,10 @@ namespace ServerControlPanel
         trayMenu->addSeparator();
         trayMenu->addAction(QIcon(":/gear"), tr("Manage Hosts"), this,
                             SLOT(openHostManagerDialog()), QKeySequence());
+        trayMenu->addAction(QIcon(":/gear"), tr("Access Log Statistics"), this,
+                            SLOT(openAccessLogDialog()), QKeySequence());
+        trayMenu->addAction(QIcon(":/gear"), tr("Error Log Summary"), this,
+                            SLOT(openErrorLogDialog()), QKeySequence());
         trayMenu->addAction(QIcon(":/gear"), tr("Webinterface"), this,
                             SLOT(goToWebinterface()), QKeySequence());
         trayMenu->addSeparator();
@@ -98,24 +102,20 @@ namespace ServerControlPanel
 
     void Tray::startAllServers()
     {
-        servers->startNginx();
-        servers->startPHP();
-        servers->startMariaDb();
-        servers->startMongoDb();
-        servers->startMemcached();
-        servers->startPostgreSQL();
-        servers->startRedis();
+        QStringList serverNames;
+        foreach (Servers::Server *server, servers->servers()) {
+            serverNames << server->name;
+        }
+        servers->orchestrator->startServers(serverNames);
     }
 
     void Tray::stopAllServers()
     {
-        servers->stopMariaDb();
-        servers->stopPHP();
-        servers->stopNginx();
-        servers->stopMongoDb();
-        servers->stopMemcached();
-        servers->stopPostgreSQL();
-        servers->stopRedis();
+        QStringList serverNames;
+        foreach (Servers::Server *server, servers->servers()) {
+            serverNames << server->name;
+        }
+        servers->orchestrator->stopServers(serverNames);
     }
 
     void Tray::openHostManagerDialog()
@@ -124,6 +124,18 @@ namespace ServerControlPanel
         dlg.exec();
     }
 
+    void Tray::openAccessLogDialog()
+    {
+        AccessLogDialog *dlg = new AccessLogDialog(servers->accessLog);
+        dlg->show();
+    }
+
+    void Tray::openErrorLogDialog()
+    {
+        ErrorLogDialog *dlg = new ErrorLogDialog(servers->errorLogs);
+        dlg->show();
+    }
+
     void Tray::timerEvent(QTimerEvent *event)
     {
         Q_UNUSED(event);
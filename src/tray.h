@@ -17,6 +17,8 @@
 #include <QHostAddress>
 
 #include "hostmanager/hostmanagerdialog.h"
+#include "logviewer/accesslogdialog.h"
+#include "logviewer/errorlogdialog.h"
 #include "networkutils.h"
 #include "servers.h"
 #include "settings.h"
@@ -51,6 +53,8 @@ namespace ServerControlPanel
         void goToReportIssue();
         void goToWebinterface();
         void openHostManagerDialog();
+        void openAccessLogDialog();
+        void openErrorLogDialog();
 
     private:
         void createTrayMenu();
@@ -76,6 +76,24 @@ HEADERS += \
     src/splashscreen.h \
     src/windowsapi.h \
     src/servers.h \
+    src/serverorchestrator.h \
+    src/readinessprobe.h \
+    src/serverversions.h \
+    src/serverdescriptors.h \
+    src/fastcgipool.h \
+    src/rollingrestart.h \
+    src/logrotator.h \
+    src/logviewer/accesslog.h \
+    src/logviewer/accessloganalyzer.h \
+    src/logviewer/accesslogdialog.h \
+    src/logviewer/errorlog.h \
+    src/logviewer/errorlogaggregator.h \
+    src/logviewer/errorlogdialog.h \
+    src/logviewer/heavyhitters.h \
+    src/logviewer/logfile.h \
+    src/logviewer/logmodel.h \
+    src/logviewer/logviewerdialog.h \
+    src/logviewer/sketches.h \
     src/cli.h \
     src/json.h \
     src/selfupdater.h \
@@ -91,8 +109,17 @@ HEADERS += \
     src/jobscheduler.h \
     src/csv.h \
     src/ini.h \
+    src/processviewer/porttable.h \
     src/processviewer/processes.h \
+    src/processviewer/processfilterproxymodel.h \
+    src/processviewer/processiconcache.h \
+    src/processviewer/processmodel.h \
+    src/processviewer/processmonitor.h \
+    src/processviewer/processsnapshot.h \
     src/processviewer/processviewerdialog.h \
+    src/processviewer/processwaiter.h \
+    src/processviewer/resourcesampler.h \
+    src/processviewer/ringbuffer.h \
     src/processviewer/alreadyusedportsdialog.h
 
 
@@ -115,6 +142,24 @@ SOURCES += \
     src/splashscreen.cpp \
     src/windowsapi.cpp \
     src/servers.cpp \
+    src/serverorchestrator.cpp \
+    src/readinessprobe.cpp \
+    src/serverversions.cpp \
+    src/serverdescriptors.cpp \
+    src/fastcgipool.cpp \
+    src/rollingrestart.cpp \
+    src/logrotator.cpp \
+    src/logviewer/accesslog.cpp \
+    src/logviewer/accessloganalyzer.cpp \
+    src/logviewer/accesslogdialog.cpp \
+    src/logviewer/errorlog.cpp \
+    src/logviewer/errorlogaggregator.cpp \
+    src/logviewer/errorlogdialog.cpp \
+    src/logviewer/heavyhitters.cpp \
+    src/logviewer/logfile.cpp \
+    src/logviewer/logmodel.cpp \
+    src/logviewer/logviewerdialog.cpp \
+    src/logviewer/sketches.cpp \
     src/cli.cpp \   
     src/json.cpp \
     src/selfupdater.cpp \
@@ -131,11 +176,26 @@ SOURCES += \
     src/jobscheduler.cpp \
     src/csv.cpp \    
     src/ini.cpp \
+    src/processviewer/porttable.cpp \
     src/processviewer/processes.cpp \
+    src/processviewer/processfilterproxymodel.cpp \
+    src/processviewer/processiconcache.cpp \
+    src/processviewer/processmodel.cpp \
+    src/processviewer/processmonitor.cpp \
+    src/processviewer/processsnapshot.cpp \
     src/processviewer/processviewerdialog.cpp \
+    src/processviewer/processwaiter.cpp \
+    src/processviewer/resourcesampler.cpp \
     src/processviewer/alreadyusedportsdialog.cpp
 
+# platform backends of the Processes API
+win32:SOURCES += src/processviewer/processes_win.cpp
+linux:SOURCES += src/processviewer/processes_linux.cpp
 
+# platform backends of the PHP pools (listen socket, workers)
+win32:SOURCES += src/fastcgipool_win.cpp
+linux:SOURCES += src/fastcgipool_linux.cpp
+win32:LIBS += -lws2_32
 
 RESOURCES += \
     src/resources/resources.qrc